@@ -1,14 +1,26 @@
 #include <iostream>
 #include "window.h"
 #include "grid.h"
+#include "cubeVerts.h"
 #include "shader.h"
 #include "camera.h"
 #include "texture.h"
+#include "navMesh.h"
+#include "pathPlanner.h"
+#include "navCache.h"
+#include "pathStore.h"
+#include "pathScheduler.h"
+#include "aStar.h"
+#include "clearance.h"
+#include "realTimeSearch.h"
 
 #include <chrono>
 #include <queue>
 #include <unordered_set>
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <cmath>
 
 float lastMoveTime = 0.0f;
 float moveInterval = 10.0f;
@@ -27,6 +39,8 @@ struct Player
     std::vector<unsigned int> m_indices;
 
     std::queue<glm::vec3> m_path;
+    //asked for the next waypoint whenever the path runs out, real time search hands out one step at a time
+    std::function<bool(glm::vec3&)> m_nextWaypoint;
 
     Player(glm::vec3 pos = glm::vec3(0.0f), float s = 1.0f)
         : m_position(pos)
@@ -65,9 +79,22 @@ struct Player
         glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0);
     }
 
+    //tops the path up from m_nextWaypoint, false when there is nowhere left to go
+    bool pullWaypoint()
+    {
+        if (!m_path.empty())
+            return true;
+        glm::vec3 next;
+        if (!m_nextWaypoint || !m_nextWaypoint(next))
+            return false;
+        m_path.push(next);
+        m_goal = next;
+        return true;
+    }
+
     void update(float dt)
     {
-        if (m_path.empty())
+        if (!pullWaypoint())
             return;
 
         glm::vec3 dir = m_goal - m_position;
@@ -75,7 +102,7 @@ struct Player
         if (dist < 0.05f)
         {
             m_path.pop();
-            if (!m_path.empty())
+            if (pullWaypoint())
             {
                 m_goal = m_path.front();
             }
@@ -150,117 +177,16 @@ struct SpotLight
     float moveStartTime;
 };
 
-
-struct Node
+//false when the floor has no free tile left for it
+bool spawnItem(Grid& grid, Item& item)
 {
-    int x;
-    int z;
-    float gCost = 0.0f;
-    float hCost = 0.0f;
-    float fCost = gCost + hCost;
-    Node* parent = nullptr;
-
-    Node(int x, int z)
-        : x(x)
-        , z(z) {}
-};
-
-namespace a_Star
-{
-    struct NodeCompare
-    {
-        bool operator()(const Node* a, const Node* b) const
-        {
-            return a->fCost > b->fCost;
-        }
-    };
-
-    float heuristic(const Node& a, const Node& b)
-    {
-        return abs(a.x - b.x) + abs(a.z - b.z);
-    }
-
-    std::vector<glm::vec2> findPath(Grid& grid, glm::vec2 start, glm::vec2 goal)
-    {
-        std::vector<Node*> openList;
-        std::vector<Node*> closedList;
-
-        Node* startNode = new Node(start.x, start.y);
-        Node* goalNode = new Node(goal.x, goal.y);
-        openList.push_back(startNode);
-
-        auto nodeExists = [](std::vector<Node*>& list, int x, int z) {
-            return std::any_of(list.begin(), list.end(), [&](Node* n) {
-                return n->x == x && n->z == z;
-                });
-            };
-
-        while (!openList.empty())
-        {
-            auto currentIt = std::min_element(openList.begin(), openList.end(),
-                [](Node* a, Node* b) {return a->fCost < b->fCost; });
-
-            Node* current = *currentIt;
-            openList.erase(currentIt);
-            closedList.push_back(current);
-
-            if (current->x == goalNode->x && current->z == goalNode->z)
-            {
-                std::vector<glm::vec2> path;
-                Node* temp = current;
-                while (temp)
-                {
-                    path.push_back(glm::vec2(temp->x, temp->z));
-                    temp = temp->parent;
-                }
-                std::reverse(path.begin(), path.end());
-                std::cout << "size of path: " << path.size();
-                return path;
-            }
-            std::vector<glm::ivec2> directions = { {1,0},{-1,0},{0,1},{0,-1} };
-            for (auto& dir : directions)
-            {
-                int nx = current->x + dir.x;
-                int nz = current->z + dir.y;
-
-                if (nx < 0 || nz < 0 || nx >= grid.getSize() || nz >= grid.getSize())
-                    continue;
-                if (nodeExists(closedList, nx, nz))
-                    continue;
-                if (grid.wall(nx, nz))
-                    continue;
-
-                Node* neighbor = new Node(nx, nz);
-                neighbor->gCost = current->gCost + 1;
-                neighbor->hCost = heuristic(*neighbor, *goalNode);
-                neighbor->parent = current;
-
-                if (!nodeExists(openList, nx, nz))
-                {
-                    openList.push_back(neighbor);
-                }
-            }
-        }
-        return {};
-    }
-}
-
-Item spawnItem(Grid& grid)
-{
-    int size = grid.getSize();
-
-    while (true)
-    {
-        int x = rand() % size;
-        int z = rand() % size;
-
-        if (!grid.wall(x, z))
-        {
-            glm::vec3 pos = grid.getTileWorldPos(x, z);
-            pos.y = 0.5f / 2.0f;
-            return Item(pos);
-        }
-    }
+    glm::ivec2 tile;
+    if (!grid.getWalkableTile(tile))
+        return false;
+    glm::vec3 pos = grid.getTileWorldPos(glm::vec2(tile));
+    pos.y = 0.5f / 2.0f;
+    item = Item(pos);
+    return true;
 }
 
 void updateSpotLights(float curTime, float dt, std::vector<SpotLight>& lights, Grid& grid)
@@ -270,7 +196,9 @@ void updateSpotLights(float curTime, float dt, std::vector<SpotLight>& lights, G
         lastMoveTime = curTime;
         for (int i = 1; i < lights.size(); i++)
         {
-            glm::ivec2 tile = grid.getWalkableTile();
+            glm::ivec2 tile;
+            if (!grid.getWalkableTile(tile))
+                continue;
             glm::vec3 pos = grid.getTileWorldPos(tile.x, tile.y);
             pos.y = 8.0f;
             lights[i].targetPos = pos;
@@ -312,8 +240,106 @@ int main()
     std::vector<SpotLight> spotlights;
     Player player;
 
-    Grid grid(0.5f);
+    const float tileSize = 0.5f;
+    Grid grid(tileSize);
     window.setGrid(&grid);
+    //the gnome covers a square of tiles hanging right and down from the one it stands on
+    const int playerUnit = std::max(1, (int)std::round(player.m_size / tileSize));
+    //preprocessing comes from the navcache when it was made for these walls, otherwise it is written once built
+    NavCache navCache;
+    const std::string navCachePath = NavCache::pathFor("assets/grid.txt");
+    bool warmCache = navCache.open(navCachePath, grid);
+    ClearanceMap clearance(grid, warmCache ? &navCache : nullptr);
+    //every worker plans on its own navmesh and planner, kept here for stats and wall edits
+    std::vector<std::shared_ptr<PathPlanner>> planners;
+    std::vector<std::shared_ptr<NavMesh>> navMeshes;
+    std::vector<std::shared_ptr<a_Star::AdaptiveSearch>> sizedSearches;
+    PathScheduler scheduler([&]() {
+        auto navMesh = std::make_shared<NavMesh>(grid, warmCache ? &navCache : nullptr);
+        auto planner = std::make_shared<PathPlanner>(grid, *navMesh, warmCache ? &navCache : nullptr);
+        auto sized = std::make_shared<a_Star::AdaptiveSearch>(grid);
+        sized->setClearance(&clearance);
+        planners.push_back(planner);
+        navMeshes.push_back(navMesh);
+        sizedSearches.push_back(sized);
+        //navmesh waypoints only keep a single tile off the walls, a wider gnome takes the sized grid search
+        return [navMesh, planner, sized, playerUnit](glm::vec2 start, glm::vec2 goal) {
+            if (playerUnit > 1)
+                return sized->findPath(start, goal, playerUnit);
+            return planner->findPath(start, goal);
+            };
+        }, 2);
+    if (!warmCache)
+    {
+        navMeshes[0]->save(navCache);
+        planners[0]->save(navCache);
+        clearance.save(navCache);
+        navCache.write(navCachePath, grid);
+    }
+    //the workers copied what they need
+    navCache.close();
+    int clicks = 0;
+    a_Star::NearestSearch nearestSearch(grid);
+    RealTimeSearch realTimeSearch(grid);
+    RealTimeSearch::Agent playerAgent;
+    bool realTimeMode = false;
+    PathStore pathStore;
+    PathStore::Cursor playerRoute;
+
+    //walls edited during a frame reach the engines once, after the workers let go of them
+    grid.journal().subscribe([&](const std::vector<GridJournal::DirtyRect>& rects, uint64_t) {
+        scheduler.waitIdle();
+        for (const GridJournal::DirtyRect& rect : rects)
+        {
+            if (rect.layer != grid.activeLayer())
+                continue;
+            //a whole new floor is one rebuild, not a patch per cell
+            if (rect.x0 == 0 && rect.z0 == 0 && rect.x1 == grid.getSize() - 1 && rect.z1 == grid.getSize() - 1)
+            {
+                clearance.build();
+                for (size_t i = 0; i < planners.size(); i++)
+                {
+                    navMeshes[i]->build();
+                    planners[i]->build();
+                    sizedSearches[i]->reset();
+                }
+                realTimeSearch.reset();
+                continue;
+            }
+            for (int z = rect.z0; z <= rect.z1; z++)
+            {
+                for (int x = rect.x0; x <= rect.x1; x++)
+                {
+                    clearance.onWallChanged(x, z);
+                    for (size_t i = 0; i < planners.size(); i++)
+                    {
+                        navMeshes[i]->onWallChanged(x, z);
+                        planners[i]->onWallChanged(x, z);
+                        sizedSearches[i]->onWallChanged(x, z);
+                    }
+                    realTimeSearch.onWallChanged(x, z);
+                }
+            }
+        }
+        });
+
+    //the player only keeps an id, waypoints are turned into world positions as it reaches them
+    auto followPath = [&](const std::vector<glm::vec2>& path) {
+        pathStore.release(playerRoute.id);
+        playerRoute = pathStore.begin(pathStore.store(path));
+        player.m_path = std::queue<glm::vec3>();
+        player.m_nextWaypoint = [&](glm::vec3& next) {
+            glm::vec2 tile;
+            if (!pathStore.next(playerRoute, tile))
+            {
+                pathStore.release(playerRoute.id);
+                playerRoute = PathStore::Cursor();
+                return false;
+            }
+            next = grid.getTileWorldPos(tile);
+            return true;
+            };
+        };
 
     player.m_position = grid.getTileWorldPos(0, 0);
     player.m_goal = grid.getTileWorldPos(0, 0);
@@ -329,21 +355,35 @@ int main()
     window.setTileCallback([&](int x, int z) {
         glm::vec2 start = grid.getTileIndex(player.m_position);
         glm::vec2 goal = glm::vec2(x, z);
+        int click = ++clicks;
 
-        std::vector<glm::vec2> path = a_Star::findPath(grid, start, goal);
-
-        std::queue<glm::vec3> pathW;
-        for (auto& tile : path)
-        {
-            glm::vec3 world = grid.getTileWorldPos(tile.x, tile.y);
-            pathW.push(world);
-        }
-
-        if (!pathW.empty())
+        if (realTimeMode)
         {
-            player.m_path = pathW;
+            //no full path, the player takes a step per lookahead starting from the tile it is on
+            pathStore.release(playerRoute.id);
+            playerRoute = PathStore::Cursor();
+            playerAgent.tile = start;
+            playerAgent.goal = goal;
+            playerAgent.plan.clear();
+            player.m_path = std::queue<glm::vec3>();
+            player.m_path.push(grid.getTileWorldPos(start.x, start.y));
             player.m_goal = player.m_path.front();
+            player.m_nextWaypoint = [&](glm::vec3& next) {
+                if (!realTimeSearch.advance(playerAgent))
+                    return false;
+                next = grid.getTileWorldPos(playerAgent.tile.x, playerAgent.tile.y);
+                return true;
+                };
+            return;
         }
+
+        //a click that was overtaken by a newer one is ignored when it comes back
+        scheduler.submit(PathScheduler::PLAYER, start, goal, 0.05f, [&, click](bool ok, const std::vector<glm::vec2>& path) {
+            if (ok && click == clicks && !path.empty())
+            {
+                followPath(path);
+            }
+            });
         });
 
     unsigned int gridTex = loadTexture("assets/textures/ground.png", false);
@@ -357,11 +397,12 @@ int main()
     success = MODEL_LOADING::loadModel("assets/models/wall.fbx", grid.getWallVerts(), grid.getWallIndices());
     grid.create();
 
-    srand(time(NULL));
     std::vector<Item> items;
     for (int i = 0; i < 5; i++)
     {
-        Item item = spawnItem(grid);
+        Item item;
+        if (!spawnItem(grid, item))
+            break;
         success = MODEL_LOADING::loadModel("assets/models/wall.fbx", item.m_vertices, item.m_indices);
         item.create();
         items.push_back(item);
@@ -370,7 +411,9 @@ int main()
     for (int i = 1; i < 3; i++)
     {
         SpotLight light;
-        glm::vec2 tile = grid.getWalkableTile();
+        glm::ivec2 tile;
+        if (!grid.getWalkableTile(tile))
+            break;
         light.m_position = grid.getTileWorldPos(tile.x, tile.y) + glm::vec3(0.0, 8.0f, 0.0);
         light.m_color = glm::vec3(1.0f, 1.0f, 0.3);
         light.targetPos = light.m_position;
@@ -423,6 +466,36 @@ int main()
         }
 
         camera.update();
+        grid.journal().flush();
+        scheduler.poll();
+
+        //space routes the player to the closest collectible
+        static bool spaceWasDown = false;
+        bool spaceDown = glfwGetKey(window.getWindow(), GLFW_KEY_SPACE) == GLFW_PRESS;
+        if (spaceDown && !spaceWasDown)
+        {
+            std::vector<glm::vec2> itemTiles;
+            for (auto& item : items)
+            {
+                itemTiles.push_back(grid.getTileIndex(item.m_position));
+            }
+
+            std::vector<glm::vec2> path;
+            if (nearestSearch.findNearest(grid.getTileIndex(player.m_position), itemTiles, path) >= 0)
+            {
+                followPath(path);
+            }
+        }
+        spaceWasDown = spaceDown;
+
+        //r switches clicks between full paths and real time search
+        static bool rWasDown = false;
+        bool rDown = glfwGetKey(window.getWindow(), GLFW_KEY_R) == GLFW_PRESS;
+        if (rDown && !rWasDown)
+        {
+            realTimeMode = !realTimeMode;
+        }
+        rWasDown = rDown;
 
 
         float total = 0.0f;
@@ -488,8 +561,9 @@ int main()
             if (distBetweenPlayerAndItem < item.m_pickupRadius)
             {
                 player.m_score += 1;
-                glm::vec2 pos = grid.getWalkableTile();
-                item.m_position = grid.getTileWorldPos(pos.x, pos.y);
+                glm::ivec2 tile;
+                if (grid.getWalkableTile(tile))
+                    item.m_position = grid.getTileWorldPos(tile.x, tile.y);
             }
             item.m_rotation += 90.0f * dt;
             if (item.m_rotation > 360.0f)
@@ -552,4 +626,10 @@ int main()
         window.pollEvents();
         window.swapBuffers();
     }
+
+    scheduler.printStats();
+    for (auto& planner : planners)
+    {
+        planner->printStats();
+    }
 }
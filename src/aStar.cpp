@@ -0,0 +1,588 @@
+#include "aStar.h"
+#include "grid.h"
+#include "deadEnds.h"
+#include "clearance.h"
+#include "gridVersions.h"
+
+#include <algorithm>
+#include <queue>
+#include <limits>
+
+namespace a_Star
+{
+    float heuristic(const Node& a, const Node& b)
+    {
+        return abs(a.x - b.x) + abs(a.z - b.z);
+    }
+
+    std::vector<glm::vec2> findPath(Grid& grid, glm::vec2 start, glm::vec2 goal)
+    {
+        int size = grid.getSize();
+        if (start.x < 0 || start.y < 0 || goal.x < 0 || goal.y < 0 || start.x >= size || start.y >= size || goal.x >= size || goal.y >= size)
+            return {};
+        if (grid.wall((int)start.x, (int)start.y) || grid.wall((int)goal.x, (int)goal.y))
+            return {};
+
+        std::vector<Node*> openList;
+        std::vector<Node*> closedList;
+
+        Node* startNode = new Node(start.x, start.y);
+        Node* goalNode = new Node(goal.x, goal.y);
+        openList.push_back(startNode);
+
+        auto nodeExists = [](std::vector<Node*>& list, int x, int z) {
+            return std::any_of(list.begin(), list.end(), [&](Node* n) {
+                return n->x == x && n->z == z;
+                });
+            };
+
+        while (!openList.empty())
+        {
+            auto currentIt = std::min_element(openList.begin(), openList.end(),
+                [](Node* a, Node* b) {return a->fCost < b->fCost; });
+
+            Node* current = *currentIt;
+            openList.erase(currentIt);
+            closedList.push_back(current);
+
+            if (current->x == goalNode->x && current->z == goalNode->z)
+            {
+                std::vector<glm::vec2> path;
+                Node* temp = current;
+                while (temp)
+                {
+                    path.push_back(glm::vec2(temp->x, temp->z));
+                    temp = temp->parent;
+                }
+                std::reverse(path.begin(), path.end());
+                return path;
+            }
+            std::vector<glm::ivec2> directions = { {1,0},{-1,0},{0,1},{0,-1} };
+            for (auto& dir : directions)
+            {
+                int nx = current->x + dir.x;
+                int nz = current->z + dir.y;
+
+                if (nx < 0 || nz < 0 || nx >= grid.getSize() || nz >= grid.getSize())
+                    continue;
+                if (nodeExists(closedList, nx, nz))
+                    continue;
+                if (grid.wall(nx, nz))
+                    continue;
+
+                Node* neighbor = new Node(nx, nz);
+                neighbor->gCost = current->gCost + 1;
+                neighbor->hCost = heuristic(*neighbor, *goalNode);
+                neighbor->parent = current;
+
+                if (!nodeExists(openList, nx, nz))
+                {
+                    openList.push_back(neighbor);
+                }
+            }
+        }
+        return {};
+    }
+
+    AdaptiveSearch::AdaptiveSearch(Grid& grid)
+        : m_grid(grid)
+    {
+        reset();
+    }
+
+    void AdaptiveSearch::reset()
+    {
+        m_size = m_grid.getSize();
+        //dense scratch is allocated on the first search that wants it, learned h only if it fits
+        m_dense = DenseSearchState();
+        m_h.clear();
+        m_hDelta.clear();
+        m_hValid.clear();
+        if (fitsDense())
+        {
+            size_t cells = (size_t)m_size * m_size;
+            m_h.assign(cells, 0);
+            m_hDelta.assign(cells, 0);
+            m_hValid.assign(cells, 0);
+        }
+        m_goal = -1;
+        m_totalDelta = 0;
+        m_stats = Stats();
+    }
+
+    bool AdaptiveSearch::fitsDense() const
+    {
+        size_t perCell = DenseSearchState::BYTES_PER_CELL + 2 * sizeof(int) + 1;
+        return (size_t)m_size * m_size * perCell <= m_denseBudget;
+    }
+
+    AdaptiveSearch::Backend AdaptiveSearch::chooseBackend(int64_t extent)
+    {
+        //dense once it exists, stamps make it free to reuse, and for anything too big for a hash map
+        bool dense = m_backend == Backend::DENSE
+            || (m_backend == Backend::AUTO && fitsDense() && (!m_dense.empty() || extent > SPARSE_EXTENT));
+        if (!dense)
+            return Backend::SPARSE;
+        if (m_dense.empty())
+            m_dense.resize((size_t)m_size * m_size);
+        return Backend::DENSE;
+    }
+
+    int AdaptiveSearch::manhattan(int64_t cell) const
+    {
+        return (int)(std::abs(cell % m_size - m_goal % m_size) + std::abs(cell / m_size - m_goal / m_size));
+    }
+
+    int AdaptiveSearch::hValue(int64_t cell) const
+    {
+        int h = manhattan(cell);
+        if (m_learn && !m_hValid.empty() && m_hValid[cell])
+        {
+            //learned value minus every goal correction made since it was written
+            h = std::max(h, m_h[cell] - (m_totalDelta - m_hDelta[cell]));
+        }
+        return h;
+    }
+
+    void AdaptiveSearch::setH(int64_t cell, int value)
+    {
+        m_h[cell] = value;
+        m_hDelta[cell] = m_totalDelta;
+        m_hValid[cell] = 1;
+    }
+
+    std::vector<glm::vec2> AdaptiveSearch::findPath(glm::vec2 start, glm::vec2 goal, int unitSize)
+    {
+        m_lastExpanded = 0;
+        m_lastHeapOps = 0;
+        int sx = (int)start.x, sz = (int)start.y;
+        int gx = (int)goal.x, gz = (int)goal.y;
+        if (sx < 0 || sz < 0 || gx < 0 || gz < 0 || sx >= m_size || sz >= m_size || gx >= m_size || gz >= m_size)
+            return {};
+        if (m_grid.wall(sx, sz) || m_grid.wall(gx, gz))
+            return {};
+        //big units only walk cells their whole square fits on
+        const bool sized = unitSize > 1 && m_clearance;
+        if (sized && (!m_clearance->fits(sx, sz, unitSize) || !m_clearance->fits(gx, gz, unitSize)))
+            return {};
+        //learned h and pockets both assume a 1x1 unit, h from the full grid is still admissible here.
+        //a pruned search measures distances without the pockets, learning them would overestimate
+        //for a later query that opens one, so it only reads h
+        DeadEnds* deadEnds = sized ? nullptr : m_deadEnds;
+        const bool learn = m_learn && !sized && !deadEnds && !m_h.empty();
+
+        int64_t startCell = (int64_t)sz * m_size + sx;
+        int64_t goalCell = (int64_t)gz * m_size + gx;
+        if (goalCell != m_goal)
+        {
+            //goal moved, h stays consistent if every learned value drops by h(new goal)
+            if (m_goal >= 0 && m_learn)
+                m_totalDelta += hValue(goalCell);
+            m_goal = goalCell;
+        }
+        if (deadEnds)
+            deadEnds->beginQuery(start, goal);
+
+        m_stats.searches++;
+        std::vector<glm::vec2> path;
+        int64_t distance = std::abs(sx - gx) + std::abs(sz - gz);
+        m_lastBackend = chooseBackend(distance * distance);
+        if (m_lastBackend == Backend::DENSE)
+        {
+            m_dense.begin();
+            search(m_dense, startCell, goalCell, sized ? unitSize : 1, learn, deadEnds, path);
+        }
+        else
+        {
+            m_sparse.begin((size_t)std::min<int64_t>(distance * distance, SPARSE_EXTENT));
+            search(m_sparse, startCell, goalCell, sized ? unitSize : 1, learn, deadEnds, path);
+            //manhattan distance says little in mazes, a search that touched this much was worth dense
+            if (m_backend == Backend::AUTO && fitsDense() && m_sparse.touched() > SPARSE_EXTENT)
+                m_dense.resize((size_t)m_size * m_size);
+        }
+        m_stats.expanded += m_lastExpanded;
+        return path;
+    }
+
+    template <typename State>
+    void AdaptiveSearch::search(State& state, int64_t startCell, int64_t goalCell, int unitSize, bool learn, DeadEnds* deadEnds, std::vector<glm::vec2>& path)
+    {
+        m_closedList.clear();
+
+        struct OpenItem
+        {
+            int f;
+            int g;
+            int64_t cell;
+            bool operator>(const OpenItem& o) const
+            {
+                //ties go to the deeper node, it is closer to the goal
+                return f > o.f || (f == o.f && g < o.g);
+            }
+        };
+        std::priority_queue<OpenItem, std::vector<OpenItem>, std::greater<OpenItem>> open;
+
+        state.insert(startCell) = { 0, false, -1 };
+        open.push({ hValue(startCell), 0, startCell });
+        m_lastHeapOps++;
+
+        const int dx[4] = { 1, -1, 0, 0 };
+        const int dz[4] = { 0, 0, 1, -1 };
+        bool found = false;
+        while (!open.empty())
+        {
+            OpenItem item = open.top();
+            open.pop();
+            m_lastHeapOps++;
+            int64_t cell = item.cell;
+            SearchEntry* entry = state.find(cell);
+            if (entry->closed || item.g != entry->g)
+                continue;
+
+            entry->closed = true;
+            m_closedList.push_back(cell);
+            m_lastExpanded++;
+
+            if (cell == goalCell)
+            {
+                found = true;
+                break;
+            }
+
+            int x = (int)(cell % m_size);
+            int z = (int)(cell / m_size);
+            int g = entry->g + 1;
+            for (int i = 0; i < 4; i++)
+            {
+                int nx = x + dx[i];
+                int nz = z + dz[i];
+                if (nx < 0 || nz < 0 || nx >= m_size || nz >= m_size)
+                    continue;
+                if (m_grid.wall(nx, nz))
+                    continue;
+                if (unitSize > 1 && !m_clearance->fits(nx, nz, unitSize))
+                    continue;
+                if (deadEnds && deadEnds->skip(nx, nz))
+                    continue;
+
+                int64_t next = (int64_t)nz * m_size + nx;
+                SearchEntry* seen = state.find(next);
+                if (seen && (seen->closed || g >= seen->g))
+                    continue;
+                if (!seen)
+                    seen = &state.insert(next);
+                *seen = { g, false, cell };
+                open.push({ g + hValue(next), g, next });
+                m_lastHeapOps++;
+            }
+        }
+
+        if (!found)
+            return;
+
+        if (learn)
+        {
+            int cost = state.find(goalCell)->g;
+            for (int64_t cell : m_closedList)
+            {
+                setH(cell, cost - state.find(cell)->g);
+            }
+        }
+
+        for (int64_t cell = goalCell; cell != -1; cell = state.find(cell)->parent)
+        {
+            path.push_back(glm::vec2(cell % m_size, cell / m_size));
+        }
+        std::reverse(path.begin(), path.end());
+    }
+
+    void AdaptiveSearch::onWallChanged(int x, int z)
+    {
+        //new walls only make paths longer, learned values stay admissible
+        if (!m_learn || m_h.empty() || m_goal < 0 || m_grid.wall(x, z))
+            return;
+
+        //a freed cell adds shortcuts, pull h down until it is consistent again
+        const int dx[4] = { 1, -1, 0, 0 };
+        const int dz[4] = { 0, 0, 1, -1 };
+        int64_t cell = (int64_t)z * m_size + x;
+        int h = hValue(cell);
+        for (int i = 0; i < 4; i++)
+        {
+            int nx = x + dx[i];
+            int nz = z + dz[i];
+            if (nx < 0 || nz < 0 || nx >= m_size || nz >= m_size || m_grid.wall(nx, nz))
+                continue;
+            h = std::min(h, hValue((int64_t)nz * m_size + nx) + 1);
+        }
+        setH(cell, h);
+
+        using QueueItem = std::pair<int, int64_t>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> open;
+        open.push({ h, cell });
+        while (!open.empty())
+        {
+            auto [value, current] = open.top();
+            open.pop();
+            if (value != hValue(current))
+                continue;
+
+            int cx = (int)(current % m_size);
+            int cz = (int)(current / m_size);
+            for (int i = 0; i < 4; i++)
+            {
+                int nx = cx + dx[i];
+                int nz = cz + dz[i];
+                if (nx < 0 || nz < 0 || nx >= m_size || nz >= m_size || m_grid.wall(nx, nz))
+                    continue;
+
+                int64_t next = (int64_t)nz * m_size + nx;
+                if (hValue(next) > value + 1)
+                {
+                    setH(next, value + 1);
+                    open.push({ value + 1, next });
+                }
+            }
+        }
+    }
+
+    NearestSearch::NearestSearch(Grid& grid)
+        : m_grid(grid)
+    {
+        reset();
+    }
+
+    void NearestSearch::reset()
+    {
+        m_size = m_grid.getSize();
+        size_t cells = (size_t)m_size * m_size;
+        m_g.assign(cells, 0);
+        m_parent.assign(cells, -1);
+        m_origin.assign(cells, -1);
+        m_generated.assign(cells, 0);
+        m_closed.assign(cells, 0);
+        m_searchId = 0;
+    }
+
+    int NearestSearch::findNearest(glm::vec2 start, const std::vector<glm::vec2>& goals, std::vector<glm::vec2>& path)
+    {
+        path.clear();
+        m_lastExpanded = 0;
+        m_lastHeapOps = 0;
+        int sx = (int)start.x, sz = (int)start.y;
+        if (sx < 0 || sz < 0 || sx >= m_size || sz >= m_size || m_grid.wall(sx, sz))
+            return -1;
+
+        int64_t startCell = (int64_t)sz * m_size + sx;
+        m_searchId++;
+
+        struct OpenItem
+        {
+            int f;
+            int g;
+            int64_t cell;
+            bool operator>(const OpenItem& o) const
+            {
+                return f > o.f || (f == o.f && g < o.g);
+            }
+        };
+        std::priority_queue<OpenItem, std::vector<OpenItem>, std::greater<OpenItem>> open;
+
+        for (int i = 0; i < (int)goals.size(); i++)
+        {
+            int gx = (int)goals[i].x, gz = (int)goals[i].y;
+            if (gx < 0 || gz < 0 || gx >= m_size || gz >= m_size || m_grid.wall(gx, gz))
+                continue;
+
+            int64_t cell = (int64_t)gz * m_size + gx;
+            if (m_generated[cell] == m_searchId)
+                continue;
+            m_generated[cell] = m_searchId;
+            m_g[cell] = 0;
+            m_parent[cell] = -1;
+            m_origin[cell] = i;
+            open.push({ abs(gx - sx) + abs(gz - sz), 0, cell });
+            m_lastHeapOps++;
+        }
+
+        const int dx[4] = { 1, -1, 0, 0 };
+        const int dz[4] = { 0, 0, 1, -1 };
+        while (!open.empty())
+        {
+            OpenItem item = open.top();
+            open.pop();
+            m_lastHeapOps++;
+            int64_t cell = item.cell;
+            if (m_closed[cell] == m_searchId || item.g != m_g[cell])
+                continue;
+
+            m_closed[cell] = m_searchId;
+            m_lastExpanded++;
+
+            if (cell == startCell)
+            {
+                //parents point towards the goal, so walking them gives start -> goal
+                for (int64_t c = startCell; c != -1; c = m_parent[c])
+                {
+                    path.push_back(glm::vec2(c % m_size, c / m_size));
+                }
+                return m_origin[startCell];
+            }
+
+            int x = (int)(cell % m_size);
+            int z = (int)(cell / m_size);
+            for (int i = 0; i < 4; i++)
+            {
+                int nx = x + dx[i];
+                int nz = z + dz[i];
+                if (nx < 0 || nz < 0 || nx >= m_size || nz >= m_size)
+                    continue;
+                if (m_grid.wall(nx, nz))
+                    continue;
+
+                int64_t next = (int64_t)nz * m_size + nx;
+                if (m_closed[next] == m_searchId)
+                    continue;
+
+                int g = m_g[cell] + 1;
+                if (m_generated[next] != m_searchId || g < m_g[next])
+                {
+                    m_generated[next] = m_searchId;
+                    m_g[next] = g;
+                    m_parent[next] = cell;
+                    m_origin[next] = m_origin[cell];
+                    open.push({ g + abs(nx - sx) + abs(nz - sz), g, next });
+                    m_lastHeapOps++;
+                }
+            }
+        }
+        return -1;
+    }
+
+    SnapshotSearch::SnapshotSearch(GridVersions& versions)
+        : m_versions(versions)
+    {
+        m_size = m_versions.getSize();
+        size_t cells = (size_t)m_size * m_size;
+        m_g.assign(cells, 0);
+        m_parent.assign(cells, -1);
+        m_generated.assign(cells, 0);
+        m_closed.assign(cells, 0);
+    }
+
+    std::vector<glm::vec2> SnapshotSearch::findPath(glm::vec2 start, glm::vec2 goal)
+    {
+        GridVersions::Pin pin = m_versions.pin();
+        const GridSnapshot& grid = *pin;
+        m_lastVersion = grid.version();
+        m_lastExpanded = 0;
+        m_lastHeapOps = 0;
+        int sx = (int)start.x, sz = (int)start.y;
+        int gx = (int)goal.x, gz = (int)goal.y;
+        if (sx < 0 || sz < 0 || gx < 0 || gz < 0 || sx >= m_size || sz >= m_size || gx >= m_size || gz >= m_size)
+            return {};
+        if (grid.wall(sx, sz) || grid.wall(gx, gz))
+            return {};
+
+        int64_t startCell = (int64_t)sz * m_size + sx;
+        int64_t goalCell = (int64_t)gz * m_size + gx;
+        auto h = [&](int64_t cell) {
+            return abs((int)(cell % m_size) - gx) + abs((int)(cell / m_size) - gz);
+            };
+
+        struct OpenItem
+        {
+            int f;
+            int g;
+            int64_t cell;
+            bool operator>(const OpenItem& o) const
+            {
+                return f > o.f || (f == o.f && g < o.g);
+            }
+        };
+        std::priority_queue<OpenItem, std::vector<OpenItem>, std::greater<OpenItem>> open;
+
+        m_searchId++;
+        m_g[startCell] = 0;
+        m_parent[startCell] = -1;
+        m_generated[startCell] = m_searchId;
+        open.push({ h(startCell), 0, startCell });
+        m_lastHeapOps++;
+
+        const int dx[4] = { 1, -1, 0, 0 };
+        const int dz[4] = { 0, 0, 1, -1 };
+        bool found = false;
+        while (!open.empty())
+        {
+            OpenItem item = open.top();
+            open.pop();
+            m_lastHeapOps++;
+            int64_t cell = item.cell;
+            if (m_closed[cell] == m_searchId || item.g != m_g[cell])
+                continue;
+            m_closed[cell] = m_searchId;
+            m_lastExpanded++;
+            if (cell == goalCell)
+            {
+                found = true;
+                break;
+            }
+
+            int x = (int)(cell % m_size);
+            int z = (int)(cell / m_size);
+            for (int i = 0; i < 4; i++)
+            {
+                int nx = x + dx[i];
+                int nz = z + dz[i];
+                if (nx < 0 || nz < 0 || nx >= m_size || nz >= m_size || grid.wall(nx, nz))
+                    continue;
+                int64_t next = (int64_t)nz * m_size + nx;
+                if (m_closed[next] == m_searchId)
+                    continue;
+                int g = m_g[cell] + 1;
+                if (m_generated[next] != m_searchId || g < m_g[next])
+                {
+                    m_generated[next] = m_searchId;
+                    m_g[next] = g;
+                    m_parent[next] = cell;
+                    open.push({ g + h(next), g, next });
+                    m_lastHeapOps++;
+                }
+            }
+        }
+        if (!found)
+            return {};
+
+        std::vector<glm::vec2> path;
+        for (int64_t cell = goalCell; cell != -1; cell = m_parent[cell])
+        {
+            path.push_back(glm::vec2(cell % m_size, cell / m_size));
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    SessionReport replaySession(Grid& grid, const std::vector<SessionQuery>& session)
+    {
+        AdaptiveSearch plain(grid);
+        plain.setLearning(false);
+        AdaptiveSearch adaptive(grid);
+
+        SessionReport report;
+        for (const SessionQuery& query : session)
+        {
+            for (const glm::ivec3& edit : query.wallEdits)
+            {
+                grid.setWall(edit.x, edit.y, edit.z != 0);
+                adaptive.onWallChanged(edit.x, edit.y);
+            }
+
+            plain.findPath(query.start, query.goal);
+            adaptive.findPath(query.start, query.goal);
+            report.queries++;
+        }
+        report.plainExpanded = plain.stats().expanded;
+        report.adaptiveExpanded = adaptive.stats().expanded;
+        return report;
+    }
+}
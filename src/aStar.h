@@ -0,0 +1,202 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "searchState.h"
+
+class Grid;
+class DeadEnds;
+class ClearanceMap;
+class GridVersions;
+
+struct Node
+{
+    int x;
+    int z;
+    float gCost = 0.0f;
+    float hCost = 0.0f;
+    float fCost = gCost + hCost;
+    Node* parent = nullptr;
+
+    Node(int x, int z)
+        : x(x)
+        , z(z) {}
+};
+
+namespace a_Star
+{
+    struct NodeCompare
+    {
+        bool operator()(const Node* a, const Node* b) const
+        {
+            return a->fCost > b->fCost;
+        }
+    };
+
+    float heuristic(const Node& a, const Node& b);
+    std::vector<glm::vec2> findPath(Grid& grid, glm::vec2 start, glm::vec2 goal);
+
+    /*
+        Generalized Adaptive A*.
+        After every search the h-values of expanded cells are raised to goal cost - g,
+        so later searches over the same terrain expand fewer cells.
+        Goal moves are handled lazily by subtracting the learned h of the new goal,
+        freed cells repair consistency locally in onWallChanged.
+
+        Search scratch is dense per cell arrays or a sparse hash map (searchState.h). AUTO takes
+        dense when the map fits the dense budget and the query looks long enough to be worth it,
+        or once a sparse search touched more than SPARSE_EXTENT cells. Once allocated the dense
+        arrays are always used. Maps over the budget search sparse and don't learn, the learned h
+        would be a dense array too. Neither do searches with pruning on, a distance around skipped
+        pockets can be too long for a later query whose start or goal opens them.
+    */
+    class AdaptiveSearch
+    {
+    public:
+        struct Stats
+        {
+            long long searches = 0;
+            long long expanded = 0;
+        };
+
+        enum class Backend
+        {
+            AUTO,
+            DENSE,
+            SPARSE
+        };
+
+        //AUTO goes dense for queries with a longer manhattan distance squared, or after a sparse search touched more cells
+        static constexpr int64_t SPARSE_EXTENT = 1 << 16;
+
+        AdaptiveSearch(Grid& grid);
+        void reset();
+        //when false this is a plain A* with manhattan heuristic, handy for comparisons
+        void setLearning(bool learn) { m_learn = learn; }
+        //skip dead end pockets that can't be on the path, nullptr turns it off.
+        //pruned searches don't learn, they still use h learned before
+        void setPruning(DeadEnds* deadEnds) { m_deadEnds = deadEnds; }
+        //needed for unitSize > 1, without it every unit is treated as 1x1
+        void setClearance(const ClearanceMap* clearance) { m_clearance = clearance; }
+        //unitSize is the side of the square the unit covers, its top left tile is the one at start/goal
+        std::vector<glm::vec2> findPath(glm::vec2 start, glm::vec2 goal, int unitSize = 1);
+        //call after Grid::setWall
+        void onWallChanged(int x, int z);
+        void setBackend(Backend backend) { m_backend = backend; }
+        //bytes the dense scratch and learned h may take, call reset() after changing it
+        void setDenseBudget(size_t bytes) { m_denseBudget = bytes; }
+
+        int lastExpanded() const { return m_lastExpanded; }
+        //pushes plus pops on the open list
+        int lastHeapOps() const { return m_lastHeapOps; }
+        Backend lastBackend() const { return m_lastBackend; }
+        const Stats& stats() const { return m_stats; }
+
+    private:
+        bool fitsDense() const;
+        Backend chooseBackend(int64_t extent);
+        template <typename State>
+        void search(State& state, int64_t startCell, int64_t goalCell, int unitSize, bool learn, DeadEnds* deadEnds, std::vector<glm::vec2>& path);
+        int manhattan(int64_t cell) const;
+        int hValue(int64_t cell) const;
+        void setH(int64_t cell, int value);
+
+        Grid& m_grid;
+        DeadEnds* m_deadEnds = nullptr;
+        const ClearanceMap* m_clearance = nullptr;
+        int m_size = 0;
+        bool m_learn = true;
+        int64_t m_goal = -1;
+        int m_totalDelta = 0;
+        int m_lastExpanded = 0;
+        int m_lastHeapOps = 0;
+        Stats m_stats;
+        Backend m_backend = Backend::AUTO;
+        Backend m_lastBackend = Backend::DENSE;
+        size_t m_denseBudget = (size_t)512 << 20;
+
+        DenseSearchState m_dense;
+        SparseSearchState m_sparse;
+        std::vector<int> m_h;
+        std::vector<int> m_hDelta;
+        std::vector<char> m_hValid;
+        std::vector<int64_t> m_closedList;
+    };
+
+    /*
+        "Route me to the closest of these" in a single search.
+        All goals are seeded at once and the search runs backwards towards the start,
+        the heuristic is the distance to the start so it stays O(1) no matter how many goals.
+        The first goal whose wave settles the start is the nearest reachable one.
+    */
+    class NearestSearch
+    {
+    public:
+        NearestSearch(Grid& grid);
+        void reset();
+        //returns the index of the winning goal or -1, path runs from start to that goal
+        int findNearest(glm::vec2 start, const std::vector<glm::vec2>& goals, std::vector<glm::vec2>& path);
+        int lastExpanded() const { return m_lastExpanded; }
+        int lastHeapOps() const { return m_lastHeapOps; }
+
+    private:
+        Grid& m_grid;
+        int m_size = 0;
+        uint32_t m_searchId = 0;
+        int m_lastExpanded = 0;
+        int m_lastHeapOps = 0;
+
+        std::vector<int> m_g;
+        std::vector<int64_t> m_parent;
+        std::vector<int> m_origin;
+        std::vector<uint32_t> m_generated;
+        std::vector<uint32_t> m_closed;
+    };
+
+    /*
+        Plain A* for worker threads while the main thread keeps editing walls through GridVersions.
+        Every search pins the current version, so the path it returns is valid on exactly that
+        version and the search never waits for the writer.
+    */
+    class SnapshotSearch
+    {
+    public:
+        SnapshotSearch(GridVersions& versions);
+        std::vector<glm::vec2> findPath(glm::vec2 start, glm::vec2 goal);
+        //version of the walls the last path was planned on
+        uint64_t lastVersion() const { return m_lastVersion; }
+        int lastExpanded() const { return m_lastExpanded; }
+        int lastHeapOps() const { return m_lastHeapOps; }
+
+    private:
+        GridVersions& m_versions;
+        int m_size = 0;
+        uint32_t m_searchId = 0;
+        uint64_t m_lastVersion = 0;
+        int m_lastExpanded = 0;
+        int m_lastHeapOps = 0;
+
+        std::vector<int> m_g;
+        std::vector<int64_t> m_parent;
+        std::vector<uint32_t> m_generated;
+        std::vector<uint32_t> m_closed;
+    };
+
+    //one query of a recorded session, wall edits (x, z, wall) are applied to the grid before it runs
+    struct SessionQuery
+    {
+        glm::ivec2 start;
+        glm::ivec2 goal;
+        std::vector<glm::ivec3> wallEdits;
+    };
+
+    struct SessionReport
+    {
+        int queries = 0;
+        long long plainExpanded = 0;
+        long long adaptiveExpanded = 0;
+    };
+
+    //replays the session with plain and adaptive A* side by side, leaves the edits applied to grid
+    SessionReport replaySession(Grid& grid, const std::vector<SessionQuery>& session);
+}
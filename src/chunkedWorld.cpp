@@ -0,0 +1,697 @@
+#include "chunkedWorld.h"
+#include "grid.h"
+
+#include <iostream>
+#include <queue>
+#include <chrono>
+#include <climits>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+
+namespace
+{
+    constexpr uint32_t CHUNK_MAGIC = 0x4B484357; //"WCHK"
+    constexpr uint32_t CHUNK_VERSION = 1;
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        int32_t size;
+        int32_t chunkSize;
+        int32_t side;
+        int32_t nodeCount;
+        uint64_t distCount;
+        uint64_t chunksOffset;
+        uint64_t nodesOffset;
+        uint64_t distOffset;
+        //page aligned, chunk i at bitsOffset + i * chunk bytes
+        uint64_t bitsOffset;
+    };
+
+    //breadth first search over the cells of one chunk, dist stays -1 where it didn't get,
+    //stops once stop is reached (-1 to search everything)
+    void chunkSearch(const uint64_t* bits, int chunkSize, int from, int stop, std::vector<int>& dist, std::vector<int>& parent,
+        std::vector<int>& queue)
+    {
+        const int words = chunkSize / 64;
+        auto blocked = [&](int x, int z) {
+            return (bits[z * words + (x >> 6)] >> (x & 63)) & 1;
+            };
+        dist.assign(chunkSize * chunkSize, -1);
+        parent.assign(chunkSize * chunkSize, -1);
+        queue.clear();
+        if (blocked(from % chunkSize, from / chunkSize))
+            return;
+
+        dist[from] = 0;
+        queue.push_back(from);
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            int cell = queue[head];
+            if (cell == stop)
+                return;
+            int x = cell % chunkSize;
+            int z = cell / chunkSize;
+            const int neighbours[4][2] = { { x + 1, z }, { x - 1, z }, { x, z + 1 }, { x, z - 1 } };
+            for (auto& n : neighbours)
+            {
+                if (n[0] < 0 || n[1] < 0 || n[0] >= chunkSize || n[1] >= chunkSize || blocked(n[0], n[1]))
+                    continue;
+                int next = n[1] * chunkSize + n[0];
+                if (dist[next] >= 0)
+                    continue;
+                dist[next] = dist[cell] + 1;
+                parent[next] = cell;
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+bool ChunkedWorld::write(const Grid& grid, int chunkSize, const std::string& path)
+{
+    if (chunkSize < 64 || chunkSize % 64 != 0)
+    {
+        std::cout << "Chunk size has to be a multiple of 64\n";
+        return false;
+    }
+
+    const int size = grid.getSize();
+    const int side = (size + chunkSize - 1) / chunkSize;
+    const int words = chunkSize / 64;
+    auto open = [&](int x, int z) {
+        return x >= 0 && z >= 0 && x < size && z < size && !grid.wall(x, z);
+        };
+    auto chunkOf = [&](int x, int z) {
+        return (z / chunkSize) * side + x / chunkSize;
+        };
+
+    //entrances come in pairs across a chunk edge, runs end at chunk corners
+    std::vector<Node> found;
+    std::vector<std::vector<int>> chunkNodes(side * side);
+    auto addPair = [&](int ax, int az, int bx, int bz) {
+        int a = (int)found.size();
+        found.push_back({ ax, az, a + 1 });
+        found.push_back({ bx, bz, a });
+        chunkNodes[chunkOf(ax, az)].push_back(a);
+        chunkNodes[chunkOf(bx, bz)].push_back(a + 1);
+        };
+    for (int vertical = 0; vertical < 2; vertical++)
+    {
+        for (int edge = chunkSize; edge < size; edge += chunkSize)
+        {
+            //vertical edges run along z between x = edge - 1 and x = edge
+            auto crossing = [&](int t) {
+                return vertical ? open(edge - 1, t) && open(edge, t) : open(t, edge - 1) && open(t, edge);
+                };
+            auto add = [&](int t) {
+                if (vertical)
+                    addPair(edge - 1, t, edge, t);
+                else
+                    addPair(t, edge - 1, t, edge);
+                };
+            for (int segment = 0; segment < size; segment += chunkSize)
+            {
+                int end = std::min(size, segment + chunkSize);
+                int runStart = -1;
+                for (int t = segment; t <= end; t++)
+                {
+                    bool inRun = t < end && crossing(t);
+                    if (inRun && runStart < 0)
+                        runStart = t;
+                    if (inRun || runStart < 0)
+                        continue;
+
+                    //long openings get an entrance at both ends, short ones in the middle
+                    int runEnd = t - 1;
+                    if (runEnd - runStart + 1 >= 6)
+                    {
+                        add(runStart);
+                        add(runEnd);
+                    }
+                    else
+                    {
+                        add((runStart + runEnd) / 2);
+                    }
+                    runStart = -1;
+                }
+            }
+        }
+    }
+
+    //every chunk's nodes are stored together
+    std::vector<int> order(found.size());
+    std::vector<ChunkEntry> chunks(side * side);
+    std::vector<Node> nodes;
+    uint64_t distCount = 0;
+    for (int c = 0; c < side * side; c++)
+    {
+        chunks[c] = { (int32_t)nodes.size(), (int32_t)chunkNodes[c].size(), distCount };
+        distCount += (uint64_t)chunkNodes[c].size() * chunkNodes[c].size();
+        for (int id : chunkNodes[c])
+        {
+            order[id] = (int)nodes.size();
+            nodes.push_back(found[id]);
+        }
+    }
+    for (Node& node : nodes)
+    {
+        node.across = order[node.across];
+    }
+
+    FileHeader header = {};
+    header.magic = CHUNK_MAGIC;
+    header.version = CHUNK_VERSION;
+    header.size = size;
+    header.chunkSize = chunkSize;
+    header.side = side;
+    header.nodeCount = (int32_t)nodes.size();
+    header.distCount = distCount;
+    header.chunksOffset = sizeof(FileHeader);
+    header.nodesOffset = header.chunksOffset + chunks.size() * sizeof(ChunkEntry);
+    header.distOffset = header.nodesOffset + nodes.size() * sizeof(Node);
+    header.bitsOffset = (header.distOffset + distCount * sizeof(int32_t) + 4095) / 4096 * 4096;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "Failed to write " << path << "\n";
+        return false;
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)chunks.data(), chunks.size() * sizeof(ChunkEntry));
+    file.write((const char*)nodes.data(), nodes.size() * sizeof(Node));
+
+    //chunk walls, cells past the map are wall
+    std::vector<std::vector<uint64_t>> bits(side * side, std::vector<uint64_t>((size_t)chunkSize * words, 0));
+    for (int c = 0; c < side * side; c++)
+    {
+        int x0 = (c % side) * chunkSize;
+        int z0 = (c / side) * chunkSize;
+        for (int lz = 0; lz < chunkSize; lz++)
+        {
+            for (int lx = 0; lx < chunkSize; lx++)
+            {
+                if (!open(x0 + lx, z0 + lz))
+                    bits[c][lz * words + (lx >> 6)] |= 1ull << (lx & 63);
+            }
+        }
+    }
+
+    //entrance to entrance distances inside each chunk, one search per entrance,
+    //chunks are spread over threads a batch at a time so only a batch of tables is held
+    const int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    const int batch = threads * 8;
+    std::vector<std::vector<int32_t>> tables(batch);
+    for (int first = 0; first < side * side; first += batch)
+    {
+        int last = std::min(side * side, first + batch);
+        std::atomic<int> next(first);
+        auto work = [&]() {
+            std::vector<int> dist, parent, queue;
+            for (int c = next++; c < last; c = next++)
+            {
+                const ChunkEntry& entry = chunks[c];
+                int x0 = (c % side) * chunkSize;
+                int z0 = (c / side) * chunkSize;
+                std::vector<int32_t>& table = tables[c - first];
+                table.assign((size_t)entry.nodeCount * entry.nodeCount, -1);
+                for (int i = 0; i < entry.nodeCount; i++)
+                {
+                    const Node& from = nodes[entry.firstNode + i];
+                    chunkSearch(bits[c].data(), chunkSize, (from.z - z0) * chunkSize + from.x - x0, -1, dist, parent, queue);
+                    for (int j = 0; j < entry.nodeCount; j++)
+                    {
+                        const Node& to = nodes[entry.firstNode + j];
+                        table[(size_t)i * entry.nodeCount + j] = dist[(to.z - z0) * chunkSize + to.x - x0];
+                    }
+                }
+            }
+            };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++)
+        {
+            pool.emplace_back(work);
+        }
+        work();
+        for (std::thread& t : pool)
+        {
+            t.join();
+        }
+        for (int c = first; c < last; c++)
+        {
+            file.write((const char*)tables[c - first].data(), tables[c - first].size() * sizeof(int32_t));
+        }
+    }
+
+    file.seekp(header.bitsOffset);
+    for (int c = 0; c < side * side; c++)
+    {
+        file.write((const char*)bits[c].data(), bits[c].size() * sizeof(uint64_t));
+    }
+    return (bool)file;
+}
+
+ChunkedWorld::~ChunkedWorld()
+{
+    close();
+}
+
+bool ChunkedWorld::open(const std::string& path, int maxResident)
+{
+    close();
+    m_file.open(path, std::ios::binary);
+    FileHeader header = {};
+    if (!m_file.is_open() || !m_file.read((char*)&header, sizeof(header)))
+    {
+        std::cout << "Failed to open chunk file " << path << "\n";
+        return false;
+    }
+    //every section has to fit in the file before anything is sized from it
+    m_file.seekg(0, std::ios::end);
+    const uint64_t length = (uint64_t)m_file.tellg();
+    const uint64_t chunkCount = header.side > 0 ? (uint64_t)header.side * header.side : 0;
+    const uint64_t chunkBytes = header.chunkSize > 0 ? (uint64_t)header.chunkSize * (header.chunkSize / 64) * sizeof(uint64_t) : 0;
+    auto fits = [length](uint64_t offset, uint64_t count, uint64_t bytes) {
+        return offset <= length && count <= (length - offset) / bytes;
+        };
+    bool valid = header.magic == CHUNK_MAGIC && header.version == CHUNK_VERSION && header.chunkSize >= 64 && header.chunkSize % 64 == 0
+        && header.size > 0 && header.nodeCount >= 0 && header.side == (header.size + (int64_t)header.chunkSize - 1) / header.chunkSize
+        && fits(header.chunksOffset, chunkCount, sizeof(ChunkEntry)) && fits(header.nodesOffset, (uint64_t)header.nodeCount, sizeof(Node))
+        && fits(header.distOffset, header.distCount, sizeof(int32_t)) && fits(header.bitsOffset, chunkCount, chunkBytes);
+    if (!valid)
+    {
+        std::cout << "Bad chunk file header in " << path << "\n";
+        m_file.close();
+        return false;
+    }
+
+    m_path = path;
+    m_size = header.size;
+    m_chunkSize = header.chunkSize;
+    m_side = header.side;
+    m_words = m_chunkSize / 64;
+    m_bitsOffset = header.bitsOffset;
+    m_maxResident = std::max(1, maxResident);
+
+    m_chunks.resize((size_t)m_side * m_side);
+    m_nodes.resize(header.nodeCount);
+    m_dist.resize(header.distCount);
+    m_file.seekg(header.chunksOffset);
+    m_file.read((char*)m_chunks.data(), m_chunks.size() * sizeof(ChunkEntry));
+    m_file.seekg(header.nodesOffset);
+    m_file.read((char*)m_nodes.data(), m_nodes.size() * sizeof(Node));
+    m_file.seekg(header.distOffset);
+    m_file.read((char*)m_dist.data(), m_dist.size() * sizeof(int32_t));
+    if (!m_file)
+    {
+        std::cout << "Truncated chunk file " << path << "\n";
+        close();
+        return false;
+    }
+
+    //chunks hold consecutive runs of nodes and distance tables, in the order write() puts them,
+    //every node lies in its chunk and crosses to a node that exists
+    int64_t nextNode = 0;
+    uint64_t nextDist = 0;
+    for (size_t c = 0; c < m_chunks.size() && valid; c++)
+    {
+        const ChunkEntry& chunk = m_chunks[c];
+        valid = chunk.firstNode == nextNode && chunk.nodeCount >= 0 && chunk.nodeCount <= header.nodeCount - nextNode
+            && chunk.firstDist == nextDist;
+        if (!valid)
+            break;
+        nextNode += chunk.nodeCount;
+        nextDist += (uint64_t)chunk.nodeCount * chunk.nodeCount;
+        const int cx = (int)(c % m_side), cz = (int)(c / m_side);
+        for (int i = 0; i < chunk.nodeCount && valid; i++)
+        {
+            const Node& node = m_nodes[chunk.firstNode + i];
+            valid = node.x >= 0 && node.z >= 0 && node.x < m_size && node.z < m_size && node.x / m_chunkSize == cx
+                && node.z / m_chunkSize == cz && node.across >= 0 && node.across < header.nodeCount;
+        }
+    }
+    if (!valid || nextNode != header.nodeCount || nextDist != header.distCount)
+    {
+        std::cout << "Corrupt chunk file " << path << "\n";
+        close();
+        return false;
+    }
+
+    m_nodeChunk.resize(m_nodes.size());
+    for (size_t c = 0; c < m_chunks.size(); c++)
+    {
+        for (int i = 0; i < m_chunks[c].nodeCount; i++)
+        {
+            m_nodeChunk[m_chunks[c].firstNode + i] = (int)c;
+        }
+    }
+    m_where.assign(m_chunks.size(), m_lru.end());
+    m_isResident.assign(m_chunks.size(), 0);
+    m_inFlight.assign(m_chunks.size(), 0);
+    m_g.assign(m_nodes.size(), 0);
+    m_parent.assign(m_nodes.size(), -1);
+    m_generated.assign(m_nodes.size(), 0);
+    m_stats = Stats();
+
+    m_stop = false;
+    m_io = std::thread(&ChunkedWorld::ioLoop, this);
+    return true;
+}
+
+void ChunkedWorld::close()
+{
+    if (m_io.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_ioMutex);
+            m_stop = true;
+        }
+        m_ioWake.notify_one();
+        m_io.join();
+    }
+    m_requests.clear();
+    m_arrived.clear();
+    m_lru.clear();
+    m_where.clear();
+    m_isResident.clear();
+    m_inFlight.clear();
+    m_file.close();
+}
+
+bool ChunkedWorld::readChunk(std::ifstream& file, int chunk, std::vector<uint64_t>& bits)
+{
+    bits.resize((size_t)m_chunkSize * m_words);
+    file.seekg(m_bitsOffset + (uint64_t)chunk * bits.size() * sizeof(uint64_t));
+    return (bool)file.read((char*)bits.data(), bits.size() * sizeof(uint64_t));
+}
+
+void ChunkedWorld::ioLoop()
+{
+    //its own stream, the main thread keeps m_file for stalls
+    std::ifstream file(m_path, std::ios::binary);
+    std::vector<uint64_t> bits;
+    std::unique_lock<std::mutex> lock(m_ioMutex);
+    while (true)
+    {
+        m_ioWake.wait(lock, [this]() { return m_stop || !m_requests.empty(); });
+        if (m_stop)
+            return;
+        int chunk = m_requests.front();
+        m_requests.pop_front();
+
+        lock.unlock();
+        bool ok = readChunk(file, chunk, bits);
+        lock.lock();
+        if (ok)
+            m_arrived.emplace_back(chunk, std::move(bits));
+        else
+            m_inFlight[chunk] = 0;
+    }
+}
+
+void ChunkedWorld::installArrived()
+{
+    std::vector<std::pair<int, std::vector<uint64_t>>> arrived;
+    {
+        std::lock_guard<std::mutex> lock(m_ioMutex);
+        arrived.swap(m_arrived);
+        for (auto& [chunk, bits] : arrived)
+        {
+            m_inFlight[chunk] = 0;
+        }
+    }
+    for (auto& [chunk, bits] : arrived)
+    {
+        //a stall may have loaded it in the meantime
+        if (m_isResident[chunk])
+            continue;
+        m_stats.readAheads++;
+        m_stats.bytesRead += bits.size() * sizeof(uint64_t);
+        install(chunk, std::move(bits), true);
+    }
+}
+
+void ChunkedWorld::install(int chunk, std::vector<uint64_t>&& bits, bool readAhead)
+{
+    m_lru.push_front({ chunk, readAhead, std::move(bits) });
+    m_where[chunk] = m_lru.begin();
+    m_isResident[chunk] = 1;
+    evict();
+}
+
+void ChunkedWorld::evict()
+{
+    while (m_lru.size() > m_maxResident)
+    {
+        int chunk = m_lru.back().chunk;
+        m_isResident[chunk] = 0;
+        m_where[chunk] = m_lru.end();
+        m_lru.pop_back();
+        m_stats.evictions++;
+    }
+}
+
+const uint64_t* ChunkedWorld::chunkBits(int chunk)
+{
+    if (!m_isResident[chunk])
+        installArrived();
+    if (m_isResident[chunk])
+    {
+        auto it = m_where[chunk];
+        m_lru.splice(m_lru.begin(), m_lru, it);
+        m_stats.hits++;
+        if (it->readAhead)
+        {
+            m_stats.readAheadHits++;
+            it->readAhead = false;
+        }
+        return it->bits.data();
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<uint64_t> bits;
+    if (!readChunk(m_file, chunk, bits))
+    {
+        //a broken file reads as all wall
+        m_file.clear();
+        bits.assign((size_t)m_chunkSize * m_words, ~0ull);
+    }
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+    m_stats.misses++;
+    m_stats.stallNs += ns;
+    m_stats.maxStallNs = std::max(m_stats.maxStallNs, ns);
+    m_stats.bytesRead += bits.size() * sizeof(uint64_t);
+    install(chunk, std::move(bits), false);
+    return m_lru.front().bits.data();
+}
+
+void ChunkedWorld::readAhead(int chunk)
+{
+    if (chunk < 0 || chunk >= (int)m_chunks.size() || m_isResident[chunk])
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_ioMutex);
+        if (m_inFlight[chunk])
+            return;
+        m_inFlight[chunk] = 1;
+        m_requests.push_back(chunk);
+    }
+    m_ioWake.notify_one();
+}
+
+void ChunkedWorld::update(const std::vector<glm::ivec2>& focus, int radius)
+{
+    installArrived();
+    for (glm::ivec2 tile : focus)
+    {
+        int cx0 = std::max(0, tile.x - radius) / m_chunkSize, cx1 = std::min(m_size - 1, tile.x + radius) / m_chunkSize;
+        int cz0 = std::max(0, tile.y - radius) / m_chunkSize, cz1 = std::min(m_size - 1, tile.y + radius) / m_chunkSize;
+        for (int cz = cz0; cz <= cz1; cz++)
+        {
+            for (int cx = cx0; cx <= cx1; cx++)
+            {
+                chunkBits(cz * m_side + cx);
+            }
+        }
+    }
+}
+
+bool ChunkedWorld::wall(int x, int z)
+{
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size)
+        return true;
+    const uint64_t* bits = chunkBits(chunkOf(x, z));
+    int lx = x % m_chunkSize;
+    int lz = z % m_chunkSize;
+    return (bits[lz * m_words + (lx >> 6)] >> (lx & 63)) & 1;
+}
+
+bool ChunkedWorld::resident(int x, int z) const
+{
+    return x >= 0 && z >= 0 && x < m_size && z < m_size && m_isResident[chunkOf(x, z)];
+}
+
+std::vector<int> ChunkedWorld::residentChunks() const
+{
+    std::vector<int> chunks;
+    for (const Resident& r : m_lru)
+    {
+        chunks.push_back(r.chunk);
+    }
+    return chunks;
+}
+
+bool ChunkedWorld::findRoute(glm::ivec2 start, glm::ivec2 goal, Route& route, int refineSegments)
+{
+    route = Route();
+    if (start.x < 0 || start.y < 0 || goal.x < 0 || goal.y < 0 || start.x >= m_size || start.y >= m_size || goal.x >= m_size || goal.y >= m_size)
+        return false;
+
+    const int cs = m_chunkSize;
+    auto local = [&](int x, int z) {
+        return (z % cs) * cs + x % cs;
+        };
+    int startChunk = chunkOf(start.x, start.y);
+    int goalChunk = chunkOf(goal.x, goal.y);
+
+    //cell searches from start and goal to the entrances of their chunks, one chunk at a time
+    const ChunkEntry& first = m_chunks[startChunk];
+    std::vector<int> startDist(first.nodeCount);
+    chunkSearch(chunkBits(startChunk), cs, local(start.x, start.y), -1, m_cellDist, m_cellParent, m_queue);
+    for (int i = 0; i < first.nodeCount; i++)
+    {
+        startDist[i] = m_cellDist[local(m_nodes[first.firstNode + i].x, m_nodes[first.firstNode + i].z)];
+    }
+    int direct = startChunk == goalChunk ? m_cellDist[local(goal.x, goal.y)] : -1;
+
+    const ChunkEntry& last = m_chunks[goalChunk];
+    std::vector<int> goalDist(last.nodeCount);
+    chunkSearch(chunkBits(goalChunk), cs, local(goal.x, goal.y), -1, m_cellDist, m_cellParent, m_queue);
+    for (int i = 0; i < last.nodeCount; i++)
+    {
+        goalDist[i] = m_cellDist[local(m_nodes[last.firstNode + i].x, m_nodes[last.firstNode + i].z)];
+    }
+
+    //dijkstra over the entrances, unloaded chunks only need their distance tables
+    using Entry = std::pair<int, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    m_searchId++;
+    auto relax = [&](int node, int g, int parent) {
+        if (m_generated[node] == m_searchId && m_g[node] <= g)
+            return;
+        m_generated[node] = m_searchId;
+        m_g[node] = g;
+        m_parent[node] = parent;
+        open.push({ g, node });
+        };
+    for (int i = 0; i < first.nodeCount; i++)
+    {
+        if (startDist[i] >= 0)
+            relax(first.firstNode + i, startDist[i], -1);
+    }
+
+    int best = direct >= 0 ? direct : INT_MAX;
+    int bestNode = -1;
+    while (!open.empty())
+    {
+        auto [g, node] = open.top();
+        open.pop();
+        if (g != m_g[node])
+            continue;
+        if (g >= best)
+            break;
+
+        const ChunkEntry& chunk = m_chunks[m_nodeChunk[node]];
+        int i = node - chunk.firstNode;
+        if (m_nodeChunk[node] == goalChunk && goalDist[i] >= 0 && g + goalDist[i] < best)
+        {
+            best = g + goalDist[i];
+            bestNode = node;
+        }
+
+        relax(m_nodes[node].across, g + 1, node);
+        const int32_t* row = &m_dist[chunk.firstDist + (size_t)i * chunk.nodeCount];
+        for (int j = 0; j < chunk.nodeCount; j++)
+        {
+            if (j != i && row[j] >= 0)
+                relax(chunk.firstNode + j, g + row[j], node);
+        }
+    }
+    if (best == INT_MAX)
+        return false;
+
+    route.cost = best;
+    for (int node = bestNode; node >= 0; node = m_parent[node])
+    {
+        route.pending.push_front(glm::ivec2(m_nodes[node].x, m_nodes[node].z));
+    }
+    route.pending.push_back(goal);
+    route.path.push_back(glm::vec2(start));
+    refineMore(route, refineSegments);
+    return true;
+}
+
+void ChunkedWorld::refineMore(Route& route, int segments)
+{
+    for (int i = 0; i < segments && !route.pending.empty(); i++)
+    {
+        glm::ivec2 from = glm::ivec2(route.path.back());
+        glm::ivec2 to = route.pending.front();
+        route.pending.pop_front();
+        if (!refineSegment(from, to, route.path))
+        {
+            //only happens when the file changed under us
+            route.pending.clear();
+            route.cost = -1;
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < route.pending.size() && i < (size_t)m_readAhead; i++)
+    {
+        readAhead(chunkOf(route.pending[i].x, route.pending[i].y));
+    }
+}
+
+bool ChunkedWorld::refineSegment(glm::ivec2 from, glm::ivec2 to, std::vector<glm::vec2>& path)
+{
+    if (from == to)
+        return true;
+    int chunk = chunkOf(from.x, from.y);
+    if (chunk != chunkOf(to.x, to.y))
+    {
+        //a step over a chunk edge
+        path.push_back(glm::vec2(to));
+        return true;
+    }
+
+    const int cs = m_chunkSize;
+    int x0 = (chunk % m_side) * cs;
+    int z0 = (chunk / m_side) * cs;
+    int goal = (to.y - z0) * cs + to.x - x0;
+    chunkSearch(chunkBits(chunk), cs, (from.y - z0) * cs + from.x - x0, goal, m_cellDist, m_cellParent, m_queue);
+    if (m_cellDist[goal] < 0)
+        return false;
+
+    size_t begin = path.size();
+    for (int cell = goal; m_cellParent[cell] >= 0; cell = m_cellParent[cell])
+    {
+        path.push_back(glm::vec2(x0 + cell % cs, z0 + cell / cs));
+    }
+    std::reverse(path.begin() + begin, path.end());
+    return true;
+}
+
+void ChunkedWorld::printStats() const
+{
+    const Stats& s = m_stats;
+    uint64_t touches = s.hits + s.misses;
+    std::cout << "chunks: " << m_lru.size() << "/" << m_maxResident << " resident of " << m_chunks.size()
+        << ", hit rate " << (touches ? 100.0 * s.hits / touches : 0.0) << "%\n";
+    std::cout << "  stalls " << s.misses << ", " << s.stallNs / 1e6 << " ms total, worst " << s.maxStallNs / 1e3 << " us\n";
+    std::cout << "  read ahead " << s.readAheads << ", used " << s.readAheadHits << ", evictions " << s.evictions
+        << ", " << s.bytesRead / (1024.0 * 1024.0) << " MB read\n";
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <list>
+#include <deque>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+class Grid;
+
+/*
+    World kept in a file as square chunks, for maps bigger than memory.
+    At most maxResident chunks are loaded, the least recently used one is evicted first.
+    The hierarchy (HPA* entrances on chunk edges and the distances between the entrances of
+    every chunk) is small and always in memory, so a route is planned across chunks that aren't
+    loaded and only its next few segments are refined to tiles. The chunks of the segments after
+    those are read ahead on an io thread. Touching a chunk that isn't resident reads it on the
+    spot, that is a stall and shows up in the stats.
+    Chunk files are written from a loaded Grid by write(), see map_convert --chunks.
+*/
+class ChunkedWorld
+{
+public:
+    struct Stats
+    {
+        uint64_t hits = 0;
+        //synchronous reads, every one stalls the caller
+        uint64_t misses = 0;
+        uint64_t stallNs = 0;
+        uint64_t maxStallNs = 0;
+        uint64_t readAheads = 0;
+        //read ahead chunks that got used before they were evicted
+        uint64_t readAheadHits = 0;
+        uint64_t evictions = 0;
+        uint64_t bytesRead = 0;
+    };
+
+    struct Route
+    {
+        int cost = -1;
+        //refined tiles, start first
+        std::vector<glm::vec2> path;
+        //entrance tiles past the end of path that aren't refined yet, the last one is the goal
+        std::deque<glm::ivec2> pending;
+    };
+
+    static bool write(const Grid& grid, int chunkSize, const std::string& path);
+
+    ChunkedWorld() = default;
+    ~ChunkedWorld();
+    bool open(const std::string& path, int maxResident);
+    void close();
+
+    //keeps the chunks within radius of every focus tile (agents, camera) loaded,
+    //also takes in whatever the io thread finished
+    void update(const std::vector<glm::ivec2>& focus, int radius);
+    void readAhead(int chunk);
+    //how many pending segments refineMore reads ahead, 0 turns read ahead off
+    void setReadAhead(int segments) { m_readAhead = segments; }
+
+    //pages the chunk in if it has to
+    bool wall(int x, int z);
+    bool resident(int x, int z) const;
+    int chunkOf(int x, int z) const { return (z / m_chunkSize) * m_side + x / m_chunkSize; }
+    int size() const { return m_size; }
+    int chunkSize() const { return m_chunkSize; }
+    int chunkCount() const { return m_side * m_side; }
+    int residentCount() const { return (int)m_lru.size(); }
+    int nodeCount() const { return (int)m_nodes.size(); }
+    //entrance tiles are always walkable, handy for picking goals without paging anything in
+    glm::ivec2 entrance(int node) const { return glm::ivec2(m_nodes[node].x, m_nodes[node].z); }
+    //for rendering, loaded chunks only
+    std::vector<int> residentChunks() const;
+
+    //plans over the hierarchy and refines the first segments
+    bool findRoute(glm::ivec2 start, glm::ivec2 goal, Route& route, int refineSegments = 2);
+    //refines the next segments and reads ahead the chunks of a few more
+    void refineMore(Route& route, int segments);
+
+    const Stats& stats() const { return m_stats; }
+    void printStats() const;
+
+private:
+    struct Node
+    {
+        int32_t x;
+        int32_t z;
+        //the node on the other side of the chunk edge
+        int32_t across;
+    };
+
+    struct ChunkEntry
+    {
+        int32_t firstNode;
+        int32_t nodeCount;
+        uint64_t firstDist;
+    };
+
+    struct Resident
+    {
+        int chunk;
+        bool readAhead;
+        std::vector<uint64_t> bits;
+    };
+
+    const uint64_t* chunkBits(int chunk);
+    bool readChunk(std::ifstream& file, int chunk, std::vector<uint64_t>& bits);
+    void install(int chunk, std::vector<uint64_t>&& bits, bool readAhead);
+    void installArrived();
+    void evict();
+    void ioLoop();
+    bool refineSegment(glm::ivec2 from, glm::ivec2 to, std::vector<glm::vec2>& path);
+
+    std::string m_path;
+    int m_size = 0;
+    int m_chunkSize = 0;
+    int m_side = 0;
+    int m_words = 0;
+    uint64_t m_bitsOffset = 0;
+    size_t m_maxResident = 0;
+    int m_readAhead = 4;
+
+    //hierarchy, always loaded
+    std::vector<Node> m_nodes;
+    std::vector<int> m_nodeChunk;
+    std::vector<ChunkEntry> m_chunks;
+    std::vector<int32_t> m_dist;
+
+    //front is the newest
+    std::list<Resident> m_lru;
+    std::vector<std::list<Resident>::iterator> m_where;
+    std::vector<char> m_isResident;
+    std::ifstream m_file;
+    Stats m_stats;
+
+    //io thread, requests in and chunks out under m_ioMutex
+    std::thread m_io;
+    std::mutex m_ioMutex;
+    std::condition_variable m_ioWake;
+    std::deque<int> m_requests;
+    std::vector<std::pair<int, std::vector<uint64_t>>> m_arrived;
+    std::vector<char> m_inFlight;
+    bool m_stop = false;
+
+    //search scratch
+    std::vector<int> m_g;
+    std::vector<int> m_parent;
+    std::vector<uint32_t> m_generated;
+    uint32_t m_searchId = 0;
+    std::vector<int> m_cellDist;
+    std::vector<int> m_cellParent;
+    std::vector<int> m_queue;
+};
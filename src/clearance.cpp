@@ -0,0 +1,172 @@
+#include "clearance.h"
+#include "grid.h"
+#include "navCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CLEARANCE_SSE2 1
+#endif
+
+namespace
+{
+    uint8_t inc(uint8_t v)
+    {
+        return v == 255 ? 255 : v + 1;
+    }
+}
+
+ClearanceMap::ClearanceMap(Grid& grid, const NavCache* cache)
+    : m_grid(grid)
+{
+    if (!cache || !load(*cache))
+        build();
+}
+
+void ClearanceMap::save(NavCache& cache) const
+{
+    //right runs, down runs and clearance back to back, the free mask comes from the walls
+    size_t bytes = m_clearance.size();
+    std::vector<uint8_t> data(bytes * 3);
+    std::memcpy(data.data(), m_right.data(), bytes);
+    std::memcpy(data.data() + bytes, m_down.data(), bytes);
+    std::memcpy(data.data() + bytes * 2, m_clearance.data(), bytes);
+    cache.add(NavCache::CLEARANCE, data.data(), data.size());
+}
+
+bool ClearanceMap::load(const NavCache& cache)
+{
+    m_size = m_grid.getSize();
+    m_stride = (m_size + 1 + 15) / 16 * 16;
+    size_t bytes = (size_t)m_stride * (m_size + 1) + 16;
+
+    size_t sectionBytes;
+    const uint8_t* data = (const uint8_t*)cache.section(NavCache::CLEARANCE, sectionBytes);
+    if (!data || sectionBytes != bytes * 3)
+        return false;
+
+    m_right.assign(data, data + bytes);
+    m_down.assign(data + bytes, data + bytes * 2);
+    m_clearance.assign(data + bytes * 2, data + bytes * 3);
+    m_free.assign(bytes, 0);
+    for (int z = 0; z < m_size; z++)
+    {
+        for (int x = 0; x < m_size; x++)
+        {
+            size_t i = (size_t)z * m_stride + x;
+            m_free[i] = m_grid.wall(x, z) ? 0 : 0xFF;
+            //a wall has no square and a free cell at least its own
+            if ((m_free[i] != 0) != (m_clearance[i] != 0))
+                return false;
+        }
+    }
+    return true;
+}
+
+void ClearanceMap::build()
+{
+    m_size = m_grid.getSize();
+    m_stride = (m_size + 1 + 15) / 16 * 16;
+
+    //16 spare bytes so the last row can read one past its end
+    size_t bytes = (size_t)m_stride * (m_size + 1) + 16;
+    m_free.assign(bytes, 0);
+    m_right.assign(bytes, 0);
+    m_down.assign(bytes, 0);
+    m_clearance.assign(bytes, 0);
+
+    for (int z = 0; z < m_size; z++)
+    {
+        uint8_t* freeRow = &m_free[(size_t)z * m_stride];
+        uint8_t* rightRow = &m_right[(size_t)z * m_stride];
+        uint8_t run = 0;
+        for (int x = m_size - 1; x >= 0; x--)
+        {
+            freeRow[x] = m_grid.wall(x, z) ? 0 : 0xFF;
+            run = freeRow[x] ? inc(run) : 0;
+            rightRow[x] = run;
+        }
+    }
+
+    sweepRows(0, m_size - 1);
+}
+
+void ClearanceMap::sweepRows(int z0, int z1)
+{
+    //each row only reads the row below, so a whole row is done in wide steps
+    for (int z = z1; z >= z0; z--)
+    {
+        const uint8_t* freeRow = &m_free[(size_t)z * m_stride];
+        const uint8_t* rightRow = &m_right[(size_t)z * m_stride];
+        const uint8_t* downBelow = &m_down[(size_t)(z + 1) * m_stride];
+        const uint8_t* clearBelow = &m_clearance[(size_t)(z + 1) * m_stride];
+        uint8_t* downRow = &m_down[(size_t)z * m_stride];
+        uint8_t* clearRow = &m_clearance[(size_t)z * m_stride];
+
+        int x = 0;
+#ifdef CLEARANCE_SSE2
+        const __m128i one = _mm_set1_epi8(1);
+        for (; x + 16 <= m_stride; x += 16)
+        {
+            __m128i freeMask = _mm_loadu_si128((const __m128i*)(freeRow + x));
+            __m128i down = _mm_and_si128(freeMask, _mm_adds_epu8(_mm_loadu_si128((const __m128i*)(downBelow + x)), one));
+            __m128i diag = _mm_adds_epu8(_mm_loadu_si128((const __m128i*)(clearBelow + x + 1)), one);
+            __m128i right = _mm_loadu_si128((const __m128i*)(rightRow + x));
+            __m128i clear = _mm_and_si128(freeMask, _mm_min_epu8(_mm_min_epu8(diag, right), down));
+            _mm_storeu_si128((__m128i*)(downRow + x), down);
+            _mm_storeu_si128((__m128i*)(clearRow + x), clear);
+        }
+#endif
+        for (; x < m_stride; x++)
+        {
+            downRow[x] = freeRow[x] ? inc(downBelow[x]) : 0;
+            clearRow[x] = freeRow[x] ? std::min({ inc(clearBelow[x + 1]), rightRow[x], downRow[x] }) : 0;
+        }
+    }
+}
+
+bool ClearanceMap::recomputeCell(int x, int z)
+{
+    size_t i = (size_t)z * m_stride + x;
+    size_t below = i + m_stride;
+    uint8_t down = m_free[i] ? inc(m_down[below]) : 0;
+    uint8_t clear = m_free[i] ? std::min({ inc(m_clearance[below + 1]), m_right[i], down }) : 0;
+    bool changed = down != m_down[i] || clear != m_clearance[i];
+    m_down[i] = down;
+    m_clearance[i] = clear;
+    return changed;
+}
+
+void ClearanceMap::onWallChanged(int x, int z)
+{
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size)
+        return;
+
+    size_t row = (size_t)z * m_stride;
+    m_free[row + x] = m_grid.wall(x, z) ? 0 : 0xFF;
+
+    //right runs only change in this row, left of the cell
+    for (int i = x; i >= 0; i--)
+    {
+        uint8_t run = m_free[row + i] ? inc(m_right[row + i + 1]) : 0;
+        if (i < x && run == m_right[row + i])
+            break;
+        m_right[row + i] = run;
+    }
+
+    //squares are at most 255 wide, so only cells up and left within that can see the edit
+    int x0 = std::max(0, x - 254);
+    int z0 = std::max(0, z - 254);
+    for (int j = z; j >= z0; j--)
+    {
+        bool changed = false;
+        for (int i = x; i >= x0; i--)
+        {
+            changed |= recomputeCell(i, j);
+        }
+        if (!changed && j < z)
+            break;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class Grid;
+class NavCache;
+
+/*
+    True clearance map.
+    clearance(x, z) is the side of the biggest free square whose top left cell is (x, z),
+    so a unit that covers size x size tiles fits there when clearance >= size.
+    Values are capped at 255.
+
+    Built with two sweeps: right runs per row, then one bottom-up pass where every row only
+    needs the row below it (down runs and the diagonal neighbour), which is done 16 cells at a time.
+*/
+class ClearanceMap
+{
+public:
+    //with a cache that matches the grid the sweeps are read from it instead of built
+    ClearanceMap(Grid& grid, const NavCache* cache = nullptr);
+    void build();
+    void save(NavCache& cache) const;
+    bool load(const NavCache& cache);
+    //call after Grid::setWall, recomputes only the cells whose square can reach (x, z)
+    void onWallChanged(int x, int z);
+
+    uint8_t clearance(int x, int z) const { return m_clearance[(size_t)z * m_stride + x]; }
+    bool fits(int x, int z, int size) const { return m_clearance[(size_t)z * m_stride + x] >= size; }
+
+private:
+    void sweepRows(int z0, int z1);
+    bool recomputeCell(int x, int z);
+
+    Grid& m_grid;
+    int m_size = 0;
+    //rows are padded with zero cells on the right and one zero row at the bottom
+    int m_stride = 0;
+    std::vector<uint8_t> m_free;
+    std::vector<uint8_t> m_right;
+    std::vector<uint8_t> m_down;
+    std::vector<uint8_t> m_clearance;
+};
@@ -4,14 +4,7 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <iostream>
-
-struct vertex
-{
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec3 color;
-    glm::vec2 texCoord;
-};
+#include "vertex.h"
 
 namespace MODEL_LOADING
 {
@@ -0,0 +1,439 @@
+#include "deadEnds.h"
+#include "navMesh.h"
+
+#include <algorithm>
+
+namespace
+{
+    int cellCount(const NavMesh::Poly& p)
+    {
+        return (p.x1 - p.x0 + 1) * (p.z1 - p.z0 + 1);
+    }
+}
+
+DeadEnds::DeadEnds(NavMesh& navMesh)
+    : m_navMesh(navMesh)
+{
+    build();
+}
+
+void DeadEnds::resize(size_t polys)
+{
+    m_polyPocket.resize(polys, MAIN);
+    m_visited.resize(polys, 0);
+    m_disc.resize(polys, 0);
+    m_low.resize(polys, 0);
+    m_dfsParent.resize(polys, -1);
+    m_subtree.resize(polys, 0);
+    m_region.resize(polys, 0);
+    m_done.resize(polys, 0);
+    m_hanging.resize(polys, 0);
+    m_created.resize(polys, 0);
+}
+
+void DeadEnds::build()
+{
+    const auto& polys = m_navMesh.polys();
+    size_t count = polys.size();
+    m_polyPocket.clear();
+    m_hanging.clear();
+    resize(count);
+    m_pockets.clear();
+    m_freePockets.clear();
+
+    m_regionStamp++;
+    for (size_t id = 0; id < count; id++)
+    {
+        m_region[id] = m_regionStamp;
+    }
+
+    std::vector<int> created;
+    for (int id = 0; id < (int)count; id++)
+    {
+        if (!polys[id].alive || m_done[id] == m_regionStamp)
+            continue;
+        m_polyPocket[id] = MAIN;
+        analyseComponent(id, created);
+    }
+}
+
+int DeadEnds::allocPocket(const Pocket& pocket)
+{
+    if (m_freePockets.empty())
+    {
+        m_pockets.push_back(pocket);
+        return (int)m_pockets.size() - 1;
+    }
+    int id = m_freePockets.back();
+    m_freePockets.pop_back();
+    m_pockets[id] = pocket;
+    return id;
+}
+
+int DeadEnds::commonPocket(int a, int b) const
+{
+    auto depth = [&](int p) {
+        int d = 0;
+        for (; p != MAIN; p = m_pockets[p].parent)
+        {
+            d++;
+        }
+        return d;
+        };
+    int da = depth(a), db = depth(b);
+    for (; da > db; da--)
+    {
+        a = m_pockets[a].parent;
+    }
+    for (; db > da; db--)
+    {
+        b = m_pockets[b].parent;
+    }
+    while (a != b)
+    {
+        a = m_pockets[a].parent;
+        b = m_pockets[b].parent;
+    }
+    return a;
+}
+
+void DeadEnds::analyseComponent(int root, std::vector<int>& created)
+{
+    //the root's side never becomes a pocket, so restart from the dfs centroid:
+    //the deepest rectangle whose subtree still holds more than half of the cells
+    size_t firstCreated = created.size();
+    analyse(root, false, created);
+
+    int total = m_subtree[root];
+    int centroid = root;
+    for (int p : m_order)
+    {
+        if (m_subtree[p] * 2 > total && m_subtree[p] < m_subtree[centroid])
+            centroid = p;
+    }
+    if (centroid != root)
+    {
+        for (size_t i = firstCreated; i < created.size(); i++)
+        {
+            m_freePockets.push_back(created[i]);
+        }
+        created.resize(firstCreated);
+        m_polyPocket[centroid] = MAIN;
+        analyse(centroid, false, created);
+    }
+
+    for (int p : m_order)
+    {
+        m_done[p] = m_regionStamp;
+    }
+}
+
+void DeadEnds::analyse(int root, bool entranceRoot, std::vector<int>& created)
+{
+    //iterative tarjan over the region rectangles
+    const auto& polys = m_navMesh.polys();
+    m_visitStamp++;
+    m_order.clear();
+
+    struct Frame
+    {
+        int poly;
+        size_t portal;
+    };
+    std::vector<Frame> stack;
+
+    auto visit = [&](int poly, int parent) {
+        m_visited[poly] = m_visitStamp;
+        m_disc[poly] = m_low[poly] = (int)m_order.size();
+        m_dfsParent[poly] = parent;
+        m_subtree[poly] = cellCount(polys[poly]) + (inRegion(poly) ? m_hanging[poly] : 0);
+        m_order.push_back(poly);
+        stack.push_back({ poly, 0 });
+        };
+    visit(root, -1);
+
+    while (!stack.empty())
+    {
+        Frame& f = stack.back();
+        int poly = f.poly;
+        if (f.portal < polys[poly].portals.size())
+        {
+            int next = polys[poly].portals[f.portal++].to;
+            //edges back to an entrance root still count for low
+            if (!inRegion(next) && next != root)
+                continue;
+            if (m_visited[next] == m_visitStamp)
+            {
+                if (next != m_dfsParent[poly])
+                    m_low[poly] = std::min(m_low[poly], m_disc[next]);
+                continue;
+            }
+            visit(next, poly);
+            continue;
+        }
+
+        stack.pop_back();
+        int parent = m_dfsParent[poly];
+        if (parent >= 0)
+        {
+            m_low[parent] = std::min(m_low[parent], m_low[poly]);
+            m_subtree[parent] += m_subtree[poly];
+        }
+    }
+
+    //preorder, so the pocket of the dfs parent is always known
+    for (size_t i = 1; i < m_order.size(); i++)
+    {
+        int poly = m_order[i];
+        int parent = m_dfsParent[poly];
+        if ((parent != root || entranceRoot) && m_low[poly] >= m_disc[parent])
+        {
+            Pocket pocket;
+            pocket.parent = m_polyPocket[parent];
+            pocket.entrance = parent;
+            pocket.rootPoly = poly;
+            pocket.cells = m_subtree[poly];
+            int id = allocPocket(pocket);
+            m_polyPocket[poly] = id;
+            created.push_back(id);
+        }
+        else
+        {
+            m_polyPocket[poly] = m_polyPocket[parent];
+        }
+    }
+}
+
+void DeadEnds::onWallChanged(int x, int z)
+{
+    const NavMesh::Change& change = m_navMesh.lastChange();
+    //only the navmesh's last edit is known, anything else needs the full pass
+    if (change.x != x || change.z != z)
+    {
+        build();
+        return;
+    }
+    if (change.removed.empty() && change.created.empty())
+        return;
+
+    const auto& polys = m_navMesh.polys();
+    resize(polys.size());
+    m_pocketMark.resize(m_pockets.size(), 0);
+    m_keptMark.resize(m_pockets.size(), 0);
+    m_regionStamp++;
+    for (int id : change.created)
+    {
+        m_created[id] = m_regionStamp;
+    }
+
+    //the common case: everything around the edit sits in one pocket (or the main block), the old
+    //rectangles were linked and the new ones are linked and reach every neighbour. then the edit
+    //contracts to the same node before and after, no articulation point moved and only cells change
+    if (change.removedConnected && !change.removed.empty() && !change.created.empty())
+    {
+        int label = m_polyPocket[change.removed[0]];
+        bool local = true;
+        for (const std::vector<int>* ids : { &change.removed, &change.border })
+        {
+            for (int id : *ids)
+            {
+                local = local && m_polyPocket[id] == label;
+            }
+        }
+        std::vector<int> linked(1, change.created[0]);
+        for (size_t i = 0; local && i < linked.size(); i++)
+        {
+            for (const NavMesh::Portal& portal : polys[linked[i]].portals)
+            {
+                if (m_created[portal.to] == m_regionStamp && std::find(linked.begin(), linked.end(), portal.to) == linked.end())
+                    linked.push_back(portal.to);
+            }
+        }
+        local = local && linked.size() == change.created.size();
+        for (int id : change.border)
+        {
+            const auto& portals = polys[id].portals;
+            local = local && std::any_of(portals.begin(), portals.end(), [&](const NavMesh::Portal& portal) { return m_created[portal.to] == m_regionStamp; });
+        }
+        if (local)
+        {
+            int delta = -change.removedCells;
+            for (int id : change.created)
+            {
+                m_polyPocket[id] = label;
+                delta += cellCount(polys[id]);
+            }
+            for (int p = label; p != MAIN; p = m_pockets[p].parent)
+            {
+                m_pockets[p].cells += delta;
+            }
+            return;
+        }
+    }
+
+    //old labels of the torn down rectangles and their neighbours, the lowest pocket holding all of them
+    //is the one whose structure may have changed
+    std::vector<int> touched;
+    for (const std::vector<int>* ids : { &change.removed, &change.border })
+    {
+        for (int id : *ids)
+        {
+            touched.push_back(m_polyPocket[id]);
+        }
+    }
+    int top = touched.empty() ? MAIN : touched[0];
+    for (int pocket : touched)
+    {
+        top = commonPocket(top, pocket);
+    }
+
+    //pockets from the touched ones up to top are dissolved, their rectangles make the region
+    std::vector<int> dissolved;
+    for (int pocket : touched)
+    {
+        for (int p = pocket; p != top && m_pocketMark[p] != m_regionStamp; p = m_pockets[p].parent)
+        {
+            m_pocketMark[p] = m_regionStamp;
+            dissolved.push_back(p);
+        }
+    }
+    if (top != MAIN)
+    {
+        m_pocketMark[top] = m_regionStamp;
+        dissolved.push_back(top);
+    }
+    auto regionLabel = [&](int pocket) {
+        return pocket == MAIN ? top == MAIN : m_pocketMark[pocket] == m_regionStamp;
+        };
+
+    std::vector<int> open;
+    auto enter = [&](int id) {
+        if (id < 0 || !polys[id].alive || inRegion(id))
+            return;
+        if (m_created[id] != m_regionStamp && !regionLabel(m_polyPocket[id]))
+            return;
+        m_region[id] = m_regionStamp;
+        m_hanging[id] = 0;
+        m_regionPolys.push_back(id);
+        open.push_back(id);
+        };
+    m_regionPolys.clear();
+    for (int id : change.created)
+    {
+        enter(id);
+    }
+    for (int id : change.border)
+    {
+        enter(id);
+    }
+    for (int p : dissolved)
+    {
+        enter(m_pockets[p].rootPoly);
+    }
+
+    //the region is closed off by the entrance of top and by pockets that didn't change,
+    //those stay as they are and only add their cells to the rectangle they hang off
+    std::vector<int> kept;
+    while (!open.empty())
+    {
+        int id = open.back();
+        open.pop_back();
+        for (const NavMesh::Portal& portal : polys[id].portals)
+        {
+            enter(portal.to);
+            if (inRegion(portal.to))
+                continue;
+            int pocket = m_polyPocket[portal.to];
+            if (pocket != MAIN && m_pockets[pocket].entrance == id && m_keptMark[pocket] != m_regionStamp)
+            {
+                m_keptMark[pocket] = m_regionStamp;
+                m_hanging[id] += m_pockets[pocket].cells;
+                kept.push_back(pocket);
+            }
+        }
+    }
+
+    int entrance = top == MAIN ? -1 : m_pockets[top].entrance;
+    int oldCells = top == MAIN ? 0 : m_pockets[top].cells;
+    for (int p : dissolved)
+    {
+        m_freePockets.push_back(p);
+    }
+    for (int id : change.removed)
+    {
+        if (!polys[id].alive)
+            m_polyPocket[id] = MAIN;
+    }
+
+    std::vector<int> created;
+    if (entrance >= 0)
+    {
+        analyse(entrance, true, created);
+        for (int p : m_order)
+        {
+            m_done[p] = m_regionStamp;
+        }
+        //cells that moved in or out of top show up in every pocket around it
+        int delta = m_subtree[entrance] - cellCount(polys[entrance]) - oldCells;
+        for (int p = m_polyPocket[entrance]; p != MAIN; p = m_pockets[p].parent)
+        {
+            m_pockets[p].cells += delta;
+        }
+    }
+    //parts the entrance can't reach any more are on their own now
+    for (int id : m_regionPolys)
+    {
+        if (m_done[id] == m_regionStamp)
+            continue;
+        m_polyPocket[id] = MAIN;
+        analyseComponent(id, created);
+    }
+
+    for (int pocket : kept)
+    {
+        m_pockets[pocket].parent = m_polyPocket[m_pockets[pocket].entrance];
+    }
+}
+
+void DeadEnds::beginQuery(glm::vec2 start, glm::vec2 goal)
+{
+    m_queryStamp++;
+    for (glm::vec2 tile : { start, goal })
+    {
+        for (int p = pocketAt((int)tile.x, (int)tile.y); p >= 0; p = m_pockets[p].parent)
+        {
+            m_pockets[p].allowed = m_queryStamp;
+        }
+    }
+}
+
+bool DeadEnds::skip(int x, int z) const
+{
+    int p = pocketAt(x, z);
+    return p >= 0 && m_pockets[p].allowed != m_queryStamp;
+}
+
+int DeadEnds::pocketAt(int x, int z) const
+{
+    int poly = m_navMesh.polyAt(x, z);
+    if (poly < 0 || poly >= (int)m_polyPocket.size())
+        return MAIN;
+    return m_polyPocket[poly];
+}
+
+float DeadEnds::prunedFraction() const
+{
+    const auto& polys = m_navMesh.polys();
+    int total = 0;
+    int pruned = 0;
+    for (size_t i = 0; i < polys.size(); i++)
+    {
+        if (!polys[i].alive)
+            continue;
+        int cells = cellCount(polys[i]);
+        total += cells;
+        if (i < m_polyPocket.size() && m_polyPocket[i] >= 0)
+            pruned += cells;
+    }
+    return total > 0 ? (float)pruned / total : 0.0f;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+class NavMesh;
+
+/*
+    Dead end / swamp preprocessing over the navmesh rectangles.
+    A pocket is a group of rectangles connected to the rest of the map through a single
+    rectangle (dead end corridors of any width, rooms with one door, areas behind a chokepoint).
+    Rectangles are convex, so a path that leaves the entrance rectangle into a pocket and comes
+    back is never shorter than staying inside it. A search can skip every pocket that
+    doesn't hold its start or goal. Pockets nest, a query allows the chain around start and goal.
+*/
+class DeadEnds
+{
+public:
+    static constexpr int MAIN = -1;
+
+    DeadEnds(NavMesh& navMesh);
+    void build();
+    //call right after NavMesh::onWallChanged for the same cell. An edit that keeps the rectangles around it
+    //linked only moves cell counts, otherwise the pockets on the chain around the re-merged rectangles are
+    //redone up to the lowest pocket holding all of them (or the main block of that part of the map), the
+    //untouched pockets below them are carried over as a single weight
+    void onWallChanged(int x, int z);
+
+    //mark the pockets the next search may enter
+    void beginQuery(glm::vec2 start, glm::vec2 goal);
+    bool skip(int x, int z) const;
+
+    int pocketAt(int x, int z) const;
+    int pocketCount() const { return (int)(m_pockets.size() - m_freePockets.size()); }
+    //pruned walkable cells / all walkable cells
+    float prunedFraction() const;
+
+private:
+    struct Pocket
+    {
+        int parent = MAIN;
+        int entrance = -1;
+        int rootPoly = -1;
+        int cells = 0;
+        uint32_t allowed = 0;
+    };
+
+    void resize(size_t polys);
+    int allocPocket(const Pocket& pocket);
+    int commonPocket(int a, int b) const;
+    bool inRegion(int poly) const { return m_region[poly] == m_regionStamp; }
+    //a connected part of the region, restarted from its centroid
+    void analyseComponent(int root, std::vector<int>& created);
+    //entranceRoot: root is the entrance of the region, every region subtree hanging off it is a pocket
+    void analyse(int root, bool entranceRoot, std::vector<int>& created);
+
+    NavMesh& m_navMesh;
+    std::vector<int> m_polyPocket;
+    std::vector<Pocket> m_pockets;
+    std::vector<int> m_freePockets;
+    uint32_t m_queryStamp = 0;
+
+    //rectangles analyse may enter, every alive one during build()
+    std::vector<uint32_t> m_region;
+    std::vector<uint32_t> m_done;
+    uint32_t m_regionStamp = 0;
+    std::vector<int> m_regionPolys;
+    //cells of the unchanged pockets hanging off a region rectangle
+    std::vector<int> m_hanging;
+    std::vector<uint32_t> m_created;
+    std::vector<uint32_t> m_pocketMark;
+    std::vector<uint32_t> m_keptMark;
+
+    //scratch for the articulation point dfs
+    std::vector<uint32_t> m_visited;
+    uint32_t m_visitStamp = 0;
+    std::vector<int> m_disc;
+    std::vector<int> m_low;
+    std::vector<int> m_dfsParent;
+    std::vector<int> m_subtree;
+    std::vector<int> m_order;
+};
@@ -0,0 +1,201 @@
+#include "distanceTable.h"
+#include "grid.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <new>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+namespace
+{
+    constexpr size_t CACHE_LINE = 64;
+}
+
+void DistanceTable::AlignedDelete::operator()(int* p) const
+{
+    ::operator delete[](p, std::align_val_t(CACHE_LINE));
+}
+
+void DistanceTable::compute(const Grid& grid, const std::vector<glm::vec2>& sources, const std::vector<glm::vec2>& targets, int threads)
+{
+    const int size = grid.getSize();
+
+    m_sources = (int)sources.size();
+    m_targets = (int)targets.size();
+    const int perLine = (int)(CACHE_LINE / sizeof(int));
+    m_stride = (m_targets + perLine - 1) / perLine * perLine;
+
+    size_t count = std::max<size_t>((size_t)m_sources * m_stride, 1);
+    m_data.reset(static_cast<int*>(::operator new[](count * sizeof(int), std::align_val_t(CACHE_LINE))));
+    std::fill(m_data.get(), m_data.get() + count, UNREACHABLE);
+    if (m_sources == 0 || m_targets == 0 || size == 0)
+        return;
+
+    //distances are symmetric, the searches start from the smaller set and write their column when it's the targets
+    const bool swapped = targets.size() < sources.size();
+    const std::vector<glm::vec2>& from = swapped ? targets : sources;
+    const std::vector<glm::vec2>& to = swapped ? sources : targets;
+    const int fromCount = (int)from.size();
+    const int toCount = (int)to.size();
+    int* data = m_data.get();
+    const size_t stride = m_stride;
+    auto out = [data, stride, swapped](int f, int t) -> int& {
+        return swapped ? data[(size_t)t * stride + f] : data[(size_t)f * stride + t];
+        };
+
+    //flat copies of the walls and targets, read by every worker.
+    //the wall copy gets a one cell blocked border so neighbours never need bounds checks
+    const int width = size + 2;
+    const size_t padded = (size_t)width * (size + 2);
+    std::vector<uint8_t> blocked(padded, 1);
+    //walls above and left of every corner, a target with no wall in the box around it and the source is at manhattan distance
+    const size_t corners = (size_t)size + 1;
+    std::vector<uint32_t> wallsBefore(corners * corners, 0);
+    for (int z = 0; z < size; z++)
+    {
+        uint32_t rowWalls = 0;
+        for (int x = 0; x < size; x++)
+        {
+            bool wall = grid.wall(x, z);
+            blocked[(size_t)(z + 1) * width + x + 1] = wall;
+            rowWalls += wall;
+            wallsBefore[(size_t)(z + 1) * corners + x + 1] = wallsBefore[(size_t)z * corners + x + 1] + rowWalls;
+        }
+    }
+    auto boxFree = [&wallsBefore, corners](int ax, int az, int bx, int bz) {
+        int x0 = std::min(ax, bx), x1 = std::max(ax, bx) + 1;
+        int z0 = std::min(az, bz), z1 = std::max(az, bz) + 1;
+        return wallsBefore[(size_t)z1 * corners + x1] - wallsBefore[(size_t)z0 * corners + x1]
+            - wallsBefore[(size_t)z1 * corners + x0] + wallsBefore[(size_t)z0 * corners + x0] == 0;
+        };
+
+    auto cellOf = [size, width](const glm::vec2& t) {
+        int x = (int)t.x, z = (int)t.y;
+        if (x < 0 || z < 0 || x >= size || z >= size)
+            return (int64_t)-1;
+        return (int64_t)(z + 1) * width + x + 1;
+        };
+
+    //(cell, column) sorted by cell, a target cell can appear in several columns.
+    //distinct cells get an index, their columns are targetColumns[firstColumn[i]] up to firstColumn[i + 1]
+    std::vector<std::pair<int64_t, int>> targetColumns;
+    std::vector<uint64_t> isTarget((padded + 63) / 64, 0);
+    for (int i = 0; i < toCount; i++)
+    {
+        int64_t cell = cellOf(to[i]);
+        if (cell < 0 || blocked[cell])
+            continue;
+        targetColumns.push_back({ cell, i });
+        isTarget[cell >> 6] |= 1ull << (cell & 63);
+    }
+    std::sort(targetColumns.begin(), targetColumns.end());
+    std::vector<int64_t> targetCells;
+    std::vector<int> firstColumn;
+    for (size_t i = 0; i < targetColumns.size(); i++)
+    {
+        if (i == 0 || targetColumns[i].first != targetColumns[i - 1].first)
+        {
+            targetCells.push_back(targetColumns[i].first);
+            firstColumn.push_back((int)i);
+        }
+    }
+    firstColumn.push_back((int)targetColumns.size());
+    const int uniqueTargets = (int)targetCells.size();
+
+    if (threads <= 0)
+        threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, fromCount);
+
+    std::atomic<int> nextSource = 0;
+    auto worker = [&]() {
+        //walls and visited cells in one byte each, so a neighbour costs a single load.
+        //visited cells lie between lo and hi, only that range is copied back for the next source
+        std::vector<uint8_t> closed(blocked);
+        int64_t lo = 0, hi = -1;
+        std::vector<uint8_t> settled(uniqueTargets);
+        std::vector<int64_t> frontier;
+        std::vector<int64_t> next;
+
+        for (int s = nextSource++; s < fromCount; s = nextSource++)
+        {
+            int64_t start = cellOf(from[s]);
+            if (start < 0 || blocked[start] || uniqueTargets == 0)
+                continue;
+
+            auto settle = [&](int target, int dist) {
+                settled[target] = 1;
+                for (int i = firstColumn[target]; i < firstColumn[target + 1]; i++)
+                {
+                    out(s, targetColumns[i].second) = dist;
+                }
+                };
+
+            int remaining = uniqueTargets;
+            int sx = (int)(start % width), sz = (int)(start / width);
+            for (int i = 0; i < uniqueTargets; i++)
+            {
+                int tx = (int)(targetCells[i] % width), tz = (int)(targetCells[i] / width);
+                settled[i] = 0;
+                if (boxFree(sx - 1, sz - 1, tx - 1, tz - 1))
+                {
+                    settle(i, std::abs(tx - sx) + std::abs(tz - sz));
+                    remaining--;
+                }
+            }
+            if (remaining == 0)
+                continue;
+
+            if (lo <= hi)
+                std::memcpy(&closed[lo], &blocked[lo], (size_t)(hi - lo + 1));
+            lo = hi = start;
+            frontier.clear();
+            frontier.push_back(start);
+            closed[start] = 1;
+
+            int dist = 0;
+            while (!frontier.empty() && remaining > 0)
+            {
+                next.clear();
+                for (int64_t cell : frontier)
+                {
+                    if (isTarget[cell >> 6] & (1ull << (cell & 63)))
+                    {
+                        int target = (int)(std::lower_bound(targetCells.begin(), targetCells.end(), cell) - targetCells.begin());
+                        if (!settled[target])
+                        {
+                            settle(target, dist);
+                            remaining--;
+                        }
+                    }
+
+                    const int64_t neighbours[4] = { cell + 1, cell - 1, cell + width, cell - width };
+                    for (int64_t n : neighbours)
+                    {
+                        if (closed[n])
+                            continue;
+                        closed[n] = 1;
+                        next.push_back(n);
+                        lo = std::min(lo, n);
+                        hi = std::max(hi, n);
+                    }
+                }
+                frontier.swap(next);
+                dist++;
+            }
+        }
+        };
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; i++)
+    {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : pool)
+    {
+        t.join();
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+
+class Grid;
+
+/*
+    Many-to-many shortest distances between two tile sets.
+    A target with no wall in the box spanned by it and the source is at manhattan distance,
+    that is one lookup in a table of wall counts. Every source with targets left runs one breadth
+    first search (dijkstra with unit costs) that stops as soon as those are settled.
+    Distances are symmetric, so the searches start from whichever set is smaller.
+    Sources are spread over worker threads, the matrix is flat and rows are padded to whole cache lines.
+
+    Open maps are cheap, 1000 x 1000 on an empty 4096 map takes 0.2 s on one core. Behind walls
+    every search may have to cover the whole floor, around 0.2 s per source on a 4096 map with rooms.
+*/
+class DistanceTable
+{
+public:
+    static constexpr int UNREACHABLE = -1;
+
+    DistanceTable() = default;
+    //threads = 0 uses every hardware thread
+    void compute(const Grid& grid, const std::vector<glm::vec2>& sources, const std::vector<glm::vec2>& targets, int threads = 0);
+
+    int at(int source, int target) const { return m_data.get()[(size_t)source * m_stride + target]; }
+    const int* row(int source) const { return m_data.get() + (size_t)source * m_stride; }
+    int sourceCount() const { return m_sources; }
+    int targetCount() const { return m_targets; }
+    int stride() const { return m_stride; }
+
+private:
+    struct AlignedDelete
+    {
+        void operator()(int* p) const;
+    };
+
+    std::unique_ptr<int, AlignedDelete> m_data;
+    int m_sources = 0;
+    int m_targets = 0;
+    int m_stride = 0;
+};
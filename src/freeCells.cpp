@@ -0,0 +1,258 @@
+#include "freeCells.h"
+#include "grid.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+    //rejection tries in sampleIn before it falls back to counting
+    constexpr int REJECT_TRIES = 8;
+
+    //bits x0..x1 of the word that starts at cell base
+    uint64_t spanMask(int base, int x0, int x1)
+    {
+        int lo = std::max(x0 - base, 0);
+        int hi = std::min(x1 - base, 63);
+        uint64_t upper = hi == 63 ? ~0ull : (1ull << (hi + 1)) - 1;
+        return upper & ~((1ull << lo) - 1);
+    }
+}
+
+FreeCells::FreeCells(const Grid& grid)
+    : m_grid(grid)
+{
+}
+
+void FreeCells::build()
+{
+    m_size = m_grid.getSize();
+    m_layer = m_grid.activeLayer();
+    m_cells.clear();
+    m_slot.assign((size_t)m_size * m_size, -1);
+    m_groups.clear();
+    m_group.clear();
+    m_groupSlot.clear();
+    m_groupsStale = false;
+
+    int words = (m_size + 63) / 64;
+    for (int z = 0; z < m_size; z++)
+    {
+        const uint64_t* row = m_grid.wallRow(m_layer, z);
+        for (int w = 0; w < words; w++)
+        {
+            uint64_t free = ~row[w] & spanMask(w * 64, 0, m_size - 1);
+            while (free)
+            {
+                int64_t cell = (int64_t)z * m_size + w * 64 + std::countr_zero(free);
+                m_slot[cell] = (int64_t)m_cells.size();
+                m_cells.push_back(cell);
+                free &= free - 1;
+            }
+        }
+    }
+    m_built = true;
+}
+
+void FreeCells::clear()
+{
+    m_built = false;
+    m_cells.clear();
+    m_cells.shrink_to_fit();
+    m_slot.clear();
+    m_slot.shrink_to_fit();
+    m_groups.clear();
+    m_group.clear();
+    m_groupSlot.clear();
+    m_groupsStale = false;
+}
+
+void FreeCells::onWallChanged(int x, int z, bool wall)
+{
+    if (!m_built)
+        return;
+
+    int64_t cell = (int64_t)z * m_size + x;
+    if (wall)
+    {
+        if (m_slot[cell] < 0)
+            return;
+        remove(cell);
+        if (!m_group.empty() && m_group[cell] >= 0)
+        {
+            removeFromGroup(cell);
+            m_groupsStale = true;
+        }
+        return;
+    }
+
+    if (m_slot[cell] >= 0)
+        return;
+    add(cell);
+    if (m_group.empty())
+        return;
+
+    //any free neighbour is connected to the new cell now, a second different group means a merge
+    int joined = -1;
+    const int neighbours[4][2] = { { x + 1, z }, { x - 1, z }, { x, z + 1 }, { x, z - 1 } };
+    for (auto& n : neighbours)
+    {
+        if (n[0] < 0 || n[1] < 0 || n[0] >= m_size || n[1] >= m_size)
+            continue;
+        int g = m_group[(size_t)n[1] * m_size + n[0]];
+        if (g < 0)
+            continue;
+        if (joined < 0)
+            joined = g;
+        else if (g != joined)
+            m_groupsStale = true;
+    }
+    if (joined < 0)
+    {
+        joined = (int)m_groups.size();
+        m_groups.emplace_back();
+    }
+    addToGroup(cell, joined);
+}
+
+void FreeCells::add(int64_t cell)
+{
+    m_slot[cell] = (int64_t)m_cells.size();
+    m_cells.push_back(cell);
+}
+
+void FreeCells::remove(int64_t cell)
+{
+    int64_t slot = m_slot[cell];
+    int64_t last = m_cells.back();
+    m_cells[slot] = last;
+    m_slot[last] = slot;
+    m_cells.pop_back();
+    m_slot[cell] = -1;
+}
+
+void FreeCells::addToGroup(int64_t cell, int group)
+{
+    m_group[cell] = group;
+    m_groupSlot[cell] = (int64_t)m_groups[group].size();
+    m_groups[group].push_back(cell);
+}
+
+void FreeCells::removeFromGroup(int64_t cell)
+{
+    std::vector<int64_t>& cells = m_groups[m_group[cell]];
+    int64_t slot = m_groupSlot[cell];
+    int64_t last = cells.back();
+    cells[slot] = last;
+    m_groupSlot[last] = slot;
+    cells.pop_back();
+    m_group[cell] = -1;
+    m_groupSlot[cell] = -1;
+}
+
+bool FreeCells::sample(std::mt19937& rng, glm::ivec2& tile) const
+{
+    if (m_cells.empty())
+        return false;
+    std::uniform_int_distribution<int64_t> pick(0, (int64_t)m_cells.size() - 1);
+    tile = this->tile(pick(rng));
+    return true;
+}
+
+bool FreeCells::sampleIn(int x0, int z0, int x1, int z1, std::mt19937& rng, glm::ivec2& tile) const
+{
+    x0 = std::max(x0, 0);
+    z0 = std::max(z0, 0);
+    x1 = std::min(x1, m_size - 1);
+    z1 = std::min(z1, m_size - 1);
+    if (x0 > x1 || z0 > z1)
+        return false;
+
+    //every try is uniform over the free cells of the rectangle, so is the count below
+    std::uniform_int_distribution<int> pickX(x0, x1);
+    std::uniform_int_distribution<int> pickZ(z0, z1);
+    for (int i = 0; i < REJECT_TRIES; i++)
+    {
+        int x = pickX(rng);
+        int z = pickZ(rng);
+        if (!m_grid.wall(m_layer, x, z))
+        {
+            tile = glm::ivec2(x, z);
+            return true;
+        }
+    }
+
+    int w0 = x0 / 64;
+    int w1 = x1 / 64;
+    long long total = 0;
+    for (int z = z0; z <= z1; z++)
+    {
+        const uint64_t* row = m_grid.wallRow(m_layer, z);
+        for (int w = w0; w <= w1; w++)
+        {
+            total += std::popcount(~row[w] & spanMask(w * 64, x0, x1));
+        }
+    }
+    if (total == 0)
+        return false;
+
+    long long k = std::uniform_int_distribution<long long>(0, total - 1)(rng);
+    for (int z = z0; z <= z1; z++)
+    {
+        const uint64_t* row = m_grid.wallRow(m_layer, z);
+        for (int w = w0; w <= w1; w++)
+        {
+            uint64_t free = ~row[w] & spanMask(w * 64, x0, x1);
+            int n = std::popcount(free);
+            if (k >= n)
+            {
+                k -= n;
+                continue;
+            }
+            for (; k > 0; k--)
+            {
+                free &= free - 1;
+            }
+            tile = glm::ivec2(w * 64 + std::countr_zero(free), z);
+            return true;
+        }
+    }
+    return false;
+}
+
+void FreeCells::setGroups(const std::vector<int>& labels)
+{
+    if (!m_built)
+        build();
+    int count = 0;
+    for (int64_t cell : m_cells)
+    {
+        count = std::max(count, labels[cell] + 1);
+    }
+    m_groups.assign(count, {});
+    m_group.assign((size_t)m_size * m_size, -1);
+    m_groupSlot.assign((size_t)m_size * m_size, -1);
+    for (int64_t cell : m_cells)
+    {
+        if (labels[cell] >= 0)
+            addToGroup(cell, labels[cell]);
+    }
+    m_groupsStale = false;
+}
+
+int64_t FreeCells::groupSize(int group) const
+{
+    if (group < 0 || group >= (int)m_groups.size())
+        return 0;
+    return (int64_t)m_groups[group].size();
+}
+
+bool FreeCells::sampleGroup(int group, std::mt19937& rng, glm::ivec2& tile) const
+{
+    if (groupSize(group) == 0)
+        return false;
+    const std::vector<int64_t>& cells = m_groups[group];
+    int64_t cell = cells[std::uniform_int_distribution<int64_t>(0, (int64_t)cells.size() - 1)(rng)];
+    tile = glm::ivec2(cell % m_size, cell / m_size);
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <random>
+#include <cstdint>
+
+class Grid;
+
+/*
+    Walkable cells of one floor, for picking random tiles without scanning the map.
+    Free cells sit in one dense array and m_slot maps a cell back to its entry, so a wall edit
+    is a swap with the last entry and uniform sampling is a single random index.
+
+    Cells can also be grouped by a label per cell (components from PathPlanner), every group keeps
+    its own dense array the same way. A freed cell joins the group of a free neighbour. When it
+    connects two groups, or a new wall may have split one, groupsStale() says so and the owner
+    of the labels hands in new ones.
+*/
+class FreeCells
+{
+public:
+    FreeCells(const Grid& grid);
+    //indexes the active floor
+    void build();
+    //drops the index, Grid does this on loads and rebuilds it on the next use
+    void clear();
+    bool built() const { return m_built; }
+    int layer() const { return m_built ? m_layer : -1; }
+    //Grid::setWall calls this for edits on the indexed floor
+    void onWallChanged(int x, int z, bool wall);
+
+    int64_t count() const { return (int64_t)m_cells.size(); }
+    glm::ivec2 tile(int64_t index) const { return glm::ivec2(m_cells[index] % m_size, m_cells[index] / m_size); }
+    //false when there is no free cell to pick
+    bool sample(std::mt19937& rng, glm::ivec2& tile) const;
+    //inclusive rectangle, a few rejection tries then an exact count over the wall bits
+    bool sampleIn(int x0, int z0, int x1, int z1, std::mt19937& rng, glm::ivec2& tile) const;
+
+    //labels hold a group per cell, anything negative for walls
+    void setGroups(const std::vector<int>& labels);
+    bool hasGroups() const { return !m_group.empty(); }
+    bool groupsStale() const { return m_groupsStale; }
+    int group(int x, int z) const { return m_group.empty() ? -1 : m_group[(size_t)z * m_size + x]; }
+    int64_t groupSize(int group) const;
+    bool sampleGroup(int group, std::mt19937& rng, glm::ivec2& tile) const;
+
+private:
+    void add(int64_t cell);
+    void remove(int64_t cell);
+    void addToGroup(int64_t cell, int group);
+    void removeFromGroup(int64_t cell);
+
+    const Grid& m_grid;
+    int m_size = 0;
+    int m_layer = 0;
+    bool m_built = false;
+
+    //cells and slots are 64 bit, a 64k map has more than 2^31 of them
+    std::vector<int64_t> m_cells;
+    //index into m_cells, -1 for walls
+    std::vector<int64_t> m_slot;
+
+    std::vector<std::vector<int64_t>> m_groups;
+    std::vector<int> m_group;
+    std::vector<int64_t> m_groupSlot;
+    bool m_groupsStale = false;
+};
@@ -1,97 +1,333 @@
 #include "grid.h"
-#include <glad.h>
+#include "textMap.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 
-Grid::Grid(float tileSize)
-    : m_tileSize(tileSize)
-    , m_half(0.0f)
-    , m_size(0)
+namespace
 {
-    loadFromFile("assets/grid.txt");
-
-    glGenVertexArrays(1, &m_vao);
-    glGenBuffers(1, &m_vbo);
-    glGenBuffers(1, &m_ebo);
-
-    glBindVertexArray(m_vao);
+    constexpr uint32_t MAP_MAGIC = 0x50414D47; //"GMAP"
+    constexpr uint32_t MAP_VERSION = 1;
+    constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(vertex), m_vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), m_indices.data(), GL_STATIC_DRAW);
+    uint64_t mix(uint64_t hash, uint64_t word)
+    {
+        hash = (hash ^ word) * 0x100000001b3ull;
+        return hash ^ (hash >> 29);
+    }
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, position));
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, normal));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, color));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, texCoord));
-    glEnableVertexAttribArray(3);
+    uint64_t mixWords(uint64_t hash, const uint64_t* words, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            hash = mix(hash, words[i]);
+        }
+        return hash;
+    }
 
+    /*
+        Binary map layout, every section starts on a 64 byte boundary:
+        MapHeader, walls (layers * height rows of wordsPerRow uint64), optional costs
+        (layers * height * width uint8, 0 for floors without costs), MapPortal[portalCount].
+        checksum is mixWords over everything after the header, the file is padded to 8 bytes.
+    */
+    struct MapHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        int32_t width;
+        int32_t height;
+        int32_t layers;
+        int32_t wordsPerRow;
+        uint32_t portalCount;
+        uint32_t costLayers; //bit per floor
+        uint64_t wallsOffset;
+        uint64_t costsOffset;
+        uint64_t portalsOffset;
+        uint64_t fileSize;
+        uint64_t checksum;
+    };
+    static_assert(sizeof(MapHeader) % 8 == 0, "the checksum reads the body in 8 byte words");
+
+    struct MapPortal
+    {
+        int32_t fromLayer, fromX, fromZ;
+        int32_t toLayer, toX, toZ;
+        int32_t cost;
+        int32_t twoWay;
+    };
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uint64_t aligned(uint64_t offset)
+    {
+        return (offset + 63) / 64 * 64;
+    }
+}
 
-    glBindVertexArray(0);
+Grid::Grid(float tileSize, const std::string& path)
+    : m_tileSize(tileSize)
+    , m_half(0.0f)
+    , m_size(0)
+    , m_freeCells(*this)
+    , m_rng(std::random_device()())
+{
+    //an empty path leaves the grid for loadFromLines
+    if (!path.empty())
+        loadFromFile(path);
 }
 
 Grid::~Grid() {}
 
+void Grid::resetLayers(int count)
+{
+    m_words = (m_size + 63) / 64;
+    m_owned.assign(count, {});
+    m_bits.assign(count, nullptr);
+    m_ownedCosts.assign(count, {});
+    m_costs.assign(count, nullptr);
+    m_mapped.reset();
+    m_layer = 0;
+    m_freeCells.clear();
+    m_journal.reset(count, m_size);
+}
+
 bool Grid::loadFromFile(const std::string& path)
 {
-    std::ifstream file(path);
-    if (!file.is_open())
-    {
-        std::cout << "Failed to open grid file!\n";
-        return false;
-    }
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(file, line))
+    uint32_t magic = 0;
+    std::ifstream file(path, std::ios::binary);
+    file.read((char*)&magic, sizeof(magic));
+    file.close();
+    if (magic == MAP_MAGIC)
+        return loadBinary(path);
+    return loadFromFiles({ path });
+}
+
+bool Grid::loadFromFiles(const std::vector<std::string>& paths)
+{
+    TextMap map;
+    TextMapReader reader;
+    for (const std::string& path : paths)
     {
-        if (!line.empty())
+        if (!reader.read(path, map))
         {
-            lines.push_back(line);
+            return false;
         }
     }
+    return loadTextMap(map);
+}
 
-    file.close();
+bool Grid::loadFromLines(const std::vector<std::string>& lines)
+{
+    TextMap map;
+    TextMapReader reader;
+    if (!reader.readLines(lines, map))
+        return false;
+    return loadTextMap(map);
+}
 
-    //check if vector is empty
-    if (lines.empty())
+bool Grid::loadTextMap(TextMap& map)
+{
+    //check if there is anything to load
+    if (map.floors.empty())
     {
         std::cout << "lines vector seems to be empty!\n";
         return false;
     }
-    
-    int rows = lines.size();
-    int cols = lines[0].size();
 
-    m_size = cols;
-    m_half = (cols * m_tileSize) / 2.0f;
+    int rows = map.floors[0].height;
+    for (const TextMap::Floor& floor : map.floors)
+    {
+        if (floor.height != rows)
+        {
+            std::cout << "Every floor needs the same size!\n";
+            return false;
+        }
+    }
 
-    m_walls.assign(rows, std::vector<bool>(cols, false));
+    //everything else works on squares, the part outside the map is wall
+    m_width = map.width;
+    m_height = rows;
+    m_size = std::max(m_width, m_height);
+    m_half = (m_size * m_tileSize) / 2.0f;
+    resetLayers((int)map.floors.size());
 
-    for (int z = 0; z < rows; z++)
+    for (size_t layer = 0; layer < map.floors.size(); layer++)
     {
-        for (int x = 0; x < cols; x++)
+        TextMap::Floor& floor = map.floors[layer];
+        if (m_width == m_size && m_height == m_size)
         {
-            m_walls[z][x] = (lines[z][x] == 'x');
+            m_owned[layer] = std::move(floor.bits);
+            m_ownedCosts[layer] = std::move(floor.costs);
         }
+        else
+        {
+            m_owned[layer].assign((size_t)m_size * m_words, 0);
+            for (int z = 0; z < m_size; z++)
+            {
+                uint64_t* row = &m_owned[layer][(size_t)z * m_words];
+                int x0 = 0;
+                if (z < m_height)
+                {
+                    std::copy_n(&floor.bits[(size_t)z * map.words], map.words, row);
+                    x0 = m_width;
+                }
+                for (int x = x0; x < m_size; x++)
+                {
+                    row[x >> 6] |= 1ull << (x & 63);
+                }
+            }
+            if (!floor.costs.empty())
+            {
+                m_ownedCosts[layer].assign((size_t)m_size * m_size, 1);
+                for (int z = 0; z < m_height; z++)
+                {
+                    std::copy_n(&floor.costs[(size_t)z * m_width], m_width, &m_ownedCosts[layer][(size_t)z * m_size]);
+                }
+            }
+        }
+        m_bits[layer] = m_owned[layer].data();
+        if (!m_ownedCosts[layer].empty())
+            m_costs[layer] = m_ownedCosts[layer].data();
+    }
+
+    m_portals.clear();
+    for (const Portal& portal : map.portals)
+    {
+        addPortal(portal);
     }
 
-    //should always be empty at this point but doesn't hurt to clear them.
-    m_vertices.clear();
-    m_indices.clear();
-    generateGrid(m_vertices, m_indices, m_size);
     return true;
 }
 
+bool Grid::loadBinary(const std::string& path, bool verifyChecksum)
+{
+    auto file = std::make_unique<MappedFile>();
+    if (!file->open(path))
+    {
+        std::cout << "Failed to open grid file!\n";
+        return false;
+    }
+
+    MapHeader header;
+    if (file->size() < sizeof(header))
+    {
+        std::cout << "Truncated map " << path << "\n";
+        return false;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    //sections have to sit past the header and inside the file, checked without overflowing
+    auto fits = [&header](uint64_t offset, uint64_t count, uint64_t bytes) {
+        return offset >= sizeof(MapHeader) && offset <= header.fileSize && count <= (header.fileSize - offset) / bytes;
+        };
+    //costLayers is a 32 bit mask, the same 1 to 32 floors saveBinary writes
+    bool valid = header.magic == MAP_MAGIC && header.version == MAP_VERSION && header.width > 0 && header.height > 0
+        && header.layers > 0 && header.layers <= 32 && header.wordsPerRow == (header.width + 63) / 64
+        && header.fileSize == file->size() && header.fileSize % 8 == 0
+        && header.wallsOffset % 64 == 0 && fits(header.wallsOffset, (uint64_t)header.layers * header.height, (uint64_t)header.wordsPerRow * sizeof(uint64_t))
+        && (!header.costLayers || fits(header.costsOffset, (uint64_t)header.layers * header.height, (uint64_t)header.width))
+        && header.portalsOffset % alignof(MapPortal) == 0 && fits(header.portalsOffset, header.portalCount, sizeof(MapPortal));
+    if (!valid)
+    {
+        std::cout << "Bad map header in " << path << "\n";
+        return false;
+    }
+    if (header.width != header.height)
+    {
+        std::cout << "Grids have to be square, " << path << " is " << header.width << "x" << header.height << "\n";
+        return false;
+    }
+    //touches every page, skip it to load lazily
+    const uint64_t* body = (const uint64_t*)(file->data() + sizeof(header));
+    if (verifyChecksum && mixWords(FNV_OFFSET, body, (header.fileSize - sizeof(header)) / 8) != header.checksum)
+    {
+        std::cout << "Checksum mismatch in " << path << "\n";
+        return false;
+    }
+
+    m_size = header.width;
+    m_width = m_size;
+    m_height = m_size;
+    m_half = (m_size * m_tileSize) / 2.0f;
+    resetLayers(header.layers);
+    const char* data = file->data();
+    for (int layer = 0; layer < header.layers; layer++)
+    {
+        m_bits[layer] = (const uint64_t*)(data + header.wallsOffset) + (size_t)layer * m_size * m_words;
+        if (header.costLayers & (1u << layer))
+            m_costs[layer] = (const uint8_t*)(data + header.costsOffset) + (size_t)layer * m_size * m_size;
+    }
+    m_mapped = std::move(file);
+
+    m_portals.clear();
+    const MapPortal* portals = (const MapPortal*)(data + header.portalsOffset);
+    for (uint32_t i = 0; i < header.portalCount; i++)
+    {
+        const MapPortal& p = portals[i];
+        addPortal({ p.fromLayer, glm::ivec2(p.fromX, p.fromZ), p.toLayer, glm::ivec2(p.toX, p.toZ), p.cost, p.twoWay != 0 });
+    }
+    return true;
+}
+
+bool Grid::saveBinary(const std::string& path) const
+{
+    if (m_bits.empty() || m_bits.size() > 32)
+    {
+        std::cout << "Binary maps hold 1 to 32 floors\n";
+        return false;
+    }
+
+    MapHeader header = {};
+    header.magic = MAP_MAGIC;
+    header.version = MAP_VERSION;
+    header.width = m_size;
+    header.height = m_size;
+    header.layers = (int32_t)m_bits.size();
+    header.wordsPerRow = m_words;
+    header.portalCount = (uint32_t)m_portals.size();
+    for (size_t layer = 0; layer < m_costs.size(); layer++)
+    {
+        if (m_costs[layer])
+            header.costLayers |= 1u << layer;
+    }
+    size_t layerWords = (size_t)m_size * m_words;
+    size_t layerCells = (size_t)m_size * m_size;
+    header.wallsOffset = aligned(sizeof(header));
+    header.costsOffset = aligned(header.wallsOffset + m_bits.size() * layerWords * sizeof(uint64_t));
+    header.portalsOffset = header.costLayers ? aligned(header.costsOffset + m_bits.size() * layerCells) : header.costsOffset;
+    header.fileSize = (header.portalsOffset + m_portals.size() * sizeof(MapPortal) + 7) / 8 * 8;
+
+    //the body is built in memory so the checksum can go into the header
+    std::vector<uint64_t> body((header.fileSize - sizeof(header)) / 8, 0);
+    auto at = [&](uint64_t offset) { return (char*)body.data() + (offset - sizeof(header)); };
+    for (size_t layer = 0; layer < m_bits.size(); layer++)
+    {
+        std::memcpy(at(header.wallsOffset + layer * layerWords * sizeof(uint64_t)), m_bits[layer], layerWords * sizeof(uint64_t));
+        if (m_costs[layer])
+            std::memcpy(at(header.costsOffset + layer * layerCells), m_costs[layer], layerCells);
+    }
+    for (size_t i = 0; i < m_portals.size(); i++)
+    {
+        const Portal& p = m_portals[i];
+        MapPortal portal = { p.fromLayer, p.from.x, p.from.y, p.toLayer, p.to.x, p.to.y, p.cost, p.twoWay ? 1 : 0 };
+        std::memcpy(at(header.portalsOffset + i * sizeof(MapPortal)), &portal, sizeof(portal));
+    }
+    header.checksum = mixWords(FNV_OFFSET, body.data(), body.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "Failed to write " << path << "\n";
+        return false;
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)body.data(), body.size() * sizeof(uint64_t));
+    return (bool)file;
+}
+
 void Grid::generateGrid(std::vector<vertex>& vertices, std::vector<unsigned int>& indices, int size)
 {
     int sizePerRow = size + 1;
@@ -131,33 +367,6 @@ void Grid::generateGrid(std::vector<vertex>& vertices, std::vector<unsigned int>
     }
 }
 
-void Grid::create()
-{
-        glGenVertexArrays(1, &m_wvao);
-        glGenBuffers(1, &m_wvbo);
-        glGenBuffers(1, &m_webo);
-
-        glBindVertexArray(m_wvao);
-        glBindBuffer(GL_ARRAY_BUFFER, m_wvbo);
-        glBufferData(GL_ARRAY_BUFFER, m_wallVertices.size() * sizeof(vertex), m_wallVertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_webo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_wallIndices.size() * sizeof(unsigned int), m_wallIndices.data(), GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, position));
-        glEnableVertexAttribArray(0);
-
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, normal));
-        glEnableVertexAttribArray(1);
-
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, color));
-        glEnableVertexAttribArray(2);
-
-        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, texCoord));
-        glEnableVertexAttribArray(3);
-
-}
-
 glm::vec3 Grid::getTileWorldPos(int x, int z)
 {
     float worldX = (x + 0.5f) * m_tileSize - m_half;
@@ -165,6 +374,14 @@ glm::vec3 Grid::getTileWorldPos(int x, int z)
     return glm::vec3(worldX, 0.0f, worldZ);
 }
 
+//same as above but for fractional tile positions (navmesh waypoints etc.)
+glm::vec3 Grid::getTileWorldPos(glm::vec2 tile)
+{
+    float worldX = (tile.x + 0.5f) * m_tileSize - m_half;
+    float worldZ = (tile.y + 0.5f) * m_tileSize - m_half;
+    return glm::vec3(worldX, 0.0f, worldZ);
+}
+
 glm::vec2 Grid::getTileIndex(glm::vec3& wPos)
 {
     int x = (int)floor((wPos.x + m_half) / m_tileSize);
@@ -175,30 +392,20 @@ glm::vec2 Grid::getTileIndex(glm::vec3& wPos)
     return glm::vec2(x, z);
 }
 
-glm::vec2 Grid::getWalkableTile()
+bool Grid::getWalkableTile(glm::ivec2& tile)
 {
-    std::vector<glm::vec2> wtiles;
-    for (int y = 0; y < m_size; y++)
-    {
-        for (int x = 0; x < m_size; x++)
-        {
-            if (!wall(x, y))
-            {
-                wtiles.push_back(glm::vec2(x, y));
-            }
-        }
-    }
-
-    if (wtiles.empty())
-    {
-        return glm::vec2(0.0, 0.0);
-    }
+    return freeCells().sample(m_rng, tile);
+}
 
-    int r = rand() % wtiles.size();
-    return wtiles[r];
+FreeCells& Grid::freeCells()
+{
+    //layered searches switch floors back and forth, the index only follows when it's used
+    if (!m_freeCells.built() || m_freeCells.layer() != m_layer)
+        m_freeCells.build();
+    return m_freeCells;
 }
 
-int Grid::getSize()
+int Grid::getSize() const
 {
     return m_size;
 }
@@ -218,25 +425,57 @@ std::vector<unsigned int>& Grid::getWallIndices()
     return m_wallIndices;
 }
 
-bool Grid::wall(int x, int z)
+uint64_t Grid::wallHash() const
 {
-    return m_walls[z][x];
+    //padding bits past the last column are always zero
+    uint64_t hash = mix(FNV_OFFSET, (uint64_t)m_bits.size() << 32 | (uint32_t)m_size);
+    for (const uint64_t* bits : m_bits)
+    {
+        hash = mixWords(hash, bits, (size_t)m_size * m_words);
+    }
+    return hash;
 }
 
 void Grid::setWall(int x, int z, bool value)
 {
-    m_walls[z][x] = value;
+    setWall(m_layer, x, z, value);
+}
+
+void Grid::setWall(int layer, int x, int z, bool value)
+{
+    //a floor still in the mapped file is copied out on its first edit
+    if (m_owned[layer].empty())
+    {
+        m_owned[layer].assign(m_bits[layer], m_bits[layer] + (size_t)m_size * m_words);
+        m_bits[layer] = m_owned[layer].data();
+    }
+    uint64_t& word = m_owned[layer][(size_t)z * m_words + (x >> 6)];
+    uint64_t bit = 1ull << (x & 63);
+    if (((word & bit) != 0) == value)
+        return;
+    word = value ? word | bit : word & ~bit;
+    if (layer == m_freeCells.layer())
+        m_freeCells.onWallChanged(x, z, value);
+    m_journal.record(layer, x, z);
 }
 
-void Grid::draw()
+void Grid::setActiveLayer(int layer)
 {
-    glBindVertexArray(m_vao);
-    glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0);
+    if (layer >= 0 && layer < (int)m_bits.size())
+    {
+        m_layer = layer;
+    }
 }
 
-void Grid::drawWall()
+void Grid::addPortal(const Portal& portal)
 {
-    glBindVertexArray(m_wvao);
-    //glDrawArrays(GL_TRIANGLES, 0, size);
-    glDrawElements(GL_TRIANGLES, m_wallIndices.size(), GL_UNSIGNED_INT, 0);
+    auto inside = [this](int layer, glm::ivec2 tile) {
+        return layer >= 0 && layer < (int)m_bits.size() && tile.x >= 0 && tile.y >= 0 && tile.x < m_size && tile.y < m_size;
+        };
+    if (!inside(portal.fromLayer, portal.from) || !inside(portal.toLayer, portal.to) || portal.cost < 0)
+    {
+        std::cout << "Portal outside the floors, skipped\n";
+        return;
+    }
+    m_portals.push_back(portal);
 }
@@ -2,7 +2,15 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <string>
-#include "cubeVerts.h"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include "vertex.h"
+#include "mappedFile.h"
+#include "freeCells.h"
+#include "gridJournal.h"
+
+struct TextMap;
 
 //struct vertex
 //{
@@ -11,6 +19,21 @@
 //    glm::vec2 texCoord;
 //};
 
+/*
+    A grid file holds one or more floors. Every line starting with '#' starts a new floor
+    (a file without one is a single floor) and lines like
+        portal 0 3 4 1 3 4 [cost] [oneway]
+    connect (x, z) on one floor to (x, z) on another, stairs by default and teleporters with oneway.
+    Floor numbers count across every file passed to loadFromFiles.
+    Digits 1-9 in a row are walkable tiles with that move cost, a floor with any digit gets a cost layer.
+    wall(x, z) and everything built on it sees the active floor only.
+
+    Grids are square, a map that isn't is padded with walls on the right or bottom,
+    width() and height() are its size in the file. MovingAI .map files load as a single floor.
+
+    Walls are bit packed rows of 64 cell words. A binary map (see saveBinary) is mapped and used
+    in place, a floor is only copied out of the file the first time one of its walls is set.
+*/
 class Grid
 {
 public:
@@ -20,25 +43,68 @@ public:
         PLAYING,
         END
     };
+
+    struct Portal
+    {
+        int fromLayer = 0;
+        glm::ivec2 from = glm::ivec2(0);
+        int toLayer = 0;
+        glm::ivec2 to = glm::ivec2(0);
+        int cost = 1;
+        bool twoWay = true;
+    };
    
-    Grid(float tileSize);
+    Grid(float tileSize, const std::string& path = "assets/grid.txt");
     ~Grid();
     bool loadFromFile(const std::string& path);
+    bool loadFromFiles(const std::vector<std::string>& paths);
+    //one floor from rows already in memory, same characters as the file
+    bool loadFromLines(const std::vector<std::string>& lines);
+    //takes the bits of a map built in memory, the floors are moved out of it
+    bool loadTextMap(TextMap& map);
+    //binary maps, loadFromFile picks loadBinary by the magic at the start of the file
+    bool loadBinary(const std::string& path, bool verifyChecksum = true);
+    bool saveBinary(const std::string& path) const;
     void generateGrid(std::vector<vertex>& vertices, std::vector<unsigned int>& indices, int size);
+    //uploads the floor and wall meshes, everything gl lives in gridRender.cpp
     void create();
     glm::vec3 getTileWorldPos(int x, int z);
+    glm::vec3 getTileWorldPos(glm::vec2 tile);
     glm::vec2 getTileIndex(glm::vec3& wPos);
-    glm::vec2 getWalkableTile();
-    int getSize();
+    //uniform random free tile of the active floor, false when there is none
+    bool getWalkableTile(glm::ivec2& tile);
+    //index of the active floor, built on first use and kept up to date by setWall
+    FreeCells& freeCells();
+    //wrap batches of setWall in journal().begin()/commit(), flush() it once per frame
+    GridJournal& journal() { return m_journal; }
+    int getSize() const;
+    int width() const { return m_width; }
+    int height() const { return m_height; }
     void setState(GameState state);
     GameState state() const { return m_state; }
     std::vector<vertex>& getWallVerts();
     std::vector<unsigned int>& getWallIndices();
-    bool wall(int x, int z);
+    bool wall(int x, int z) const { return wall(m_layer, x, z); }
     void setWall(int x, int z, bool value);
+    bool wall(int layer, int x, int z) const { return (m_bits[layer][(size_t)z * m_words + (x >> 6)] >> (x & 63)) & 1; }
+    void setWall(int layer, int x, int z, bool value);
+    //m_words words, cell x is bit x & 63 of word x >> 6
+    const uint64_t* wallRow(int layer, int z) const { return m_bits[layer] + (size_t)z * m_words; }
+    //1 on floors without a cost layer
+    int cost(int x, int z) const { return m_costs[m_layer] ? m_costs[m_layer][(size_t)z * m_size + x] : 1; }
+    bool hasCosts(int layer) const { return m_costs[layer] != nullptr; }
+    int layerCount() const { return (int)m_bits.size(); }
+    int activeLayer() const { return m_layer; }
+    void setActiveLayer(int layer);
+    //changes whenever any wall on any floor does, keys the navcache
+    uint64_t wallHash() const;
+    const std::vector<Portal>& portals() const { return m_portals; }
+    void addPortal(const Portal& portal);
     void draw();
     void drawWall();
 private:
+    void resetLayers(int count);
+
     std::vector<vertex> m_vertices;
     std::vector<unsigned int> m_indices;
     std::vector<vertex> m_wallVertices;
@@ -48,8 +114,21 @@ private:
     float m_tileSize = 0.0f;
     float m_half = 0.0f;
     int m_size = 0;
+    int m_width = 0;
+    int m_height = 0;
 
-    std::vector<std::vector<bool>> m_walls;
+    //rows of m_words words, m_bits points at m_owned or into m_mapped
+    int m_words = 0;
+    std::vector<std::vector<uint64_t>> m_owned;
+    std::vector<const uint64_t*> m_bits;
+    std::vector<std::vector<uint8_t>> m_ownedCosts;
+    std::vector<const uint8_t*> m_costs;
+    std::unique_ptr<MappedFile> m_mapped;
+    int m_layer = 0;
+    FreeCells m_freeCells;
+    std::mt19937 m_rng;
+    GridJournal m_journal;
+    std::vector<Portal> m_portals;
     GameState m_state = GameState::MENU;
 
 };
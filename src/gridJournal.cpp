@@ -0,0 +1,127 @@
+#include "gridJournal.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+void GridJournal::begin()
+{
+    m_depth++;
+}
+
+void GridJournal::commit()
+{
+    if (m_depth == 0 || --m_depth > 0)
+        return;
+    if (m_open.empty())
+        return;
+    m_committed.insert(m_committed.end(), m_open.begin(), m_open.end());
+    m_open.clear();
+    m_revision++;
+}
+
+void GridJournal::record(int layer, int x, int z)
+{
+    if (m_depth > 0)
+    {
+        m_open.push_back({ layer, x, z });
+        return;
+    }
+    m_committed.push_back({ layer, x, z });
+    m_revision++;
+}
+
+void GridJournal::reset(int layers, int size)
+{
+    //cells of the old map mean nothing now, an open transaction is dropped with them
+    m_open.clear();
+    m_committed.clear();
+    m_depth = 0;
+    m_resetLayers = layers;
+    m_resetSize = size;
+    m_revision++;
+    m_resetRevision = m_revision;
+}
+
+int GridJournal::subscribe(Listener listener)
+{
+    m_subscribers.push_back({ m_nextId, std::move(listener), m_revision });
+    return m_nextId++;
+}
+
+void GridJournal::unsubscribe(int id)
+{
+    m_subscribers.erase(std::remove_if(m_subscribers.begin(), m_subscribers.end(),
+        [id](const Subscriber& s) { return s.id == id; }), m_subscribers.end());
+}
+
+void GridJournal::flush()
+{
+    if (!pending())
+        return;
+
+    //cells committed since the reset go to the subscribers that came after it
+    m_resetRects.clear();
+    bool reset = m_resetLayers > 0;
+    if (reset)
+    {
+        for (int layer = 0; layer < m_resetLayers; layer++)
+        {
+            m_resetRects.push_back({ layer, 0, 0, m_resetSize - 1, m_resetSize - 1 });
+        }
+        m_resetLayers = 0;
+    }
+    m_rects.clear();
+    coalesce(m_rects);
+
+    //a subscriber may edit walls again, those land in the next flush
+    for (size_t i = 0; i < m_subscribers.size(); i++)
+    {
+        if (reset && m_subscribers[i].since < m_resetRevision)
+            m_subscribers[i].listener(m_resetRects, m_revision);
+        else if (!m_rects.empty())
+            m_subscribers[i].listener(m_rects, m_revision);
+    }
+}
+
+void GridJournal::coalesce(std::vector<DirtyRect>& rects)
+{
+    std::sort(m_committed.begin(), m_committed.end(), [](const Cell& a, const Cell& b) {
+        if (a.layer != b.layer)
+            return a.layer < b.layer;
+        if (a.z != b.z)
+            return a.z < b.z;
+        return a.x < b.x;
+        });
+
+    //runs of touching cells in a row, a run grows down when the row below has one with the same span
+    std::unordered_map<uint64_t, size_t> below;
+    auto key = [](int layer, int x0, int x1) {
+        return ((uint64_t)(uint32_t)layer << 48) ^ ((uint64_t)(uint32_t)x0 << 24) ^ (uint64_t)(uint32_t)x1;
+        };
+    size_t i = 0;
+    while (i < m_committed.size())
+    {
+        const Cell& first = m_committed[i];
+        int x1 = first.x;
+        size_t j = i + 1;
+        while (j < m_committed.size() && m_committed[j].layer == first.layer && m_committed[j].z == first.z && m_committed[j].x <= x1 + 1)
+        {
+            x1 = std::max(x1, m_committed[j].x);
+            j++;
+        }
+
+        auto it = below.find(key(first.layer, first.x, x1));
+        if (it != below.end() && rects[it->second].layer == first.layer && rects[it->second].x0 == first.x
+            && rects[it->second].x1 == x1 && rects[it->second].z1 == first.z - 1)
+        {
+            rects[it->second].z1 = first.z;
+        }
+        else
+        {
+            below[key(first.layer, first.x, x1)] = rects.size();
+            rects.push_back({ first.layer, first.x, first.z, x1, first.z });
+        }
+        i = j;
+    }
+    m_committed.clear();
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+/*
+    Change journal of a Grid, for everything derived from the walls (path caches, component labels,
+    distance fields, render data) that would rather patch a region than rebuild.
+    Grid::setWall records every wall that actually flips. Edits between begin() and commit() are one
+    transaction and bump the revision once, an edit outside of one is its own transaction.
+    flush() is meant to run once per frame: it coalesces the committed cells into as few exact
+    rectangles as it can (row runs, then runs with the same span stacked in consecutive rows)
+    and hands them to every subscriber in one call.
+    A subscriber only hears about resets that happen after it subscribed, whatever it built
+    from the grid before that is already current.
+*/
+class GridJournal
+{
+public:
+    //inclusive cell rectangle on one floor
+    struct DirtyRect
+    {
+        int layer;
+        int x0;
+        int z0;
+        int x1;
+        int z1;
+    };
+
+    using Listener = std::function<void(const std::vector<DirtyRect>& rects, uint64_t revision)>;
+
+    //transactions nest, only the outermost commit counts
+    void begin();
+    void commit();
+    bool inTransaction() const { return m_depth > 0; }
+    //called by Grid::setWall
+    void record(int layer, int x, int z);
+    //a new map was loaded, the next flush reports every floor as dirty
+    void reset(int layers, int size);
+
+    uint64_t revision() const { return m_revision; }
+    bool pending() const { return !m_committed.empty() || m_resetLayers > 0; }
+
+    int subscribe(Listener listener);
+    void unsubscribe(int id);
+    //runs the subscribers with everything committed since the last flush
+    void flush();
+
+private:
+    struct Cell
+    {
+        int layer;
+        int x;
+        int z;
+    };
+
+    void coalesce(std::vector<DirtyRect>& rects);
+
+    int m_depth = 0;
+    uint64_t m_revision = 0;
+    std::vector<Cell> m_open;
+    std::vector<Cell> m_committed;
+    int m_resetLayers = 0;
+    int m_resetSize = 0;
+    uint64_t m_resetRevision = 0;
+
+    struct Subscriber
+    {
+        int id;
+        Listener listener;
+        //revision at subscribe time
+        uint64_t since;
+    };
+    int m_nextId = 1;
+    std::vector<Subscriber> m_subscribers;
+    std::vector<DirtyRect> m_rects;
+    std::vector<DirtyRect> m_resetRects;
+};
@@ -0,0 +1,72 @@
+#include "grid.h"
+#include <glad.h>
+
+void Grid::create()
+{
+    //should always be empty at this point but doesn't hurt to clear them.
+    m_vertices.clear();
+    m_indices.clear();
+    generateGrid(m_vertices, m_indices, m_size);
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ebo);
+
+    glBindVertexArray(m_vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(vertex), m_vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), m_indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, texCoord));
+    glEnableVertexAttribArray(3);
+
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(0);
+
+    glGenVertexArrays(1, &m_wvao);
+    glGenBuffers(1, &m_wvbo);
+    glGenBuffers(1, &m_webo);
+
+    glBindVertexArray(m_wvao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_wvbo);
+    glBufferData(GL_ARRAY_BUFFER, m_wallVertices.size() * sizeof(vertex), m_wallVertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_webo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_wallIndices.size() * sizeof(unsigned int), m_wallIndices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, position));
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, normal));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, color));
+    glEnableVertexAttribArray(2);
+
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, texCoord));
+    glEnableVertexAttribArray(3);
+}
+
+void Grid::draw()
+{
+    glBindVertexArray(m_vao);
+    glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0);
+}
+
+void Grid::drawWall()
+{
+    glBindVertexArray(m_wvao);
+    //glDrawArrays(GL_TRIANGLES, 0, size);
+    glDrawElements(GL_TRIANGLES, m_wallIndices.size(), GL_UNSIGNED_INT, 0);
+}
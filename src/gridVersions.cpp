@@ -0,0 +1,202 @@
+#include "gridVersions.h"
+#include "grid.h"
+
+#include <algorithm>
+#include <thread>
+
+GridVersions::Pin::Pin(Pin&& other) noexcept
+    : m_owner(other.m_owner)
+    , m_slot(other.m_slot)
+    , m_snapshot(other.m_snapshot)
+{
+    other.m_owner = nullptr;
+    other.m_slot = -1;
+    other.m_snapshot = nullptr;
+}
+
+GridVersions::Pin& GridVersions::Pin::operator=(Pin&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_owner = other.m_owner;
+        m_slot = other.m_slot;
+        m_snapshot = other.m_snapshot;
+        other.m_owner = nullptr;
+        other.m_slot = -1;
+        other.m_snapshot = nullptr;
+    }
+    return *this;
+}
+
+GridVersions::Pin::~Pin()
+{
+    release();
+}
+
+void GridVersions::Pin::release()
+{
+    if (m_owner)
+        m_owner->unpin(m_slot);
+    m_owner = nullptr;
+    m_slot = -1;
+    m_snapshot = nullptr;
+}
+
+GridVersions::GridVersions(const Grid& grid, int maxReaders)
+    : m_slotCount(std::max(1, maxReaders))
+{
+    m_size = grid.getSize();
+    m_tiles = (m_size + GridSnapshot::TILE - 1) / GridSnapshot::TILE;
+    m_slots.reset(new std::atomic<uint64_t>[m_slotCount]);
+    for (int i = 0; i < m_slotCount; i++)
+    {
+        m_slots[i].store(FREE);
+    }
+
+    //grid rows are already 64 cell words, tile tx of a row is word tx
+    auto first = std::make_unique<GridSnapshot>();
+    first->m_size = m_size;
+    first->m_rows.resize(m_tiles);
+    int layer = grid.activeLayer();
+    for (int tz = 0; tz < m_tiles; tz++)
+    {
+        auto row = std::make_shared<GridSnapshot::TileRow>();
+        row->tiles.resize(m_tiles);
+        for (int tx = 0; tx < m_tiles; tx++)
+        {
+            auto tile = std::make_shared<GridSnapshot::Tile>();
+            for (int r = 0; r < GridSnapshot::TILE; r++)
+            {
+                int z = tz * GridSnapshot::TILE + r;
+                tile->rows[r] = z < m_size ? grid.wallRow(layer, z)[tx] : ~0ull;
+            }
+            row->tiles[tx] = tile;
+        }
+        first->m_rows[tz] = row;
+    }
+    m_current.store(first.release());
+    m_rowBatch.assign(m_tiles, 0);
+    m_tileBatch.assign((size_t)m_tiles * m_tiles, 0);
+}
+
+GridVersions::~GridVersions()
+{
+    //pins must be gone by now, nothing is left to wait for
+    delete m_current.load();
+}
+
+GridVersions::Pin GridVersions::pin()
+{
+    Pin pin;
+    pin.m_owner = this;
+    while (pin.m_slot < 0)
+    {
+        for (int i = 0; i < m_slotCount; i++)
+        {
+            uint64_t expected = FREE;
+            uint64_t epoch = m_epoch.load();
+            if (m_slots[i].compare_exchange_strong(expected, epoch))
+            {
+                pin.m_slot = i;
+                break;
+            }
+        }
+        if (pin.m_slot < 0)
+            std::this_thread::yield();
+    }
+
+    //the announced epoch has to be the one the pointer is read in, otherwise a publish in
+    //between could retire the version before the slot shows it
+    while (true)
+    {
+        uint64_t epoch = m_epoch.load();
+        m_slots[pin.m_slot].store(epoch);
+        if (m_epoch.load() == epoch)
+            break;
+    }
+    pin.m_snapshot = m_current.load();
+    return pin;
+}
+
+void GridVersions::unpin(int slot)
+{
+    m_slots[slot].store(FREE, std::memory_order_release);
+}
+
+bool GridVersions::wall(int x, int z) const
+{
+    return m_staged ? m_staged->wall(x, z) : m_current.load(std::memory_order_relaxed)->wall(x, z);
+}
+
+void GridVersions::setWall(int x, int z, bool value)
+{
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size || wall(x, z) == value)
+        return;
+
+    if (!m_staged)
+    {
+        //the top table is the only thing copied whole
+        const GridSnapshot* current = m_current.load(std::memory_order_relaxed);
+        m_staged = std::make_unique<GridSnapshot>();
+        m_staged->m_size = m_size;
+        m_staged->m_rows = current->m_rows;
+        m_batch++;
+    }
+
+    int tx = x / GridSnapshot::TILE;
+    int tz = z / GridSnapshot::TILE;
+    if (m_rowBatch[tz] != m_batch)
+    {
+        m_staged->m_rows[tz] = std::make_shared<GridSnapshot::TileRow>(*m_staged->m_rows[tz]);
+        m_rowBatch[tz] = m_batch;
+        m_stats.rowsCopied++;
+        m_stats.bytesCopied += m_tiles * sizeof(std::shared_ptr<const GridSnapshot::Tile>);
+    }
+    //staged rows and tiles are private copies until publish, casting the const away is safe here
+    auto row = std::const_pointer_cast<GridSnapshot::TileRow>(m_staged->m_rows[tz]);
+    size_t tileIndex = (size_t)tz * m_tiles + tx;
+    if (m_tileBatch[tileIndex] != m_batch)
+    {
+        row->tiles[tx] = std::make_shared<GridSnapshot::Tile>(*row->tiles[tx]);
+        m_tileBatch[tileIndex] = m_batch;
+        m_stats.tilesCopied++;
+        m_stats.bytesCopied += sizeof(GridSnapshot::Tile);
+    }
+    auto tile = std::const_pointer_cast<GridSnapshot::Tile>(row->tiles[tx]);
+    uint64_t& word = tile->rows[z & 63];
+    uint64_t bit = 1ull << (x & 63);
+    word = value ? word | bit : word & ~bit;
+}
+
+void GridVersions::publish()
+{
+    if (!m_staged)
+        return;
+
+    m_stats.published++;
+    m_stats.bytesCopied += m_tiles * sizeof(std::shared_ptr<const GridSnapshot::TileRow>);
+    m_staged->m_version = ++m_version;
+    const GridSnapshot* old = m_current.exchange(m_staged.release());
+    //readers that announce the new epoch can only load the new pointer
+    m_retired.push_back({ m_epoch.fetch_add(1), std::unique_ptr<const GridSnapshot>(old) });
+    reclaim();
+}
+
+void GridVersions::reclaim()
+{
+    uint64_t oldest = FREE;
+    for (int i = 0; i < m_slotCount; i++)
+    {
+        oldest = std::min(oldest, m_slots[i].load());
+    }
+
+    //retired in epoch order, a version retired at e is only visible to readers that announced e or less
+    size_t freed = 0;
+    while (freed < m_retired.size() && m_retired[freed].epoch < oldest)
+    {
+        freed++;
+    }
+    m_retired.erase(m_retired.begin(), m_retired.begin() + freed);
+    m_stats.reclaimed += freed;
+}
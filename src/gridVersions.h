@@ -0,0 +1,135 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+class Grid;
+
+/*
+    One immutable version of the walls of a floor, in 64x64 tiles of one word per row.
+    Tiles and rows of tiles are shared with the versions before and after it, a version only
+    owns what was edited since the last one.
+*/
+class GridSnapshot
+{
+public:
+    static constexpr int TILE = 64;
+
+    bool wall(int x, int z) const { return (m_rows[z >> 6]->tiles[x >> 6]->rows[z & 63] >> (x & 63)) & 1; }
+    int getSize() const { return m_size; }
+    uint64_t version() const { return m_version; }
+
+private:
+    friend class GridVersions;
+
+    struct Tile
+    {
+        uint64_t rows[TILE];
+    };
+
+    struct TileRow
+    {
+        std::vector<std::shared_ptr<const Tile>> tiles;
+    };
+
+    int m_size = 0;
+    uint64_t m_version = 0;
+    std::vector<std::shared_ptr<const TileRow>> m_rows;
+};
+
+/*
+    Copy-on-write versions of a grid so searches on worker threads never race the main thread's edits.
+    Readers pin() the current version and see exactly that one until the pin is dropped, they never
+    block and never write anything shared apart from their own epoch slot.
+    The single writer stages edits with setWall and publish() swaps them in. A publish copies the
+    top row table (size / 64 pointers), the tile rows it touched and the tiles it touched,
+    everything else is shared, so its cost follows the edited area and not the map size.
+
+    Old versions are reclaimed with epochs: a reader announces the epoch it pinned in, publish
+    retires the old version at the current epoch and bumps it, a retired version is freed once every
+    announced epoch is past the one it was retired at. Only the writer frees, so the shared tiles
+    are refcounted on the writer thread alone.
+*/
+class GridVersions
+{
+public:
+    struct Stats
+    {
+        long long published = 0;
+        long long rowsCopied = 0;
+        long long tilesCopied = 0;
+        long long bytesCopied = 0;
+        long long reclaimed = 0;
+    };
+
+    //keeps the version it was pinned on alive, move only
+    class Pin
+    {
+    public:
+        Pin() = default;
+        Pin(Pin&& other) noexcept;
+        Pin& operator=(Pin&& other) noexcept;
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+        ~Pin();
+
+        const GridSnapshot& operator*() const { return *m_snapshot; }
+        const GridSnapshot* operator->() const { return m_snapshot; }
+        explicit operator bool() const { return m_snapshot != nullptr; }
+        void release();
+
+    private:
+        friend class GridVersions;
+        GridVersions* m_owner = nullptr;
+        int m_slot = -1;
+        const GridSnapshot* m_snapshot = nullptr;
+    };
+
+    //copies the active floor of grid, maxReaders is how many pins can be held at once
+    GridVersions(const Grid& grid, int maxReaders = 256);
+    ~GridVersions();
+
+    //any thread, spins only when every reader slot is taken
+    Pin pin();
+
+    //writer thread only, edits stay invisible to readers until publish
+    void setWall(int x, int z, bool value);
+    bool wall(int x, int z) const;
+    void publish();
+    //frees retired versions no reader can see any more, publish calls it too
+    void reclaim();
+
+    int getSize() const { return m_size; }
+    uint64_t version() const { return m_version; }
+    size_t retiredCount() const { return m_retired.size(); }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    static constexpr uint64_t FREE = ~0ull;
+
+    struct Retired
+    {
+        uint64_t epoch;
+        std::unique_ptr<const GridSnapshot> snapshot;
+    };
+
+    void unpin(int slot);
+
+    int m_size = 0;
+    int m_tiles = 0;
+    uint64_t m_version = 0;
+    std::atomic<const GridSnapshot*> m_current{ nullptr };
+    std::atomic<uint64_t> m_epoch{ 1 };
+    //announced epoch per pin, FREE when the slot is unused
+    std::unique_ptr<std::atomic<uint64_t>[]> m_slots;
+    int m_slotCount = 0;
+    std::vector<Retired> m_retired;
+
+    //writer side, the next version and which of its rows and tiles are already private copies
+    std::unique_ptr<GridSnapshot> m_staged;
+    uint32_t m_batch = 1;
+    std::vector<uint32_t> m_rowBatch;
+    std::vector<uint32_t> m_tileBatch;
+    Stats m_stats;
+};
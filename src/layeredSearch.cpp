@@ -0,0 +1,230 @@
+#include "layeredSearch.h"
+#include "grid.h"
+#include "distanceTable.h"
+
+#include <algorithm>
+#include <queue>
+
+LayeredSearch::LayeredSearch(Grid& grid)
+    : m_grid(grid)
+    , m_refine(grid)
+{
+    //learned h would mix up the floors
+    m_refine.setLearning(false);
+    build();
+}
+
+int LayeredSearch::nodeOf(int layer, glm::ivec2 tile)
+{
+    int size = m_grid.getSize();
+    long long key = ((long long)layer * size + tile.y) * size + tile.x;
+    auto it = m_nodeIndex.find(key);
+    if (it != m_nodeIndex.end())
+        return it->second;
+
+    int id = (int)m_nodes.size();
+    m_nodes.push_back({ layer, tile, {} });
+    m_layerNodes[layer].push_back(id);
+    m_nodeIndex[key] = id;
+    return id;
+}
+
+void LayeredSearch::build()
+{
+    m_nodes.clear();
+    m_nodeIndex.clear();
+    m_layerNodes.assign(m_grid.layerCount(), {});
+    m_refine.reset();
+
+    for (const Grid::Portal& portal : m_grid.portals())
+    {
+        int from = nodeOf(portal.fromLayer, portal.from);
+        int to = nodeOf(portal.toLayer, portal.to);
+        m_nodes[from].edges.push_back({ to, portal.cost, true });
+        if (portal.twoWay)
+            m_nodes[to].edges.push_back({ from, portal.cost, true });
+    }
+
+    int active = m_grid.activeLayer();
+    for (int layer = 0; layer < (int)m_layerNodes.size(); layer++)
+    {
+        const std::vector<int>& ids = m_layerNodes[layer];
+        if (ids.size() < 2)
+            continue;
+
+        std::vector<glm::vec2> tiles;
+        for (int id : ids)
+        {
+            tiles.push_back(glm::vec2(m_nodes[id].tile));
+        }
+
+        m_grid.setActiveLayer(layer);
+        DistanceTable table;
+        table.compute(m_grid, tiles, tiles);
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            for (size_t j = 0; j < ids.size(); j++)
+            {
+                int d = table.at((int)i, (int)j);
+                if (i != j && d != DistanceTable::UNREACHABLE)
+                    m_nodes[ids[i]].edges.push_back({ ids[j], d, false });
+            }
+        }
+    }
+    m_grid.setActiveLayer(active);
+}
+
+void LayeredSearch::connect(int layer, glm::vec2 tile, std::vector<int>& dist)
+{
+    dist.assign(m_nodes.size(), -1);
+    const std::vector<int>& ids = m_layerNodes[layer];
+    if (ids.empty())
+        return;
+
+    std::vector<glm::vec2> tiles;
+    for (int id : ids)
+    {
+        tiles.push_back(glm::vec2(m_nodes[id].tile));
+    }
+
+    int active = m_grid.activeLayer();
+    m_grid.setActiveLayer(layer);
+    DistanceTable table;
+    table.compute(m_grid, { tile }, tiles, 1);
+    m_grid.setActiveLayer(active);
+
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        dist[ids[i]] = table.at(0, (int)i);
+    }
+}
+
+bool LayeredSearch::refine(int layer, glm::vec2 from, glm::vec2 to, std::vector<Step>& path)
+{
+    int active = m_grid.activeLayer();
+    m_grid.setActiveLayer(layer);
+    std::vector<glm::vec2> tiles = m_refine.findPath(from, to);
+    m_grid.setActiveLayer(active);
+    if (tiles.empty())
+        return false;
+
+    //the first tile is already the last step of the path
+    for (size_t i = path.empty() ? 0 : 1; i < tiles.size(); i++)
+    {
+        path.push_back({ layer, tiles[i] });
+    }
+    return true;
+}
+
+std::vector<LayeredSearch::Step> LayeredSearch::findPath(int startLayer, glm::vec2 start, int goalLayer, glm::vec2 goal)
+{
+    m_lastCost = -1;
+    int size = m_grid.getSize();
+    auto inside = [&](int layer, glm::vec2 t) {
+        return layer >= 0 && layer < m_grid.layerCount() && t.x >= 0 && t.y >= 0 && t.x < size && t.y < size
+            && !m_grid.wall(layer, (int)t.x, (int)t.y);
+        };
+    if (!inside(startLayer, start) || !inside(goalLayer, goal))
+        return {};
+
+    //the start and goal join the abstract graph as the two last nodes
+    std::vector<int> fromStart;
+    std::vector<int> toGoal;
+    connect(startLayer, start, fromStart);
+    connect(goalLayer, goal, toGoal);
+
+    const int startNode = (int)m_nodes.size();
+    const int goalNode = startNode + 1;
+    std::vector<int> dist(m_nodes.size() + 2, -1);
+    std::vector<int> parent(m_nodes.size() + 2, -1);
+
+    int direct = -1;
+    if (startLayer == goalLayer)
+    {
+        int active = m_grid.activeLayer();
+        m_grid.setActiveLayer(startLayer);
+        DistanceTable table;
+        table.compute(m_grid, { start }, { goal }, 1);
+        m_grid.setActiveLayer(active);
+        direct = table.at(0, 0);
+    }
+
+    using QueueItem = std::pair<int, int>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> open;
+    auto relax = [&](int node, int from, int d) {
+        if (dist[node] < 0 || d < dist[node])
+        {
+            dist[node] = d;
+            parent[node] = from;
+            open.push({ d, node });
+        }
+        };
+
+    dist[startNode] = 0;
+    if (direct >= 0)
+        relax(goalNode, startNode, direct);
+    for (size_t i = 0; i < m_nodes.size(); i++)
+    {
+        if (fromStart[i] >= 0)
+            relax((int)i, startNode, fromStart[i]);
+    }
+
+    while (!open.empty())
+    {
+        auto [d, node] = open.top();
+        open.pop();
+        if (d != dist[node])
+            continue;
+        if (node == goalNode)
+            break;
+
+        if (toGoal[node] >= 0)
+            relax(goalNode, node, d + toGoal[node]);
+        for (const Edge& e : m_nodes[node].edges)
+        {
+            relax(e.to, node, d + e.cost);
+        }
+    }
+
+    if (dist[goalNode] < 0)
+        return {};
+    m_lastCost = dist[goalNode];
+
+    std::vector<int> chain;
+    for (int node = goalNode; node != -1; node = parent[node])
+    {
+        chain.push_back(node);
+    }
+    std::reverse(chain.begin(), chain.end());
+
+    auto layerOf = [&](int node) {
+        return node == startNode ? startLayer : node == goalNode ? goalLayer : m_nodes[node].layer;
+        };
+    auto tileOf = [&](int node) {
+        return node == startNode ? start : node == goalNode ? goal : glm::vec2(m_nodes[node].tile);
+        };
+
+    std::vector<Step> path;
+    path.push_back({ startLayer, start });
+    for (size_t i = 1; i < chain.size(); i++)
+    {
+        int a = chain[i - 1];
+        int b = chain[i];
+        bool jump = a != startNode && b != goalNode && layerOf(a) != layerOf(b);
+        if (!jump && a != startNode && b != goalNode)
+        {
+            //same floor pair, walked unless the portal between them was cheaper
+            for (const Edge& e : m_nodes[a].edges)
+            {
+                if (e.to == b && e.portal && dist[a] + e.cost == dist[b])
+                    jump = true;
+            }
+        }
+
+        if (jump)
+            path.push_back({ layerOf(b), tileOf(b) });
+        else if (tileOf(a) != tileOf(b) && !refine(layerOf(a), tileOf(a), tileOf(b), path))
+            return {};
+    }
+    return path;
+}
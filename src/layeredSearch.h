@@ -0,0 +1,61 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include "aStar.h"
+
+class Grid;
+
+/*
+    Pathfinding across the floors of a layered Grid.
+    Every portal end is a node of a small abstract graph. build() connects the nodes that
+    share a floor with their walking distance (one DistanceTable per floor) and adds the portals.
+    A query only searches the start and goal floors to hook them into that graph, runs
+    dijkstra over it and then refines each floor segment with a plain A* on that floor.
+*/
+class LayeredSearch
+{
+public:
+    struct Step
+    {
+        int layer;
+        glm::vec2 tile;
+    };
+
+    LayeredSearch(Grid& grid);
+    //recomputes the portal to portal distances, call after walls or portals change
+    void build();
+    //empty when there is no way between the two, a portal jump shows up as consecutive steps on different floors
+    std::vector<Step> findPath(int startLayer, glm::vec2 start, int goalLayer, glm::vec2 goal);
+
+    //walking plus portal cost of the last path found, -1 if there was none
+    int lastCost() const { return m_lastCost; }
+    int nodeCount() const { return (int)m_nodes.size(); }
+
+private:
+    struct Edge
+    {
+        int to;
+        int cost;
+        bool portal;
+    };
+
+    struct Node
+    {
+        int layer;
+        glm::ivec2 tile;
+        std::vector<Edge> edges;
+    };
+
+    int nodeOf(int layer, glm::ivec2 tile);
+    //distances from tile to every node on its floor, -1 where unreachable
+    void connect(int layer, glm::vec2 tile, std::vector<int>& dist);
+    bool refine(int layer, glm::vec2 from, glm::vec2 to, std::vector<Step>& path);
+
+    Grid& m_grid;
+    a_Star::AdaptiveSearch m_refine;
+    std::vector<Node> m_nodes;
+    std::vector<std::vector<int>> m_layerNodes;
+    std::unordered_map<long long, int> m_nodeIndex;
+    int m_lastCost = -1;
+};
@@ -0,0 +1,142 @@
+#include "navCache.h"
+#include "grid.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t MAGIC = 0x4356414E; //"NAVC"
+    constexpr uint64_t ALIGN = 64;
+
+    uint64_t aligned(uint64_t offset)
+    {
+        return (offset + ALIGN - 1) / ALIGN * ALIGN;
+    }
+}
+
+bool NavCache::open(const std::string& path, const Grid& grid)
+{
+    close();
+    if (!m_file.open(path))
+        return false;
+
+    Header header;
+    if (m_file.size() < sizeof(Header))
+    {
+        close();
+        return false;
+    }
+    std::memcpy(&header, m_file.data(), sizeof(Header));
+    size_t tableEnd = sizeof(Header) + (size_t)header.sectionCount * sizeof(Entry);
+    if (header.magic != MAGIC || header.version != VERSION || header.size != grid.getSize()
+        || header.layer != grid.activeLayer() || header.wallHash != grid.wallHash() || m_file.size() < tableEnd)
+    {
+        close();
+        return false;
+    }
+
+    m_entries = (const Entry*)(m_file.data() + sizeof(Header));
+    m_sectionCount = header.sectionCount;
+    for (uint32_t i = 0; i < m_sectionCount; i++)
+    {
+        //checked without adding, a crafted offset + bytes could wrap around
+        const Entry& entry = m_entries[i];
+        if (entry.offset < tableEnd || entry.offset % ALIGN != 0 || entry.offset > m_file.size()
+            || entry.bytes > m_file.size() - entry.offset)
+        {
+            std::cout << "Truncated navcache " << path << "\n";
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void NavCache::close()
+{
+    m_file.close();
+    m_entries = nullptr;
+    m_sectionCount = 0;
+}
+
+const void* NavCache::section(Section id, size_t& bytes) const
+{
+    for (uint32_t i = 0; i < m_sectionCount; i++)
+    {
+        if (m_entries[i].id == id)
+        {
+            bytes = (size_t)m_entries[i].bytes;
+            return m_file.data() + m_entries[i].offset;
+        }
+    }
+    bytes = 0;
+    return nullptr;
+}
+
+void NavCache::add(Section id, const void* data, size_t bytes)
+{
+    const char* p = static_cast<const char*>(data);
+    m_pending.emplace_back(id, std::vector<char>(p, p + bytes));
+}
+
+bool NavCache::write(const std::string& path, const Grid& grid)
+{
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.wallHash = grid.wallHash();
+    header.size = grid.getSize();
+    header.layer = grid.activeLayer();
+    header.sectionCount = (uint32_t)m_pending.size();
+
+    std::vector<Entry> entries;
+    uint64_t offset = aligned(sizeof(Header) + m_pending.size() * sizeof(Entry));
+    for (const auto& [id, data] : m_pending)
+    {
+        entries.push_back({ id, 0, offset, data.size() });
+        offset = aligned(offset + data.size());
+    }
+
+    //unique name, two processes may write the same cache at once
+    std::string temp = path + ".tmp" + std::to_string(std::random_device()());
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            std::cout << "Failed to write navcache " << path << "\n";
+            return false;
+        }
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)entries.data(), entries.size() * sizeof(Entry));
+        const char zeros[ALIGN] = {};
+        uint64_t at = sizeof(Header) + entries.size() * sizeof(Entry);
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            out.write(zeros, entries[i].offset - at);
+            out.write(m_pending[i].second.data(), m_pending[i].second.size());
+            at = entries[i].offset + entries[i].bytes;
+        }
+        if (!out)
+        {
+            std::cout << "Failed to write navcache " << path << "\n";
+            out.close();
+            std::filesystem::remove(temp);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error)
+    {
+        std::cout << "Failed to replace navcache " << path << ": " << error.message() << "\n";
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    m_pending.clear();
+    return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "mappedFile.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class Grid;
+
+/*
+    Versioned binary file with preprocessing results for one map, next to the map as <map>.navcache.
+    The header holds a hash of every floor's walls, the size and the active floor, a file that
+    doesn't match the loaded grid (or was written by another VERSION) is ignored, so editing the
+    map invalidates it without anyone having to delete it.
+    The file is mapped read only, so several processes on the same map share its pages.
+    Sections are 64 byte aligned, consumers copy out whatever they will change later.
+    write() goes through a temporary file and a rename, a reader never sees half a file.
+*/
+class NavCache
+{
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    enum Section : uint32_t
+    {
+        NAVMESH_POLYS = 1,
+        NAVMESH_PORTALS,
+        NAVMESH_CELLS,
+        COMPONENTS,
+        CLEARANCE
+    };
+
+    static std::string pathFor(const std::string& mapPath) { return mapPath + ".navcache"; }
+
+    //false when the file is missing, broken or made for other walls
+    bool open(const std::string& path, const Grid& grid);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    //nullptr when the section isn't in the file
+    const void* section(Section id, size_t& bytes) const;
+
+    //sections for the next write, the data is copied
+    void add(Section id, const void* data, size_t bytes);
+    bool write(const std::string& path, const Grid& grid);
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t wallHash;
+        int32_t size;
+        int32_t layer;
+        uint32_t sectionCount;
+        uint32_t reserved;
+    };
+
+    struct Entry
+    {
+        uint32_t id;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t bytes;
+    };
+
+    MappedFile m_file;
+    const Entry* m_entries = nullptr;
+    uint32_t m_sectionCount = 0;
+    std::vector<std::pair<Section, std::vector<char>>> m_pending;
+};
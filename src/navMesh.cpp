@@ -0,0 +1,533 @@
+#include "navMesh.h"
+#include "grid.h"
+#include "navCache.h"
+
+#include <queue>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    // twice the signed area of triangle abc, same convention as recast's funnel
+    float triarea2(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c)
+    {
+        const float ax = b.x - a.x;
+        const float az = b.y - a.y;
+        const float bx = c.x - a.x;
+        const float bz = c.y - a.y;
+        return bx * az - ax * bz;
+    }
+
+    bool samePoint(const glm::vec2& a, const glm::vec2& b)
+    {
+        return glm::all(glm::lessThan(glm::abs(a - b), glm::vec2(0.0001f)));
+    }
+
+    //navcache layout, portals of a poly are a run in the portal section
+    struct CachedPoly
+    {
+        int32_t x0, z0, x1, z1;
+        int32_t alive;
+        uint32_t firstPortal;
+        uint32_t portalCount;
+    };
+
+    struct CachedPortal
+    {
+        int32_t to;
+        float ax, az, bx, bz;
+    };
+}
+
+NavMesh::NavMesh(Grid& grid, const NavCache* cache)
+    : m_grid(grid)
+{
+    if (!cache || !load(*cache))
+        build();
+}
+
+void NavMesh::build()
+{
+    m_size = m_grid.getSize();
+    m_polys.clear();
+    m_freeIds.clear();
+    m_cellPoly.assign((size_t)m_size * m_size, -1);
+    m_lastChange = Change();
+
+    std::vector<int> ids = buildRegion(0, 0, m_size - 1, m_size - 1);
+    linkPolys(ids);
+}
+
+void NavMesh::save(NavCache& cache) const
+{
+    std::vector<CachedPoly> polys;
+    std::vector<CachedPortal> portals;
+    for (const Poly& p : m_polys)
+    {
+        polys.push_back({ p.x0, p.z0, p.x1, p.z1, p.alive ? 1 : 0, (uint32_t)portals.size(), (uint32_t)p.portals.size() });
+        for (const Portal& portal : p.portals)
+        {
+            portals.push_back({ portal.to, portal.a.x, portal.a.y, portal.b.x, portal.b.y });
+        }
+    }
+    cache.add(NavCache::NAVMESH_POLYS, polys.data(), polys.size() * sizeof(CachedPoly));
+    cache.add(NavCache::NAVMESH_PORTALS, portals.data(), portals.size() * sizeof(CachedPortal));
+    cache.add(NavCache::NAVMESH_CELLS, m_cellPoly.data(), m_cellPoly.size() * sizeof(int));
+}
+
+bool NavMesh::load(const NavCache& cache)
+{
+    size_t polyBytes, portalBytes, cellBytes;
+    const CachedPoly* polys = (const CachedPoly*)cache.section(NavCache::NAVMESH_POLYS, polyBytes);
+    const CachedPortal* portals = (const CachedPortal*)cache.section(NavCache::NAVMESH_PORTALS, portalBytes);
+    const int* cells = (const int*)cache.section(NavCache::NAVMESH_CELLS, cellBytes);
+    m_size = m_grid.getSize();
+    if (!polys || !portals || !cells || cellBytes != (size_t)m_size * m_size * sizeof(int))
+        return false;
+
+    size_t polyCount = polyBytes / sizeof(CachedPoly);
+    size_t portalCount = portalBytes / sizeof(CachedPortal);
+    m_polys.assign(polyCount, Poly());
+    m_freeIds.clear();
+    m_lastChange = Change();
+    for (size_t i = 0; i < polyCount; i++)
+    {
+        const CachedPoly& c = polys[i];
+        if ((size_t)c.firstPortal + c.portalCount > portalCount)
+            return false;
+        if (c.alive && (c.x0 < 0 || c.z0 < 0 || c.x0 > c.x1 || c.z0 > c.z1 || c.x1 >= m_size || c.z1 >= m_size))
+            return false;
+        Poly& p = m_polys[i];
+        p.x0 = c.x0;
+        p.z0 = c.z0;
+        p.x1 = c.x1;
+        p.z1 = c.z1;
+        p.alive = c.alive != 0;
+        p.portals.reserve(c.portalCount);
+        for (uint32_t j = c.firstPortal; j < c.firstPortal + c.portalCount; j++)
+        {
+            int to = portals[j].to;
+            if (to < 0 || (size_t)to >= polyCount || to == (int)i || !polys[to].alive)
+                return false;
+            p.portals.push_back({ portals[j].to, glm::vec2(portals[j].ax, portals[j].az), glm::vec2(portals[j].bx, portals[j].bz) });
+        }
+        if (!p.alive)
+            m_freeIds.push_back((int)i);
+    }
+    //every cell names an alive rectangle that covers it
+    for (int z = 0; z < m_size; z++)
+    {
+        for (int x = 0; x < m_size; x++)
+        {
+            int id = cells[(size_t)z * m_size + x];
+            if (id < -1 || (id >= 0 && ((size_t)id >= polyCount || !m_polys[id].alive
+                || x < m_polys[id].x0 || x > m_polys[id].x1 || z < m_polys[id].z0 || z > m_polys[id].z1)))
+                return false;
+        }
+    }
+    m_cellPoly.assign(cells, cells + (size_t)m_size * m_size);
+    return true;
+}
+
+void NavMesh::onWallChanged(int x, int z)
+{
+    m_lastChange.x = x;
+    m_lastChange.z = z;
+    m_lastChange.removed.clear();
+    m_lastChange.created.clear();
+    m_lastChange.border.clear();
+    m_lastChange.removedCells = 0;
+    m_lastChange.removedConnected = true;
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size)
+        return;
+
+    //every polygon touching the cell or its neighbours gets torn down and rebuilt
+    int x0 = x, z0 = z, x1 = x, z1 = z;
+    std::vector<int>& dirty = m_lastChange.removed;
+    for (int nz = std::max(z - 1, 0); nz <= std::min(z + 1, m_size - 1); nz++)
+    {
+        for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, m_size - 1); nx++)
+        {
+            int id = m_cellPoly[(size_t)nz * m_size + nx];
+            if (id >= 0 && std::find(dirty.begin(), dirty.end(), id) == dirty.end())
+            {
+                dirty.push_back(id);
+            }
+        }
+    }
+
+    //flood the dirty set over its own portals
+    std::vector<int> linked(dirty.begin(), dirty.begin() + std::min<size_t>(dirty.size(), 1));
+    for (size_t i = 0; i < linked.size(); i++)
+    {
+        for (const Portal& portal : m_polys[linked[i]].portals)
+        {
+            if (std::find(dirty.begin(), dirty.end(), portal.to) != dirty.end() && std::find(linked.begin(), linked.end(), portal.to) == linked.end())
+                linked.push_back(portal.to);
+        }
+    }
+    m_lastChange.removedConnected = linked.size() == dirty.size();
+
+    for (int id : dirty)
+    {
+        for (const Portal& portal : m_polys[id].portals)
+        {
+            std::vector<int>& border = m_lastChange.border;
+            if (std::find(dirty.begin(), dirty.end(), portal.to) == dirty.end() && std::find(border.begin(), border.end(), portal.to) == border.end())
+                border.push_back(portal.to);
+        }
+    }
+
+    for (int id : dirty)
+    {
+        const Poly& p = m_polys[id];
+        x0 = std::min(x0, p.x0);
+        z0 = std::min(z0, p.z0);
+        x1 = std::max(x1, p.x1);
+        z1 = std::max(z1, p.z1);
+        m_lastChange.removedCells += (p.x1 - p.x0 + 1) * (p.z1 - p.z0 + 1);
+        removePoly(id);
+    }
+
+    m_lastChange.created = buildRegion(x0, z0, x1, z1);
+    linkPolys(m_lastChange.created);
+}
+
+std::vector<int> NavMesh::buildRegion(int x0, int z0, int x1, int z1)
+{
+    auto isFree = [&](int x, int z) {
+        return !m_grid.wall(x, z) && m_cellPoly[(size_t)z * m_size + x] < 0;
+        };
+
+    std::vector<int> created;
+    for (int z = z0; z <= z1; z++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            if (!isFree(x, z))
+                continue;
+
+            //grow right as far as possible, then grow down while the whole row fits
+            int ex = x;
+            while (ex + 1 <= x1 && isFree(ex + 1, z))
+                ex++;
+
+            int ez = z;
+            while (ez + 1 <= z1)
+            {
+                bool rowFree = true;
+                for (int rx = x; rx <= ex && rowFree; rx++)
+                {
+                    rowFree = isFree(rx, ez + 1);
+                }
+                if (!rowFree)
+                    break;
+                ez++;
+            }
+
+            int id;
+            if (!m_freeIds.empty())
+            {
+                id = m_freeIds.back();
+                m_freeIds.pop_back();
+            }
+            else
+            {
+                id = (int)m_polys.size();
+                m_polys.emplace_back();
+            }
+
+            Poly& p = m_polys[id];
+            p.x0 = x;
+            p.z0 = z;
+            p.x1 = ex;
+            p.z1 = ez;
+            p.alive = true;
+            p.portals.clear();
+
+            for (int cz = z; cz <= ez; cz++)
+            {
+                for (int cx = x; cx <= ex; cx++)
+                {
+                    m_cellPoly[(size_t)cz * m_size + cx] = id;
+                }
+            }
+            created.push_back(id);
+        }
+    }
+    return created;
+}
+
+void NavMesh::removePoly(int id)
+{
+    Poly& p = m_polys[id];
+    for (const Portal& portal : p.portals)
+    {
+        auto& other = m_polys[portal.to].portals;
+        other.erase(std::remove_if(other.begin(), other.end(),
+            [id](const Portal& op) { return op.to == id; }), other.end());
+    }
+
+    for (int z = p.z0; z <= p.z1; z++)
+    {
+        for (int x = p.x0; x <= p.x1; x++)
+        {
+            m_cellPoly[(size_t)z * m_size + x] = -1;
+        }
+    }
+
+    p.portals.clear();
+    p.alive = false;
+    m_freeIds.push_back(id);
+}
+
+void NavMesh::linkPolys(const std::vector<int>& ids)
+{
+    std::vector<char> isNew(m_polys.size(), 0);
+    for (int id : ids)
+    {
+        isNew[id] = 1;
+    }
+
+    for (int id : ids)
+    {
+        addBorderPortals(id, 1, 0, isNew);
+        addBorderPortals(id, -1, 0, isNew);
+        addBorderPortals(id, 0, 1, isNew);
+        addBorderPortals(id, 0, -1, isNew);
+    }
+}
+
+void NavMesh::addBorderPortals(int id, int dx, int dz, const std::vector<char>& isNew)
+{
+    const Poly p = m_polys[id];
+
+    //cells just outside the edge we are looking at
+    bool alongZ = dx != 0;
+    int fixed = dx > 0 ? p.x1 + 1 : dx < 0 ? p.x0 - 1 : dz > 0 ? p.z1 + 1 : p.z0 - 1;
+    if (fixed < 0 || fixed >= m_size)
+        return;
+    float edge = fixed - (dx + dz) * 0.5f;
+    int from = alongZ ? p.z0 : p.x0;
+    int to = alongZ ? p.z1 : p.x1;
+
+    int i = from;
+    while (i <= to)
+    {
+        size_t cell = alongZ ? (size_t)i * m_size + fixed : (size_t)fixed * m_size + i;
+        int other = m_cellPoly[cell];
+        int start = i;
+        while (i + 1 <= to)
+        {
+            size_t next = alongZ ? (size_t)(i + 1) * m_size + fixed : (size_t)fixed * m_size + i + 1;
+            if (m_cellPoly[next] != other)
+                break;
+            i++;
+        }
+
+        if (other >= 0)
+        {
+            Portal portal;
+            portal.to = other;
+            portal.a = alongZ ? glm::vec2(edge, start - 0.5f) : glm::vec2(start - 0.5f, edge);
+            portal.b = alongZ ? glm::vec2(edge, i + 0.5f) : glm::vec2(i + 0.5f, edge);
+            m_polys[id].portals.push_back(portal);
+
+            //new neighbours add their own side when they get linked
+            if (!isNew[other])
+            {
+                portal.to = id;
+                m_polys[other].portals.push_back(portal);
+            }
+        }
+        i++;
+    }
+}
+
+int NavMesh::polyAt(int x, int z) const
+{
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size)
+        return -1;
+    return m_cellPoly[(size_t)z * m_size + x];
+}
+
+int NavMesh::polyCount() const
+{
+    return (int)std::count_if(m_polys.begin(), m_polys.end(), [](const Poly& p) { return p.alive; });
+}
+
+std::vector<glm::vec2> NavMesh::findPath(glm::vec2 start, glm::vec2 goal)
+{
+    int startPoly = polyAt((int)start.x, (int)start.y);
+    int goalPoly = polyAt((int)goal.x, (int)goal.y);
+    if (startPoly < 0 || goalPoly < 0)
+        return {};
+
+    if (startPoly == goalPoly)
+    {
+        if (samePoint(start, goal))
+            return { start };
+        return { start, goal };
+    }
+
+    //A* over the polygons, each polygon is entered at the midpoint of the portal used
+    const float inf = std::numeric_limits<float>::max();
+    std::vector<float> gCost(m_polys.size(), inf);
+    std::vector<int> parent(m_polys.size(), -1);
+    std::vector<glm::vec2> entry(m_polys.size());
+    std::vector<char> closed(m_polys.size(), 0);
+
+    using QueueItem = std::pair<float, int>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> open;
+
+    gCost[startPoly] = 0.0f;
+    entry[startPoly] = start;
+    open.push({ glm::length(goal - start), startPoly });
+
+    bool found = false;
+    while (!open.empty())
+    {
+        int current = open.top().second;
+        open.pop();
+        if (closed[current])
+            continue;
+        closed[current] = 1;
+
+        if (current == goalPoly)
+        {
+            found = true;
+            break;
+        }
+
+        for (const Portal& portal : m_polys[current].portals)
+        {
+            if (closed[portal.to])
+                continue;
+
+            glm::vec2 mid = (portal.a + portal.b) * 0.5f;
+            float g = gCost[current] + glm::length(mid - entry[current]);
+            if (g < gCost[portal.to])
+            {
+                gCost[portal.to] = g;
+                entry[portal.to] = mid;
+                parent[portal.to] = current;
+                open.push({ g + glm::length(goal - mid), portal.to });
+            }
+        }
+    }
+
+    if (!found)
+        return {};
+
+    std::vector<int> corridor;
+    for (int id = goalPoly; id != -1; id = parent[id])
+    {
+        corridor.push_back(id);
+    }
+    std::reverse(corridor.begin(), corridor.end());
+
+    return stringPull(start, goal, corridor);
+}
+
+std::vector<glm::vec2> NavMesh::stringPull(glm::vec2 start, glm::vec2 goal, const std::vector<int>& corridor)
+{
+    //portal list as (left, right) pairs, start and goal are degenerate portals
+    std::vector<glm::vec2> lefts;
+    std::vector<glm::vec2> rights;
+    lefts.push_back(start);
+    rights.push_back(start);
+
+    for (size_t i = 0; i + 1 < corridor.size(); i++)
+    {
+        const Poly& p = m_polys[corridor[i]];
+        auto it = std::find_if(p.portals.begin(), p.portals.end(),
+            [&](const Portal& portal) { return portal.to == corridor[i + 1]; });
+
+        glm::vec2 a = it->a;
+        glm::vec2 b = it->b;
+        glm::vec2 dir = b - a;
+        float len = glm::length(dir);
+        if (len > 2.0f * m_margin)
+        {
+            dir /= len;
+            a += dir * m_margin;
+            b -= dir * m_margin;
+        }
+        else
+        {
+            a = b = (a + b) * 0.5f;
+        }
+
+        glm::vec2 center((p.x0 + p.x1) * 0.5f, (p.z0 + p.z1) * 0.5f);
+        if (triarea2(center, a, b) < 0.0f)
+            std::swap(a, b);
+        lefts.push_back(a);
+        rights.push_back(b);
+    }
+    lefts.push_back(goal);
+    rights.push_back(goal);
+
+    std::vector<glm::vec2> path;
+    path.push_back(start);
+
+    glm::vec2 apex = start;
+    glm::vec2 portalLeft = start;
+    glm::vec2 portalRight = start;
+    int apexIndex = 0;
+    int leftIndex = 0;
+    int rightIndex = 0;
+    int count = (int)lefts.size();
+
+    for (int i = 1; i < count; i++)
+    {
+        const glm::vec2& left = lefts[i];
+        const glm::vec2& right = rights[i];
+
+        //tighten the right side of the funnel
+        if (triarea2(apex, portalRight, right) <= 0.0f)
+        {
+            if (samePoint(apex, portalRight) || triarea2(apex, portalLeft, right) > 0.0f)
+            {
+                portalRight = right;
+                rightIndex = i;
+            }
+            else
+            {
+                //right crossed over left, left becomes a corner of the path
+                apex = portalLeft;
+                apexIndex = leftIndex;
+                if (!samePoint(path.back(), apex))
+                    path.push_back(apex);
+                portalLeft = portalRight = apex;
+                leftIndex = rightIndex = apexIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+
+        //tighten the left side of the funnel
+        if (triarea2(apex, portalLeft, left) >= 0.0f)
+        {
+            if (samePoint(apex, portalLeft) || triarea2(apex, portalRight, left) < 0.0f)
+            {
+                portalLeft = left;
+                leftIndex = i;
+            }
+            else
+            {
+                apex = portalRight;
+                apexIndex = rightIndex;
+                if (!samePoint(path.back(), apex))
+                    path.push_back(apex);
+                portalLeft = portalRight = apex;
+                leftIndex = rightIndex = apexIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+    }
+
+    if (!samePoint(path.back(), goal))
+        path.push_back(goal);
+    return path;
+}
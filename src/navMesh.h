@@ -0,0 +1,77 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+class Grid;
+class NavCache;
+
+/*
+    Navigation mesh built from the grid walls.
+    Walkable cells are merged into rectangles (always convex), neighbouring
+    rectangles are connected with portals along their shared edge.
+    Paths are searched over the rectangles and then straightened with the funnel algorithm.
+
+    All positions are in tile space: cell (x, z) is centered at (x, z) and spans +-0.5.
+*/
+class NavMesh
+{
+public:
+    struct Portal
+    {
+        int to;
+        glm::vec2 a;
+        glm::vec2 b;
+    };
+
+    struct Poly
+    {
+        int x0, z0, x1, z1; //inclusive cell bounds
+        bool alive = false;
+        std::vector<Portal> portals;
+    };
+
+    //what the last onWallChanged did, for data derived from the rectangles (DeadEnds)
+    struct Change
+    {
+        int x = -1;
+        int z = -1;
+        //torn down ids, created may reuse them
+        std::vector<int> removed;
+        std::vector<int> created;
+        //surviving rectangles that touched a removed one
+        std::vector<int> border;
+        //cells the removed rectangles covered, and whether they were linked to each other
+        int removedCells = 0;
+        bool removedConnected = true;
+    };
+
+    //with a cache that matches the grid the rectangles are read from it instead of built
+    NavMesh(Grid& grid, const NavCache* cache = nullptr);
+    void build();
+    void save(NavCache& cache) const;
+    bool load(const NavCache& cache);
+    //call after Grid::setWall, rebuilds only the polygons around the edited cell
+    void onWallChanged(int x, int z);
+    std::vector<glm::vec2> findPath(glm::vec2 start, glm::vec2 goal);
+
+    int polyAt(int x, int z) const;
+    int polyCount() const;
+    const std::vector<Poly>& polys() const { return m_polys; }
+    const Change& lastChange() const { return m_lastChange; }
+
+private:
+    std::vector<int> buildRegion(int x0, int z0, int x1, int z1);
+    void removePoly(int id);
+    void linkPolys(const std::vector<int>& ids);
+    void addBorderPortals(int id, int dx, int dz, const std::vector<char>& isNew);
+    std::vector<glm::vec2> stringPull(glm::vec2 start, glm::vec2 goal, const std::vector<int>& corridor);
+
+    Grid& m_grid;
+    int m_size = 0;
+    //how far waypoints stay away from portal ends, so the player doesn't clip wall corners
+    float m_margin = 0.3f;
+    std::vector<Poly> m_polys;
+    std::vector<int> m_freeIds;
+    std::vector<int> m_cellPoly;
+    Change m_lastChange;
+};
@@ -0,0 +1,301 @@
+#include "pathPlanner.h"
+#include "grid.h"
+#include "navMesh.h"
+#include "navCache.h"
+
+#include <iostream>
+#include <chrono>
+#include <bit>
+
+namespace
+{
+    const char* engineNames[PathPlanner::ENGINE_COUNT] = { "line of sight", "unreachable", "cache", "a*", "navmesh" };
+
+    //true when bits a..b (inclusive) of the bitboard row are all clear
+    bool rangeClear(const uint64_t* row, int a, int b)
+    {
+        if (a > b)
+            std::swap(a, b);
+        int first = a >> 6;
+        int last = b >> 6;
+        for (int w = first; w <= last; w++)
+        {
+            uint64_t mask = ~0ull;
+            if (w == first)
+                mask &= ~0ull << (a & 63);
+            if (w == last)
+                mask &= ~0ull >> (63 - (b & 63));
+            if (row[w] & mask)
+                return false;
+        }
+        return true;
+    }
+}
+
+void PathPlanner::Histogram::add(uint64_t ns)
+{
+    int bucket = std::min(BUCKETS - 1, (int)std::bit_width(ns));
+    buckets[bucket]++;
+    count++;
+    totalNs += ns;
+}
+
+uint64_t PathPlanner::Histogram::percentileNs(double p) const
+{
+    uint64_t want = (uint64_t)(p * count);
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        seen += buckets[i];
+        if (seen > want || (seen == count && seen > 0))
+            return 1ull << i;
+    }
+    return 0;
+}
+
+PathPlanner::PathPlanner(Grid& grid, NavMesh& navMesh, const NavCache* cache)
+    : m_grid(grid)
+    , m_navMesh(navMesh)
+    , m_aStar(grid)
+{
+    build();
+    if (cache)
+        load(*cache);
+}
+
+void PathPlanner::save(NavCache& cache)
+{
+    if (m_componentsDirty)
+        labelComponents();
+    cache.add(NavCache::COMPONENTS, m_component.data(), m_component.size() * sizeof(int));
+}
+
+bool PathPlanner::load(const NavCache& cache)
+{
+    //bitboards are a single pass over the walls, only the flood fill is worth keeping
+    size_t bytes;
+    const int* labels = (const int*)cache.section(NavCache::COMPONENTS, bytes);
+    if (!labels || bytes != (size_t)m_size * m_size * sizeof(int))
+        return false;
+    //labels are handed out in scan order, walls keep -1
+    int next = 0;
+    for (size_t cell = 0; cell < (size_t)m_size * m_size; cell++)
+    {
+        int label = labels[cell];
+        if (m_grid.wall((int)(cell % m_size), (int)(cell / m_size)) ? label != -1 : (label < 0 || label > next))
+            return false;
+        if (label == next)
+            next++;
+    }
+    m_component.assign(labels, labels + (size_t)m_size * m_size);
+    m_componentsDirty = false;
+    return true;
+}
+
+void PathPlanner::build()
+{
+    m_size = m_grid.getSize();
+    m_words = (m_size + 63) / 64;
+    m_rowBits.assign((size_t)m_size * m_words, 0);
+    m_columnBits.assign((size_t)m_size * m_words, 0);
+    for (int z = 0; z < m_size; z++)
+    {
+        for (int x = 0; x < m_size; x++)
+        {
+            if (m_grid.wall(x, z))
+            {
+                m_rowBits[z * m_words + (x >> 6)] |= 1ull << (x & 63);
+                m_columnBits[x * m_words + (z >> 6)] |= 1ull << (z & 63);
+            }
+        }
+    }
+    m_aStar.reset();
+    m_componentsDirty = true;
+    m_cache.clear();
+    m_cacheIndex.clear();
+}
+
+bool PathPlanner::rowClear(int z, int x0, int x1) const
+{
+    return rangeClear(&m_rowBits[z * m_words], x0, x1);
+}
+
+bool PathPlanner::columnClear(int x, int z0, int z1) const
+{
+    return rangeClear(&m_columnBits[x * m_words], z0, z1);
+}
+
+bool PathPlanner::straightPath(int sx, int sz, int gx, int gz, std::vector<glm::vec2>& path) const
+{
+    //either bend gives a shortest path, try the row first then the column first
+    glm::vec2 start(sx, sz), goal(gx, gz);
+    if (rowClear(sz, sx, gx) && columnClear(gx, sz, gz))
+    {
+        path = { start, glm::vec2(gx, sz), goal };
+    }
+    else if (columnClear(sx, sz, gz) && rowClear(gz, sx, gx))
+    {
+        path = { start, glm::vec2(sx, gz), goal };
+    }
+    else
+    {
+        return false;
+    }
+
+    //no bend when start and goal share a row or column
+    if (sx == gx || sz == gz)
+        path.erase(path.begin() + 1);
+    return true;
+}
+
+void PathPlanner::labelComponents()
+{
+    m_component.assign((size_t)m_size * m_size, -1);
+    std::vector<int64_t> stack;
+    int label = 0;
+    for (int64_t cell = 0; cell < (int64_t)m_size * m_size; cell++)
+    {
+        if (m_component[cell] >= 0 || m_grid.wall((int)(cell % m_size), (int)(cell / m_size)))
+            continue;
+
+        m_component[cell] = label;
+        stack.push_back(cell);
+        while (!stack.empty())
+        {
+            int64_t c = stack.back();
+            stack.pop_back();
+            int x = (int)(c % m_size);
+            int z = (int)(c / m_size);
+            const int neighbours[4][2] = { { x + 1, z }, { x - 1, z }, { x, z + 1 }, { x, z - 1 } };
+            for (auto& n : neighbours)
+            {
+                if (n[0] < 0 || n[1] < 0 || n[0] >= m_size || n[1] >= m_size)
+                    continue;
+                int64_t next = (int64_t)n[1] * m_size + n[0];
+                if (m_component[next] >= 0 || m_grid.wall(n[0], n[1]))
+                    continue;
+                m_component[next] = label;
+                stack.push_back(next);
+            }
+        }
+        label++;
+    }
+    m_componentsDirty = false;
+}
+
+bool PathPlanner::randomReachable(glm::vec2 from, std::mt19937& rng, glm::ivec2& tile)
+{
+    int x = (int)from.x, z = (int)from.y;
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size || m_grid.wall(x, z))
+        return false;
+
+    //the free cell index patches its groups on edits, labels are only redone when it can't
+    FreeCells& cells = m_grid.freeCells();
+    if (!cells.hasGroups() || cells.groupsStale())
+    {
+        if (m_componentsDirty)
+            labelComponents();
+        cells.setGroups(m_component);
+    }
+    return cells.sampleGroup(cells.group(x, z), rng, tile);
+}
+
+std::vector<glm::vec2> PathPlanner::findPath(glm::vec2 start, glm::vec2 goal)
+{
+    auto begin = std::chrono::steady_clock::now();
+    int sx = (int)start.x, sz = (int)start.y;
+    int gx = (int)goal.x, gz = (int)goal.y;
+    if (sx < 0 || sz < 0 || gx < 0 || gz < 0 || sx >= m_size || sz >= m_size || gx >= m_size || gz >= m_size)
+        return {};
+    if (m_grid.wall(sx, sz) || m_grid.wall(gx, gz))
+        return {};
+
+    std::vector<glm::vec2> path;
+    auto finish = [&](Engine engine) {
+        m_lastEngine = engine;
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+        m_histograms[engine].add((uint64_t)ns);
+        return path;
+        };
+
+    if (straightPath(sx, sz, gx, gz, path))
+        return finish(LINE_OF_SIGHT);
+
+    if (m_componentsDirty)
+        labelComponents();
+    const int64_t startCell = (int64_t)sz * m_size + sx;
+    const int64_t goalCell = (int64_t)gz * m_size + gx;
+    if (m_component[startCell] != m_component[goalCell])
+        return finish(UNREACHABLE);
+
+    CacheKey key = { startCell, goalCell };
+    auto hit = m_cacheIndex.find(key);
+    if (hit != m_cacheIndex.end())
+    {
+        m_cache.splice(m_cache.begin(), m_cache, hit->second);
+        path = hit->second->path;
+        return finish(CACHE);
+    }
+
+    Engine engine;
+    if (std::abs(sx - gx) + std::abs(sz - gz) <= m_shortHop)
+    {
+        path = m_aStar.findPath(glm::vec2(sx, sz), glm::vec2(gx, gz));
+        engine = ASTAR;
+    }
+    else
+    {
+        path = m_navMesh.findPath(glm::vec2(sx, sz), glm::vec2(gx, gz));
+        engine = NAVMESH;
+    }
+
+    if (!path.empty() && m_cacheSize > 0)
+    {
+        m_cache.push_front({ key, path });
+        m_cacheIndex[key] = m_cache.begin();
+        if (m_cache.size() > m_cacheSize)
+        {
+            m_cacheIndex.erase(m_cache.back().key);
+            m_cache.pop_back();
+        }
+    }
+    return finish(engine);
+}
+
+void PathPlanner::onWallChanged(int x, int z)
+{
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size)
+        return;
+
+    uint64_t rowBit = 1ull << (x & 63);
+    uint64_t columnBit = 1ull << (z & 63);
+    uint64_t& row = m_rowBits[z * m_words + (x >> 6)];
+    uint64_t& column = m_columnBits[x * m_words + (z >> 6)];
+    if (m_grid.wall(x, z))
+    {
+        row |= rowBit;
+        column |= columnBit;
+    }
+    else
+    {
+        row &= ~rowBit;
+        column &= ~columnBit;
+    }
+
+    m_aStar.onWallChanged(x, z);
+    m_componentsDirty = true;
+    m_cache.clear();
+    m_cacheIndex.clear();
+}
+
+void PathPlanner::printStats() const
+{
+    for (int i = 0; i < ENGINE_COUNT; i++)
+    {
+        const Histogram& h = m_histograms[i];
+        if (h.count == 0)
+            continue;
+        std::cout << engineNames[i] << ": " << h.count << " queries, mean " << h.totalNs / h.count / 1000.0
+            << " us, p50 < " << h.percentileNs(0.5) / 1000.0 << " us, p99 < " << h.percentileNs(0.99) / 1000.0 << " us\n";
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <list>
+#include <random>
+#include <unordered_map>
+#include <cstdint>
+#include "aStar.h"
+
+class Grid;
+class NavMesh;
+class NavCache;
+
+/*
+    Front end for path queries, picks the cheapest way to answer each one:
+    1. straight or single bend corridor, checked on wall bitboards, needs no search
+    2. start and goal in different components, answered without searching
+    3. a recent identical query from the path cache
+    4. plain A* for short hops, the navmesh for anything longer
+    Every query lands in the latency histogram of whatever answered it,
+    printStats() shows them so the short hop threshold can be tuned.
+*/
+class PathPlanner
+{
+public:
+    enum Engine
+    {
+        LINE_OF_SIGHT,
+        UNREACHABLE,
+        CACHE,
+        ASTAR,
+        NAVMESH,
+        ENGINE_COUNT
+    };
+
+    //log2 buckets of nanoseconds
+    struct Histogram
+    {
+        static constexpr int BUCKETS = 40;
+        uint64_t buckets[BUCKETS] = {};
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+
+        void add(uint64_t ns);
+        //upper bound of the bucket holding the p-th fraction, 0..1
+        uint64_t percentileNs(double p) const;
+    };
+
+    //component labels come from the cache when it has them
+    PathPlanner(Grid& grid, NavMesh& navMesh, const NavCache* cache = nullptr);
+    //rebuilds the bitboards, call after loading a new grid
+    void build();
+    void save(NavCache& cache);
+    bool load(const NavCache& cache);
+    //tile space waypoints from start to goal, empty if there is no way
+    std::vector<glm::vec2> findPath(glm::vec2 start, glm::vec2 goal);
+    //call after Grid::setWall, the navmesh has to be told separately
+    void onWallChanged(int x, int z);
+    //random free tile in the same component as from, false if from is a wall
+    bool randomReachable(glm::vec2 from, std::mt19937& rng, glm::ivec2& tile);
+
+    //manhattan distance up to which A* is used instead of the navmesh
+    void setShortHop(int tiles) { m_shortHop = tiles; }
+    void setCacheSize(size_t entries) { m_cacheSize = entries; }
+    Engine lastEngine() const { return m_lastEngine; }
+    const Histogram& histogram(Engine engine) const { return m_histograms[engine]; }
+    void printStats() const;
+
+private:
+    bool rowClear(int z, int x0, int x1) const;
+    bool columnClear(int x, int z0, int z1) const;
+    bool straightPath(int sx, int sz, int gx, int gz, std::vector<glm::vec2>& path) const;
+    void labelComponents();
+
+    Grid& m_grid;
+    NavMesh& m_navMesh;
+    a_Star::AdaptiveSearch m_aStar;
+    int m_size = 0;
+    int m_shortHop = 24;
+
+    //one bit per cell, rows for horizontal runs and a transposed copy for vertical ones
+    int m_words = 0;
+    std::vector<uint64_t> m_rowBits;
+    std::vector<uint64_t> m_columnBits;
+
+    std::vector<int> m_component;
+    bool m_componentsDirty = true;
+
+    //lru, front is the newest. start and goal cells, two of them don't fit one 64 bit key past 64k
+    struct CacheKey
+    {
+        int64_t start;
+        int64_t goal;
+        bool operator==(const CacheKey& o) const { return start == o.start && goal == o.goal; }
+    };
+    struct CacheKeyHash
+    {
+        size_t operator()(const CacheKey& k) const { return std::hash<int64_t>()(k.start * 0x9E3779B97F4A7C15ll ^ k.goal); }
+    };
+    struct CacheEntry
+    {
+        CacheKey key;
+        std::vector<glm::vec2> path;
+    };
+    size_t m_cacheSize = 256;
+    std::list<CacheEntry> m_cache;
+    std::unordered_map<CacheKey, std::list<CacheEntry>::iterator, CacheKeyHash> m_cacheIndex;
+
+    Engine m_lastEngine = LINE_OF_SIGHT;
+    Histogram m_histograms[ENGINE_COUNT];
+};
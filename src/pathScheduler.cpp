@@ -0,0 +1,198 @@
+#include "pathScheduler.h"
+
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+    const char* priorityNames[PathScheduler::PRIORITY_COUNT] = { "player", "ai", "prefetch" };
+}
+
+PathScheduler::PathScheduler(const std::function<Engine()>& makeEngine, int workers)
+{
+    if (workers <= 0)
+        workers = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < workers; i++)
+    {
+        m_workers.emplace_back(&PathScheduler::work, this, makeEngine());
+    }
+}
+
+PathScheduler::~PathScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& t : m_workers)
+    {
+        t.join();
+    }
+}
+
+PathScheduler::RequestId PathScheduler::submit(Priority priority, glm::vec2 start, glm::vec2 goal, float deadline, Callback callback)
+{
+    uint64_t key = ((uint64_t)(uint32_t)((int)start.y << 16 | (int)start.x) << 32) | (uint32_t)((int)goal.y << 16 | (int)goal.x);
+    Clock::time_point now = Clock::now();
+    Clock::time_point due = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(deadline));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats[priority].submitted++;
+
+    auto it = m_pending.find(key);
+    if (it != m_pending.end())
+    {
+        //same query already waiting, ride along and pull it forward if this one is more urgent
+        Request* r = it->second.get();
+        m_queues[r->priority].erase(r);
+        r->priority = std::min(r->priority, priority);
+        r->deadline = std::min(r->deadline, due);
+        r->callbacks.push_back(std::move(callback));
+        m_queues[r->priority].insert(r);
+        m_stats[priority].merged++;
+        return r->id;
+    }
+
+    auto request = std::make_unique<Request>();
+    request->id = m_nextId++;
+    request->key = key;
+    request->priority = priority;
+    request->start = start;
+    request->goal = goal;
+    request->submitted = now;
+    request->deadline = due;
+    request->callbacks.push_back(std::move(callback));
+    m_queues[priority].insert(request.get());
+    RequestId id = request->id;
+    m_pending[key] = std::move(request);
+
+    m_wake.notify_one();
+    return id;
+}
+
+std::unique_ptr<PathScheduler::Request> PathScheduler::take()
+{
+    Request* best = nullptr;
+    if (!m_queues[PLAYER].empty())
+    {
+        best = *m_queues[PLAYER].begin();
+    }
+    else
+    {
+        //an aged prefetch competes with ai work on deadline
+        Clock::time_point now = Clock::now();
+        if (!m_queues[AI].empty())
+            best = *m_queues[AI].begin();
+        if (!m_queues[PREFETCH].empty())
+        {
+            Request* prefetch = *m_queues[PREFETCH].begin();
+            bool aged = now - prefetch->submitted >= m_aging;
+            if (!best || (aged && EarlierDeadline()(prefetch, best)))
+                best = prefetch;
+        }
+    }
+    if (!best)
+        return nullptr;
+
+    m_queues[best->priority].erase(best);
+    auto it = m_pending.find(best->key);
+    std::unique_ptr<Request> request = std::move(it->second);
+    m_pending.erase(it);
+    return request;
+}
+
+void PathScheduler::work(Engine engine)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wake.wait(lock, [this]() { return m_stop || !m_pending.empty(); });
+        if (m_stop)
+            return;
+
+        std::unique_ptr<Request> request = take();
+        if (!request)
+            continue;
+
+        ClassStats& stats = m_stats[request->priority];
+        if (request->priority == PREFETCH && Clock::now() > request->deadline)
+        {
+            stats.dropped++;
+            m_finished.push_back({ false, {}, std::move(request->callbacks) });
+            if (m_pending.empty() && m_running == 0)
+                m_idle.notify_all();
+            continue;
+        }
+
+        m_running++;
+        lock.unlock();
+        std::vector<glm::vec2> path = engine(request->start, request->goal);
+        lock.lock();
+        m_running--;
+
+        stats.completed++;
+        if (Clock::now() > request->deadline)
+            stats.missed++;
+        m_finished.push_back({ true, std::move(path), std::move(request->callbacks) });
+        if (m_pending.empty() && m_running == 0)
+            m_idle.notify_all();
+    }
+}
+
+void PathScheduler::poll()
+{
+    std::vector<Finished> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        finished.swap(m_finished);
+    }
+    for (Finished& f : finished)
+    {
+        for (Callback& callback : f.callbacks)
+        {
+            callback(f.ok, f.path);
+        }
+    }
+}
+
+void PathScheduler::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_pending.empty() && m_running == 0; });
+}
+
+int PathScheduler::queueDepth(Priority priority) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (int)m_queues[priority].size();
+}
+
+float PathScheduler::missRate(Priority priority) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const ClassStats& s = m_stats[priority];
+    long long finished = s.completed + s.dropped;
+    return finished > 0 ? (float)(s.missed + s.dropped) / finished : 0.0f;
+}
+
+PathScheduler::ClassStats PathScheduler::stats(Priority priority) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ClassStats s = m_stats[priority];
+    s.queued = (int)m_queues[priority].size();
+    return s;
+}
+
+void PathScheduler::printStats() const
+{
+    for (int i = 0; i < PRIORITY_COUNT; i++)
+    {
+        ClassStats s = stats((Priority)i);
+        if (s.submitted == 0)
+            continue;
+        std::cout << priorityNames[i] << ": " << s.submitted << " submitted, " << s.merged << " merged, "
+            << s.queued << " queued, " << s.completed << " done, " << s.missed << " late, " << s.dropped
+            << " dropped, miss rate " << missRate((Priority)i) * 100.0f << "%\n";
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+/*
+    Queue in front of the path engines, run by a pool of worker threads.
+    Requests come in three classes. A free worker always takes a PLAYER request first, inside a
+    class the earliest deadline goes first. A PREFETCH request that has waited longer than
+    m_aging competes with AI requests so background work can't starve, nothing ever competes
+    with PLAYER. Identical pending requests are merged, the merged one keeps the better class
+    and the earlier deadline. PLAYER and AI requests past their deadline still run and count as
+    missed, PREFETCH requests past it are dropped.
+
+    Every worker owns its own engine since the engines keep per search scratch. Results are
+    handed back by poll() on the thread that calls it, so callbacks can touch game state.
+    Walls must not change while requests are running, call waitIdle() first, unless the engines
+    plan on GridVersions pins (a_Star::SnapshotSearch) and the edits go through it.
+*/
+class PathScheduler
+{
+public:
+    enum Priority
+    {
+        PLAYER,
+        AI,
+        PREFETCH,
+        PRIORITY_COUNT
+    };
+
+    using RequestId = uint64_t;
+    using Engine = std::function<std::vector<glm::vec2>(glm::vec2 start, glm::vec2 goal)>;
+    //ok is false for dropped requests, the path is empty then
+    using Callback = std::function<void(bool ok, const std::vector<glm::vec2>& path)>;
+
+    struct ClassStats
+    {
+        long long submitted = 0;
+        long long merged = 0;
+        long long completed = 0;
+        long long missed = 0;
+        long long dropped = 0;
+        int queued = 0;
+    };
+
+    //makeEngine is called once per worker on the constructing thread, workers = 0 uses every hardware thread
+    PathScheduler(const std::function<Engine()>& makeEngine, int workers = 0);
+    ~PathScheduler();
+
+    //deadline is in seconds from now
+    RequestId submit(Priority priority, glm::vec2 start, glm::vec2 goal, float deadline, Callback callback);
+    //runs the callbacks of finished requests
+    void poll();
+    //blocks until nothing is queued or running
+    void waitIdle();
+
+    void setAging(float seconds) { m_aging = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(seconds)); }
+    int queueDepth(Priority priority) const;
+    //missed or dropped / finished
+    float missRate(Priority priority) const;
+    ClassStats stats(Priority priority) const;
+    void printStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request
+    {
+        RequestId id;
+        uint64_t key;
+        Priority priority;
+        glm::vec2 start;
+        glm::vec2 goal;
+        Clock::time_point submitted;
+        Clock::time_point deadline;
+        std::vector<Callback> callbacks;
+    };
+
+    struct EarlierDeadline
+    {
+        bool operator()(const Request* a, const Request* b) const
+        {
+            return a->deadline < b->deadline || (a->deadline == b->deadline && a->id < b->id);
+        }
+    };
+
+    struct Finished
+    {
+        bool ok;
+        std::vector<glm::vec2> path;
+        std::vector<Callback> callbacks;
+    };
+
+    void work(Engine engine);
+    //next request to run or nullptr, called with the lock held
+    std::unique_ptr<Request> take();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    bool m_stop = false;
+    int m_running = 0;
+    RequestId m_nextId = 1;
+    Clock::duration m_aging = std::chrono::milliseconds(250);
+
+    std::set<Request*, EarlierDeadline> m_queues[PRIORITY_COUNT];
+    std::unordered_map<uint64_t, std::unique_ptr<Request>> m_pending;
+    std::vector<Finished> m_finished;
+    ClassStats m_stats[PRIORITY_COUNT];
+
+    std::vector<std::thread> m_workers;
+};
@@ -0,0 +1,218 @@
+#include "pathStore.h"
+
+#include <cmath>
+
+namespace
+{
+    constexpr int MAX_RUN = 0x1FFF;
+    constexpr float FIXED = 256.0f;
+    const int dirX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+    const int dirZ[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+    //escape is a run of length 0
+    constexpr uint16_t ESCAPE = 0;
+
+    uint16_t runWord(int dir, int length)
+    {
+        return (uint16_t)((dir << 13) | length);
+    }
+
+    void pushEscape(std::vector<uint16_t>& words, glm::vec2 p)
+    {
+        int32_t x = (int32_t)std::lround(p.x * FIXED);
+        int32_t z = (int32_t)std::lround(p.y * FIXED);
+        words.push_back(ESCAPE);
+        words.push_back((uint16_t)((uint32_t)x >> 16));
+        words.push_back((uint16_t)x);
+        words.push_back((uint16_t)((uint32_t)z >> 16));
+        words.push_back((uint16_t)z);
+    }
+
+    bool integral(glm::vec2 p)
+    {
+        return p.x == std::floor(p.x) && p.y == std::floor(p.y);
+    }
+
+    //direction index of a straight or diagonal step, -1 if (dx, dz) is neither
+    int directionOf(int dx, int dz)
+    {
+        if (dx != 0 && dz != 0 && std::abs(dx) != std::abs(dz))
+            return -1;
+        int sx = (dx > 0) - (dx < 0);
+        int sz = (dz > 0) - (dz < 0);
+        for (int d = 0; d < 8; d++)
+        {
+            if (dirX[d] == sx && dirZ[d] == sz)
+                return d;
+        }
+        return -1;
+    }
+}
+
+PathStore::PathId PathStore::allocate()
+{
+    uint32_t index;
+    if (!m_free.empty())
+    {
+        index = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        index = (uint32_t)m_slots.size();
+        m_slots.emplace_back();
+    }
+
+    Slot& slot = m_slots[index];
+    slot.used = true;
+    slot.words.clear();
+    m_live++;
+    return (index + 1) | ((PathId)slot.generation << 24);
+}
+
+PathStore::PathId PathStore::store(const std::vector<glm::vec2>& waypoints)
+{
+    if (waypoints.empty())
+        return INVALID;
+
+    PathId id = allocate();
+    std::vector<uint16_t>& words = m_slots[(id & 0xFFFFFF) - 1].words;
+
+    pushEscape(words, waypoints[0]);
+    int lastRun = -1;
+    for (size_t i = 1; i < waypoints.size(); i++)
+    {
+        glm::vec2 prev = waypoints[i - 1];
+        glm::vec2 p = waypoints[i];
+        int dir = -1;
+        if (integral(prev) && integral(p))
+            dir = directionOf((int)(p.x - prev.x), (int)(p.y - prev.y));
+        if (dir < 0)
+        {
+            pushEscape(words, p);
+            lastRun = -1;
+            continue;
+        }
+
+        int length = std::max(std::abs((int)(p.x - prev.x)), std::abs((int)(p.y - prev.y)));
+        if (length == 0)
+            continue;
+
+        //keep extending the last run while it goes the same way
+        if (lastRun >= 0 && (words[lastRun] >> 13) == dir)
+        {
+            int room = MAX_RUN - (words[lastRun] & MAX_RUN);
+            int add = std::min(room, length);
+            words[lastRun] = runWord(dir, (words[lastRun] & MAX_RUN) + add);
+            length -= add;
+        }
+        while (length > 0)
+        {
+            int add = std::min(MAX_RUN, length);
+            lastRun = (int)words.size();
+            words.push_back(runWord(dir, add));
+            length -= add;
+        }
+    }
+    return id;
+}
+
+PathStore::PathId PathStore::adopt(const uint16_t* words, size_t count)
+{
+    if (count == 0)
+        return INVALID;
+
+    PathId id = allocate();
+    m_slots[(id & 0xFFFFFF) - 1].words.assign(words, words + count);
+    return id;
+}
+
+const uint16_t* PathStore::words(PathId id, size_t& count) const
+{
+    const Slot* slot = slotOf(id);
+    count = slot ? slot->words.size() : 0;
+    return slot ? slot->words.data() : nullptr;
+}
+
+const PathStore::Slot* PathStore::slotOf(PathId id) const
+{
+    uint32_t index = (id & 0xFFFFFF) - 1;
+    if (id == INVALID || index >= m_slots.size())
+        return nullptr;
+    const Slot& slot = m_slots[index];
+    if (!slot.used || slot.generation != (id >> 24))
+        return nullptr;
+    return &slot;
+}
+
+bool PathStore::valid(PathId id) const
+{
+    return slotOf(id) != nullptr;
+}
+
+void PathStore::release(PathId id)
+{
+    if (!slotOf(id))
+        return;
+
+    uint32_t index = (id & 0xFFFFFF) - 1;
+    Slot& slot = m_slots[index];
+    slot.used = false;
+    //ids that are still around go stale instead of reading the next path in this slot
+    slot.generation = slot.generation == 255 ? 1 : slot.generation + 1;
+    m_free.push_back(index);
+    m_live--;
+}
+
+PathStore::Cursor PathStore::begin(PathId id) const
+{
+    Cursor cursor;
+    cursor.id = id;
+    return cursor;
+}
+
+bool PathStore::next(Cursor& cursor, glm::vec2& tile) const
+{
+    const Slot* slot = slotOf(cursor.id);
+    if (!slot || cursor.word >= slot->words.size())
+        return false;
+
+    const std::vector<uint16_t>& words = slot->words;
+    uint16_t w = words[cursor.word++];
+    if (w == ESCAPE)
+    {
+        //adopted words may be cut short
+        if (cursor.word + 4 > words.size())
+            return false;
+        int32_t x = (int32_t)(((uint32_t)words[cursor.word] << 16) | words[cursor.word + 1]);
+        int32_t z = (int32_t)(((uint32_t)words[cursor.word + 2] << 16) | words[cursor.word + 3]);
+        cursor.word += 4;
+        cursor.at = glm::vec2(x / FIXED, z / FIXED);
+    }
+    else
+    {
+        int dir = w >> 13;
+        int length = w & MAX_RUN;
+        cursor.at += glm::vec2(dirX[dir] * length, dirZ[dir] * length);
+    }
+    tile = cursor.at;
+    return true;
+}
+
+std::vector<glm::vec2> PathStore::decode(PathId id) const
+{
+    std::vector<glm::vec2> path;
+    Cursor cursor = begin(id);
+    glm::vec2 tile;
+    while (next(cursor, tile))
+    {
+        path.push_back(tile);
+    }
+    return path;
+}
+
+size_t PathStore::bytes(PathId id) const
+{
+    const Slot* slot = slotOf(id);
+    return slot ? slot->words.size() * sizeof(uint16_t) : 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+/*
+    Pooled storage for compact paths.
+    A path is a stream of 16 bit words. A run word holds one of 8 directions and a length of
+    up to 8191 tiles, so a straight stretch of a grid path costs 2 bytes however long it is.
+    Waypoints that don't sit on a run from the previous one (the first point, navmesh corners)
+    are stored absolute as an escape word plus x and z in 1/256 tile fixed point.
+
+    Paths are handed around as a PathId and read with a Cursor that decodes one waypoint at a
+    time. Released slots keep their buffers, so after warm up storing a path doesn't allocate.
+*/
+class PathStore
+{
+public:
+    using PathId = uint32_t;
+    static constexpr PathId INVALID = 0;
+
+    struct Cursor
+    {
+        PathId id = INVALID;
+        uint32_t word = 0;
+        glm::vec2 at = glm::vec2(0.0f);
+    };
+
+    //tile space waypoints, INVALID for an empty path
+    PathId store(const std::vector<glm::vec2>& waypoints);
+    void release(PathId id);
+    bool valid(PathId id) const;
+
+    Cursor begin(PathId id) const;
+    //the next waypoint (start first, then the end of every run), false once the path is used up
+    bool next(Cursor& cursor, glm::vec2& tile) const;
+    std::vector<glm::vec2> decode(PathId id) const;
+
+    //raw words of a stored path, for sending it somewhere else
+    const uint16_t* words(PathId id, size_t& count) const;
+    //stores words that came from another store
+    PathId adopt(const uint16_t* words, size_t count);
+
+    size_t bytes(PathId id) const;
+    int pathCount() const { return m_live; }
+
+private:
+    struct Slot
+    {
+        std::vector<uint16_t> words;
+        uint8_t generation = 1;
+        bool used = false;
+    };
+
+    const Slot* slotOf(PathId id) const;
+    PathId allocate();
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_free;
+    int m_live = 0;
+};
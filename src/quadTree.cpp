@@ -0,0 +1,333 @@
+#include "quadTree.h"
+#include "grid.h"
+
+#include <queue>
+#include <algorithm>
+#include <limits>
+
+QuadTree::QuadTree(Grid& grid)
+    : m_grid(grid)
+{
+    build();
+}
+
+void QuadTree::build()
+{
+    m_size = m_grid.getSize();
+    m_rootSize = 1;
+    while (m_rootSize < m_size)
+        m_rootSize *= 2;
+
+    m_nodes.clear();
+    m_freeBlocks.clear();
+    m_nodes.emplace_back();
+    buildNode(0, 0, 0, m_rootSize);
+}
+
+QuadTree::State QuadTree::buildNode(int node, int x, int z, int size)
+{
+    if (x >= m_size || z >= m_size)
+    {
+        m_nodes[node].state = FULL;
+        return FULL;
+    }
+    if (size == 1)
+    {
+        m_nodes[node].state = m_grid.wall(x, z) ? FULL : EMPTY;
+        return m_nodes[node].state;
+    }
+
+    int first = allocChildren(MIXED);
+    int half = size / 2;
+    State s0 = buildNode(first, x, z, half);
+    State s1 = buildNode(first + 1, x + half, z, half);
+    State s2 = buildNode(first + 2, x, z + half, half);
+    State s3 = buildNode(first + 3, x + half, z + half, half);
+
+    if (s0 != MIXED && s0 == s1 && s0 == s2 && s0 == s3)
+    {
+        //uniform block, children are not needed
+        m_freeBlocks.push_back(first);
+        m_nodes[node].firstChild = -1;
+        m_nodes[node].state = s0;
+        return s0;
+    }
+
+    m_nodes[node].firstChild = first;
+    m_nodes[node].state = MIXED;
+    return MIXED;
+}
+
+int QuadTree::allocChildren(State state)
+{
+    int first;
+    if (!m_freeBlocks.empty())
+    {
+        first = m_freeBlocks.back();
+        m_freeBlocks.pop_back();
+    }
+    else
+    {
+        first = (int)m_nodes.size();
+        m_nodes.resize(m_nodes.size() + 4);
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        m_nodes[first + i].firstChild = -1;
+        m_nodes[first + i].state = state;
+    }
+    return first;
+}
+
+void QuadTree::freeChildren(int node)
+{
+    int first = m_nodes[node].firstChild;
+    for (int i = 0; i < 4; i++)
+    {
+        if (m_nodes[first + i].firstChild >= 0)
+            freeChildren(first + i);
+    }
+    m_freeBlocks.push_back(first);
+    m_nodes[node].firstChild = -1;
+}
+
+void QuadTree::onWallChanged(int x, int z)
+{
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size)
+        return;
+
+    State value = m_grid.wall(x, z) ? FULL : EMPTY;
+
+    //walk down to the cell, splitting uniform leaves on the way
+    std::vector<int> stack;
+    int node = 0;
+    int nx = 0, nz = 0, size = m_rootSize;
+    while (size > 1)
+    {
+        if (m_nodes[node].firstChild < 0)
+        {
+            if (m_nodes[node].state == value)
+                return;
+            int first = allocChildren(m_nodes[node].state);
+            m_nodes[node].firstChild = first;
+            m_nodes[node].state = MIXED;
+        }
+
+        stack.push_back(node);
+        int half = size / 2;
+        int child = (x >= nx + half ? 1 : 0) + (z >= nz + half ? 2 : 0);
+        if (child & 1)
+            nx += half;
+        if (child & 2)
+            nz += half;
+        node = m_nodes[node].firstChild + child;
+        size = half;
+    }
+    m_nodes[node].state = value;
+
+    //walk back up and merge blocks that became uniform
+    while (!stack.empty())
+    {
+        int parent = stack.back();
+        stack.pop_back();
+
+        int first = m_nodes[parent].firstChild;
+        State s = m_nodes[first].state;
+        bool uniform = s != MIXED;
+        for (int i = 1; i < 4 && uniform; i++)
+        {
+            uniform = m_nodes[first + i].state == s;
+        }
+        if (!uniform)
+            break;
+
+        freeChildren(parent);
+        m_nodes[parent].state = s;
+    }
+}
+
+bool QuadTree::wall(int x, int z) const
+{
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size)
+        return true;
+    return m_nodes[leafAt(x, z).node].state == FULL;
+}
+
+QuadTree::Leaf QuadTree::leafAt(int x, int z) const
+{
+    int node = 0;
+    int nx = 0, nz = 0, size = m_rootSize;
+    while (m_nodes[node].firstChild >= 0)
+    {
+        int half = size / 2;
+        int child = (x >= nx + half ? 1 : 0) + (z >= nz + half ? 2 : 0);
+        if (child & 1)
+            nx += half;
+        if (child & 2)
+            nz += half;
+        node = m_nodes[node].firstChild + child;
+        size = half;
+    }
+    return { node, nx, nz, size };
+}
+
+bool QuadTree::isEmpty(int x0, int z0, int x1, int z1) const
+{
+    if (x0 < 0 || z0 < 0 || x1 >= m_size || z1 >= m_size)
+        return false;
+    return isEmpty(0, 0, 0, m_rootSize, x0, z0, x1, z1);
+}
+
+bool QuadTree::isEmpty(int node, int x, int z, int size, int x0, int z0, int x1, int z1) const
+{
+    if (x > x1 || z > z1 || x + size - 1 < x0 || z + size - 1 < z0)
+        return true;
+
+    const Node& n = m_nodes[node];
+    if (n.firstChild < 0)
+        return n.state == EMPTY;
+
+    int half = size / 2;
+    return isEmpty(n.firstChild, x, z, half, x0, z0, x1, z1)
+        && isEmpty(n.firstChild + 1, x + half, z, half, x0, z0, x1, z1)
+        && isEmpty(n.firstChild + 2, x, z + half, half, x0, z0, x1, z1)
+        && isEmpty(n.firstChild + 3, x + half, z + half, half, x0, z0, x1, z1);
+}
+
+void QuadTree::collectLeaves(int x0, int z0, int x1, int z1, std::vector<Leaf>& out) const
+{
+    collectLeaves(0, 0, 0, m_rootSize, x0, z0, x1, z1, out);
+}
+
+void QuadTree::collectLeaves(int node, int x, int z, int size, int x0, int z0, int x1, int z1, std::vector<Leaf>& out) const
+{
+    if (x > x1 || z > z1 || x + size - 1 < x0 || z + size - 1 < z0)
+        return;
+
+    const Node& n = m_nodes[node];
+    if (n.firstChild < 0)
+    {
+        out.push_back({ node, x, z, size });
+        return;
+    }
+
+    int half = size / 2;
+    collectLeaves(n.firstChild, x, z, half, x0, z0, x1, z1, out);
+    collectLeaves(n.firstChild + 1, x + half, z, half, x0, z0, x1, z1, out);
+    collectLeaves(n.firstChild + 2, x, z + half, half, x0, z0, x1, z1, out);
+    collectLeaves(n.firstChild + 3, x + half, z + half, half, x0, z0, x1, z1, out);
+}
+
+void QuadTree::emptyNeighbours(const Leaf& leaf, std::vector<Leaf>& out) const
+{
+    out.clear();
+    int x1 = leaf.x + leaf.size - 1;
+    int z1 = leaf.z + leaf.size - 1;
+    collectLeaves(x1 + 1, leaf.z, x1 + 1, z1, out);
+    collectLeaves(leaf.x - 1, leaf.z, leaf.x - 1, z1, out);
+    collectLeaves(leaf.x, z1 + 1, x1, z1 + 1, out);
+    collectLeaves(leaf.x, leaf.z - 1, x1, leaf.z - 1, out);
+
+    out.erase(std::remove_if(out.begin(), out.end(),
+        [&](const Leaf& l) { return m_nodes[l.node].state != EMPTY || l.x >= m_size || l.z >= m_size; }), out.end());
+}
+
+std::vector<glm::vec2> QuadTree::findPath(glm::vec2 start, glm::vec2 goal)
+{
+    if (wall((int)start.x, (int)start.y) || wall((int)goal.x, (int)goal.y))
+        return {};
+
+    Leaf startLeaf = leafAt((int)start.x, (int)start.y);
+    Leaf goalLeaf = leafAt((int)goal.x, (int)goal.y);
+    if (startLeaf.node == goalLeaf.node)
+    {
+        if (start == goal)
+            return { start };
+        return { start, goal };
+    }
+
+    //A* over empty leaves, a leaf is entered at the middle of the shared edge
+    const float inf = std::numeric_limits<float>::max();
+    size_t count = m_nodes.size();
+    std::vector<float> gCost(count, inf);
+    std::vector<int> parent(count, -1);
+    std::vector<glm::vec2> entry(count);
+    std::vector<Leaf> leaves(count);
+    std::vector<char> closed(count, 0);
+
+    using QueueItem = std::pair<float, int>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> open;
+
+    gCost[startLeaf.node] = 0.0f;
+    entry[startLeaf.node] = start;
+    leaves[startLeaf.node] = startLeaf;
+    open.push({ glm::length(goal - start), startLeaf.node });
+
+    std::vector<Leaf> neighbours;
+    bool found = false;
+    while (!open.empty())
+    {
+        int current = open.top().second;
+        open.pop();
+        if (closed[current])
+            continue;
+        closed[current] = 1;
+
+        if (current == goalLeaf.node)
+        {
+            found = true;
+            break;
+        }
+
+        const Leaf cur = leaves[current];
+        emptyNeighbours(cur, neighbours);
+        for (const Leaf& nb : neighbours)
+        {
+            if (closed[nb.node])
+                continue;
+
+            //overlap of the two touching sides, in tile space
+            float ox0 = (float)std::max(cur.x, nb.x) - 0.5f;
+            float ox1 = (float)std::min(cur.x + cur.size, nb.x + nb.size) - 0.5f;
+            float oz0 = (float)std::max(cur.z, nb.z) - 0.5f;
+            float oz1 = (float)std::min(cur.z + cur.size, nb.z + nb.size) - 0.5f;
+            glm::vec2 mid((ox0 + ox1) * 0.5f, (oz0 + oz1) * 0.5f);
+
+            float g = gCost[current] + glm::length(mid - entry[current]);
+            if (g < gCost[nb.node])
+            {
+                gCost[nb.node] = g;
+                entry[nb.node] = mid;
+                parent[nb.node] = current;
+                leaves[nb.node] = nb;
+                open.push({ g + glm::length(goal - mid), nb.node });
+            }
+        }
+    }
+
+    if (!found)
+        return {};
+
+    std::vector<glm::vec2> path;
+    path.push_back(goal);
+    for (int node = goalLeaf.node; node != startLeaf.node; node = parent[node])
+    {
+        path.push_back(entry[node]);
+    }
+    path.push_back(start);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+int QuadTree::leafCount() const
+{
+    std::vector<Leaf> leaves;
+    collectLeaves(0, 0, m_rootSize - 1, m_rootSize - 1, leaves);
+    return (int)leaves.size();
+}
+
+size_t QuadTree::memoryBytes() const
+{
+    return m_nodes.capacity() * sizeof(Node) + m_freeBlocks.capacity() * sizeof(int);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+class Grid;
+
+/*
+    Region quadtree over the grid walls.
+    Blocks that are all wall or all floor collapse into a single leaf, so memory and
+    queries scale with how complicated the walls are rather than with the map area.
+    Cells outside the map (root is rounded up to a power of two) count as wall.
+*/
+class QuadTree
+{
+public:
+    enum State : uint8_t
+    {
+        EMPTY,
+        FULL,
+        MIXED
+    };
+
+    struct Leaf
+    {
+        int node;
+        int x, z, size;
+    };
+
+    QuadTree(Grid& grid);
+    void build();
+    //call after Grid::setWall, splits/merges only the nodes on the path to the cell
+    void onWallChanged(int x, int z);
+
+    bool wall(int x, int z) const;
+    //true if there is no wall inside the inclusive cell rectangle
+    bool isEmpty(int x0, int z0, int x1, int z1) const;
+    Leaf leafAt(int x, int z) const;
+    void collectLeaves(int x0, int z0, int x1, int z1, std::vector<Leaf>& out) const;
+
+    //coarse path between empty leaves, waypoints are in tile space like NavMesh
+    std::vector<glm::vec2> findPath(glm::vec2 start, glm::vec2 goal);
+
+    int leafCount() const;
+    size_t memoryBytes() const;
+
+private:
+    struct Node
+    {
+        int firstChild = -1;
+        State state = EMPTY;
+    };
+
+    State buildNode(int node, int x, int z, int size);
+    int allocChildren(State state);
+    void freeChildren(int node);
+    bool isEmpty(int node, int x, int z, int size, int x0, int z0, int x1, int z1) const;
+    void collectLeaves(int node, int x, int z, int size, int x0, int z0, int x1, int z1, std::vector<Leaf>& out) const;
+    void emptyNeighbours(const Leaf& leaf, std::vector<Leaf>& out) const;
+
+    Grid& m_grid;
+    int m_size = 0;
+    int m_rootSize = 1;
+    std::vector<Node> m_nodes;
+    std::vector<int> m_freeBlocks;
+};
@@ -0,0 +1,241 @@
+#include "realTimeSearch.h"
+#include "grid.h"
+
+#include <algorithm>
+#include <queue>
+#include <limits>
+
+namespace
+{
+    constexpr int INF = std::numeric_limits<int>::max() / 2;
+    const int dx[4] = { 1, -1, 0, 0 };
+    const int dz[4] = { 0, 0, 1, -1 };
+}
+
+RealTimeSearch::RealTimeSearch(Grid& grid, int lookahead, int maxGoals)
+    : m_grid(grid)
+    , m_lookahead(std::max(1, lookahead))
+{
+    m_tables.resize(std::max(1, maxGoals));
+    reset();
+}
+
+void RealTimeSearch::reset()
+{
+    m_size = m_grid.getSize();
+    size_t cells = (size_t)m_size * m_size;
+    m_g.assign(cells, 0);
+    m_parent.assign(cells, -1);
+    m_generated.assign(cells, 0);
+    m_closed.assign(cells, 0);
+    m_searchId = 0;
+    for (Table& table : m_tables)
+    {
+        table = Table();
+    }
+}
+
+RealTimeSearch::Table& RealTimeSearch::tableFor(int64_t goal)
+{
+    m_useClock++;
+    Table* oldest = &m_tables[0];
+    for (Table& table : m_tables)
+    {
+        if (table.goal == goal)
+        {
+            table.lastUse = m_useClock;
+            return table;
+        }
+        if (table.lastUse < oldest->lastUse)
+            oldest = &table;
+    }
+
+    //recycle, bumping the generation forgets every value without touching them
+    if (oldest->h.empty())
+    {
+        oldest->h.assign((size_t)m_size * m_size, 0);
+        oldest->stamp.assign((size_t)m_size * m_size, 0);
+    }
+    oldest->goal = goal;
+    oldest->generation++;
+    oldest->lastUse = m_useClock;
+    return *oldest;
+}
+
+int RealTimeSearch::hValue(const Table& table, int64_t cell) const
+{
+    if (table.stamp[cell] == table.generation)
+        return table.h[cell];
+    int x = (int)(cell % m_size), z = (int)(cell / m_size);
+    int gx = (int)(table.goal % m_size), gz = (int)(table.goal / m_size);
+    return std::abs(x - gx) + std::abs(z - gz);
+}
+
+bool RealTimeSearch::advance(Agent& agent)
+{
+    int x = (int)agent.tile.x, z = (int)agent.tile.y;
+    int gx = (int)agent.goal.x, gz = (int)agent.goal.y;
+    if (x < 0 || z < 0 || gx < 0 || gz < 0 || x >= m_size || z >= m_size || gx >= m_size || gz >= m_size)
+        return false;
+    if ((x == gx && z == gz) || m_grid.wall(gx, gz) || m_grid.wall(x, z))
+    {
+        agent.plan.clear();
+        return false;
+    }
+
+    bool stale = agent.plan.empty() || agent.planGoal != agent.goal;
+    if (!stale)
+    {
+        glm::vec2 next = agent.plan.back();
+        stale = m_grid.wall((int)next.x, (int)next.y);
+    }
+    if (stale)
+    {
+        agent.plan.clear();
+        agent.planGoal = agent.goal;
+        if (!plan(agent, tableFor((int64_t)gz * m_size + gx)))
+            return false;
+    }
+
+    agent.tile = agent.plan.back();
+    agent.plan.pop_back();
+    return true;
+}
+
+bool RealTimeSearch::plan(Agent& agent, Table& table)
+{
+    m_lastExpanded = 0;
+    int64_t startCell = (int64_t)agent.tile.y * m_size + (int)agent.tile.x;
+    int64_t goalCell = table.goal;
+
+    m_searchId++;
+    m_closedList.clear();
+    m_openList.clear();
+
+    struct OpenItem
+    {
+        int f;
+        int g;
+        int64_t cell;
+        bool operator>(const OpenItem& o) const
+        {
+            return f > o.f || (f == o.f && g < o.g);
+        }
+    };
+    std::priority_queue<OpenItem, std::vector<OpenItem>, std::greater<OpenItem>> open;
+
+    m_g[startCell] = 0;
+    m_parent[startCell] = -1;
+    m_generated[startCell] = m_searchId;
+    m_openList.push_back(startCell);
+    open.push({ hValue(table, startCell), 0, startCell });
+
+    //capped A*, the best open cell when it stops is where the agent heads
+    int64_t target = -1;
+    while (!open.empty())
+    {
+        OpenItem item = open.top();
+        int64_t cell = item.cell;
+        if (m_closed[cell] == m_searchId || item.g != m_g[cell])
+        {
+            open.pop();
+            continue;
+        }
+        if (cell == goalCell || m_lastExpanded == m_lookahead)
+        {
+            target = cell;
+            break;
+        }
+
+        open.pop();
+        m_closed[cell] = m_searchId;
+        m_closedList.push_back(cell);
+        m_lastExpanded++;
+
+        int x = (int)(cell % m_size);
+        int z = (int)(cell / m_size);
+        for (int i = 0; i < 4; i++)
+        {
+            int nx = x + dx[i];
+            int nz = z + dz[i];
+            if (nx < 0 || nz < 0 || nx >= m_size || nz >= m_size || m_grid.wall(nx, nz))
+                continue;
+
+            int64_t next = (int64_t)nz * m_size + nx;
+            if (m_closed[next] == m_searchId)
+                continue;
+
+            int g = m_g[cell] + 1;
+            if (m_generated[next] != m_searchId || g < m_g[next])
+            {
+                if (m_generated[next] != m_searchId)
+                    m_openList.push_back(next);
+                m_generated[next] = m_searchId;
+                m_g[next] = g;
+                m_parent[next] = cell;
+                open.push({ g + hValue(table, next), g, next });
+            }
+        }
+    }
+
+    //learning: every expanded cell gets the cheapest way out through the frontier
+    for (int64_t cell : m_closedList)
+    {
+        table.h[cell] = INF;
+        table.stamp[cell] = table.generation;
+    }
+
+    using QueueItem = std::pair<int, int64_t>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> learn;
+    for (int64_t cell : m_openList)
+    {
+        if (m_closed[cell] != m_searchId)
+            learn.push({ hValue(table, cell), cell });
+    }
+    while (!learn.empty())
+    {
+        auto [h, cell] = learn.top();
+        learn.pop();
+        if (h != hValue(table, cell))
+            continue;
+
+        int x = (int)(cell % m_size);
+        int z = (int)(cell / m_size);
+        for (int i = 0; i < 4; i++)
+        {
+            int nx = x + dx[i];
+            int nz = z + dz[i];
+            if (nx < 0 || nz < 0 || nx >= m_size || nz >= m_size)
+                continue;
+            int64_t prev = (int64_t)nz * m_size + nx;
+            if (m_closed[prev] == m_searchId && table.h[prev] > h + 1)
+            {
+                table.h[prev] = h + 1;
+                learn.push({ h + 1, prev });
+            }
+        }
+    }
+
+    //no frontier left, the agent is boxed in
+    if (target < 0)
+        return false;
+
+    for (int64_t cell = target; cell != startCell; cell = m_parent[cell])
+    {
+        agent.plan.push_back(glm::vec2(cell % m_size, cell / m_size));
+    }
+    return true;
+}
+
+void RealTimeSearch::onWallChanged(int x, int z)
+{
+    //new walls only make paths longer, learned values stay admissible
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size || m_grid.wall(x, z))
+        return;
+
+    //a freed cell can make them overestimate, start those goals over
+    for (Table& table : m_tables)
+    {
+        table.generation++;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+class Grid;
+
+/*
+    LSS-LRTA*, real time search for lots of agents.
+    Every call looks ahead with an A* capped at m_lookahead expansions, raises the h-values
+    of the expanded cells with a dijkstra from the search frontier and hands the agent the
+    path to the best frontier cell, one step per call. The agent walks that short plan and
+    only plans again once it is used up, so a tick never costs more than one capped lookahead.
+
+    Learned h-values live in a per-cell table shared by every agent heading to the same goal.
+    There are m_maxGoals tables, the least recently used one is recycled for a new goal.
+*/
+class RealTimeSearch
+{
+public:
+    struct Agent
+    {
+        glm::vec2 tile = glm::vec2(0.0f);
+        glm::vec2 goal = glm::vec2(0.0f);
+        //next step at the back
+        std::vector<glm::vec2> plan;
+        glm::vec2 planGoal = glm::vec2(-1.0f);
+    };
+
+    RealTimeSearch(Grid& grid, int lookahead = 32, int maxGoals = 4);
+    void reset();
+    //moves agent.tile one step towards agent.goal, false when it is there, boxed in or standing on a wall
+    bool advance(Agent& agent);
+    //call after Grid::setWall
+    void onWallChanged(int x, int z);
+
+    int lookahead() const { return m_lookahead; }
+    int lastExpanded() const { return m_lastExpanded; }
+
+private:
+    struct Table
+    {
+        int64_t goal = -1;
+        uint32_t generation = 0;
+        uint32_t lastUse = 0;
+        std::vector<int> h;
+        std::vector<uint32_t> stamp;
+    };
+
+    Table& tableFor(int64_t goal);
+    int hValue(const Table& table, int64_t cell) const;
+    bool plan(Agent& agent, Table& table);
+
+    Grid& m_grid;
+    int m_size = 0;
+    int m_lookahead = 32;
+    int m_lastExpanded = 0;
+    uint32_t m_useClock = 0;
+    std::vector<Table> m_tables;
+
+    //lookahead scratch, stamped so nothing is cleared between calls
+    uint32_t m_searchId = 0;
+    std::vector<int> m_g;
+    std::vector<int64_t> m_parent;
+    std::vector<uint32_t> m_generated;
+    std::vector<uint32_t> m_closed;
+    std::vector<int64_t> m_closedList;
+    std::vector<int64_t> m_openList;
+};
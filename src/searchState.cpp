@@ -0,0 +1,77 @@
+#include "searchState.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr size_t MIN_SLOTS = 1024;
+}
+
+void DenseSearchState::resize(size_t cells)
+{
+    m_entries.assign(cells, SearchEntry{ 0, false, -1 });
+    m_stamps.assign(cells, 0);
+    m_stamp = 0;
+}
+
+void DenseSearchState::begin()
+{
+    if (++m_stamp == 0)
+    {
+        std::fill(m_stamps.begin(), m_stamps.end(), 0);
+        m_stamp = 1;
+    }
+}
+
+void SparseSearchState::begin(size_t expected)
+{
+    m_nodes.clear();
+    m_nodes.reserve(expected);
+    if (m_slots.empty() || expected * 2 > m_slots.size())
+        resizeTable(std::max(MIN_SLOTS, expected * 2));
+    if (++m_stamp == 0)
+    {
+        for (Slot& slot : m_slots)
+        {
+            slot.stamp = 0;
+        }
+        m_stamp = 1;
+    }
+}
+
+void SparseSearchState::grow()
+{
+    //rehash the live slots into a table twice the size, stamps of the old search are dropped
+    std::vector<Slot> old;
+    old.swap(m_slots);
+    uint32_t stamp = m_stamp;
+    resizeTable(old.size() * 2);
+    for (const Slot& slot : old)
+    {
+        if (slot.stamp != stamp)
+            continue;
+        size_t s = hash(slot.cell);
+        while (m_slots[s].stamp == m_stamp)
+        {
+            s = (s + 1) & m_mask;
+        }
+        m_slots[s] = slot;
+    }
+}
+
+void SparseSearchState::resizeTable(size_t slots)
+{
+    size_t size = MIN_SLOTS;
+    int bits = 10;
+    while (size < slots)
+    {
+        size *= 2;
+        bits++;
+    }
+    m_slots.assign(size, Slot{ 0, 0, 0 });
+    m_mask = size - 1;
+    m_shift = 64 - bits;
+    //fresh slots are stamp 0, the current search must never be 0
+    if (m_stamp == 0)
+        m_stamp = 1;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//g, parent and closed flag of one cell during a search
+struct SearchEntry
+{
+    int g;
+    bool closed;
+    int64_t parent;
+};
+
+/*
+    Per cell search scratch as one flat array, an entry only counts when its stamp matches the
+    current search so nothing is ever cleared. Fastest there is, but it costs
+    sizeof(SearchEntry) + 4 bytes for every cell of the map whatever the search touches.
+*/
+class DenseSearchState
+{
+public:
+    static constexpr size_t BYTES_PER_CELL = sizeof(SearchEntry) + sizeof(uint32_t);
+
+    void resize(size_t cells);
+    bool empty() const { return m_entries.empty(); }
+    void begin();
+    SearchEntry* find(int64_t cell) { return m_stamps[cell] == m_stamp ? &m_entries[cell] : nullptr; }
+    //only for cells find() returned nullptr for
+    SearchEntry& insert(int64_t cell)
+    {
+        m_stamps[cell] = m_stamp;
+        return m_entries[cell];
+    }
+    size_t touched() const { return m_touched; }
+    size_t bytes() const { return m_entries.size() * BYTES_PER_CELL; }
+
+private:
+    std::vector<SearchEntry> m_entries;
+    std::vector<uint32_t> m_stamps;
+    uint32_t m_stamp = 0;
+    size_t m_touched = 0;
+};
+
+/*
+    The same scratch for maps too big for dense buffers, memory follows what the search touches.
+    Open addressing with linear probing keyed by the packed cell index, the slots only hold the key
+    and an index into a node arena. Slots carry the search stamp like the dense array so begin()
+    doesn't clear the table, and the arena keeps its capacity between searches.
+    Pointers from find/insert are only good until the next insert.
+*/
+class SparseSearchState
+{
+public:
+    void begin(size_t expected = 0);
+    SearchEntry* find(int64_t cell)
+    {
+        for (size_t slot = hash(cell);; slot = (slot + 1) & m_mask)
+        {
+            const Slot& s = m_slots[slot];
+            if (s.stamp != m_stamp)
+                return nullptr;
+            if (s.cell == cell)
+                return &m_nodes[s.node];
+        }
+    }
+    SearchEntry& insert(int64_t cell)
+    {
+        //at most half full
+        if ((m_nodes.size() + 1) * 2 > m_slots.size())
+            grow();
+        size_t slot = hash(cell);
+        while (m_slots[slot].stamp == m_stamp)
+        {
+            slot = (slot + 1) & m_mask;
+        }
+        m_slots[slot] = { cell, (uint32_t)m_nodes.size(), m_stamp };
+        m_nodes.emplace_back();
+        return m_nodes.back();
+    }
+    size_t touched() const { return m_nodes.size(); }
+    size_t bytes() const { return m_slots.capacity() * sizeof(Slot) + m_nodes.capacity() * sizeof(SearchEntry); }
+
+private:
+    struct Slot
+    {
+        int64_t cell;
+        uint32_t node;
+        uint32_t stamp;
+    };
+
+    size_t hash(int64_t cell) const { return (size_t)(((uint64_t)cell * 0x9E3779B97F4A7C15ull) >> m_shift) & m_mask; }
+    void grow();
+    void resizeTable(size_t slots);
+
+    std::vector<Slot> m_slots;
+    std::vector<SearchEntry> m_nodes;
+    size_t m_mask = 0;
+    int m_shift = 54;
+    uint32_t m_stamp = 0;
+};
@@ -0,0 +1,346 @@
+#include "textMap.h"
+
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTMAP_SSE2 1
+#endif
+
+namespace
+{
+    constexpr size_t BLOCK = 4 << 20;
+
+    bool movingAiWall(char c)
+    {
+        return c == '@' || c == 'O' || c == 'T' || c == 'W';
+    }
+
+    int lowestBit(uint32_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (int)index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+}
+
+bool TextMapReader::read(const std::string& path, TextMap& map)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        std::cout << "Failed to open grid file!\n";
+        return false;
+    }
+
+    //not zeroed, small files only touch the pages they use
+    std::unique_ptr<char[]> block(new char[BLOCK]);
+    size_t size = std::fread(block.get(), 1, BLOCK, file);
+    begin(map, size >= 5 && std::memcmp(block.get(), "type ", 5) == 0);
+    m_path = path;
+    while (size > 0 && !m_failed)
+    {
+        feed(block.get(), size);
+        size = std::fread(block.get(), 1, BLOCK, file);
+    }
+    std::fclose(file);
+    return finish();
+}
+
+bool TextMapReader::readLines(const std::vector<std::string>& lines, TextMap& map)
+{
+    begin(map, false);
+    m_path = "grid lines";
+    for (const std::string& line : lines)
+    {
+        feed(line.data(), line.size());
+        feed("\n", 1);
+    }
+    return finish();
+}
+
+void TextMapReader::begin(TextMap& map, bool movingAi)
+{
+    m_map = &map;
+    m_movingAi = movingAi;
+    m_inMap = false;
+    m_declaredWidth = -1;
+    m_declaredHeight = -1;
+    m_state = LINE_START;
+    m_failed = false;
+    m_line.clear();
+    m_row.assign(64, 0);
+    m_rowCosts.clear();
+    m_rowHasCosts = false;
+    m_x = 0;
+    //every file starts a new floor
+    m_map->floors.emplace_back();
+}
+
+void TextMapReader::feed(const char* data, size_t size)
+{
+    size_t i = 0;
+    while (i < size && !m_failed)
+    {
+        if (m_state == ROW)
+        {
+#ifdef TEXTMAP_SSE2
+            //whole 64 byte steps until something that isn't a plain tile shows up, then 16 byte ones
+            const __m128i newline = _mm_set1_epi8('\n');
+            const __m128i carriage = _mm_set1_epi8('\r');
+            const __m128i one = _mm_set1_epi8('1');
+            const __m128i eight = _mm_set1_epi8(8);
+            auto classify = [&](const char* p, uint32_t& wallMask) {
+                __m128i v = _mm_loadu_si128((const __m128i*)p);
+                __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, carriage));
+                __m128i wall;
+                if (m_movingAi)
+                {
+                    wall = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('@')), _mm_cmpeq_epi8(v, _mm_set1_epi8('O'))),
+                        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('T')), _mm_cmpeq_epi8(v, _mm_set1_epi8('W'))));
+                }
+                else
+                {
+                    wall = _mm_cmpeq_epi8(v, _mm_set1_epi8('x'));
+                    //c - '1' <= 8 unsigned is a cost digit
+                    __m128i d = _mm_sub_epi8(v, one);
+                    special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(d, eight), d));
+                }
+                wallMask = (uint32_t)_mm_movemask_epi8(wall);
+                return (uint32_t)_mm_movemask_epi8(special);
+                };
+
+            while (i + 64 <= size)
+            {
+                uint32_t w0, w1, w2, w3;
+                uint32_t special = classify(data + i, w0) | classify(data + i + 16, w1) | classify(data + i + 32, w2) | classify(data + i + 48, w3);
+                if (special)
+                    break;
+                appendWord((uint64_t)w0 | (uint64_t)w1 << 16 | (uint64_t)w2 << 32 | (uint64_t)w3 << 48);
+                i += 64;
+            }
+            while (i + 16 <= size)
+            {
+                uint32_t wallMask;
+                uint32_t specialMask = classify(data + i, wallMask);
+                if (specialMask)
+                {
+                    int plain = lowestBit(specialMask);
+                    appendBits(wallMask & ((1u << plain) - 1), plain);
+                    i += plain;
+                    break;
+                }
+                appendBits(wallMask, 16);
+                i += 16;
+            }
+#endif
+            if (i < size)
+                rowByte(data[i++]);
+            continue;
+        }
+
+        char c = data[i++];
+        if (m_state == LINE_START)
+        {
+            if (c == '\n' || c == '\r')
+                continue;
+            if (m_movingAi && !m_inMap)
+            {
+                m_state = TEXT_LINE;
+                m_line.assign(1, c);
+            }
+            else if (!m_movingAi && c == '#')
+            {
+                m_state = SKIP_LINE;
+                if (m_map->floors.back().height > 0)
+                    m_map->floors.emplace_back();
+            }
+            else if (!m_movingAi && c == 'p')
+            {
+                m_state = TEXT_LINE;
+                m_line.assign(1, c);
+            }
+            else
+            {
+                m_state = ROW;
+                rowByte(c);
+            }
+        }
+        else if (m_state == TEXT_LINE)
+        {
+            if (c == '\n')
+            {
+                textLine();
+                m_state = LINE_START;
+            }
+            else if (c != '\r')
+            {
+                m_line += c;
+            }
+        }
+        else if (c == '\n')
+        {
+            m_state = LINE_START;
+        }
+    }
+}
+
+void TextMapReader::rowByte(char c)
+{
+    if (c == '\n')
+    {
+        endRow();
+        m_state = LINE_START;
+        return;
+    }
+    if (c == '\r')
+        return;
+
+    if (!m_movingAi && c >= '1' && c <= '9')
+    {
+        m_rowHasCosts = true;
+        if ((int)m_rowCosts.size() <= m_x)
+            m_rowCosts.resize(m_x + 1, 1);
+        m_rowCosts[m_x] = (uint8_t)(c - '0');
+    }
+    bool wall = m_movingAi ? movingAiWall(c) : c == 'x';
+    appendBits(wall ? 1u : 0u, 1);
+}
+
+void TextMapReader::appendBits(uint32_t mask, int count)
+{
+    size_t word = m_x >> 6;
+    int offset = m_x & 63;
+    if (word + 2 > m_row.size())
+        m_row.resize(m_row.size() * 2, 0);
+    m_row[word] |= (uint64_t)mask << offset;
+    if (offset + count > 64)
+        m_row[word + 1] |= (uint64_t)mask >> (64 - offset);
+    m_x += count;
+}
+
+void TextMapReader::appendWord(uint64_t mask)
+{
+    size_t word = m_x >> 6;
+    int offset = m_x & 63;
+    if (word + 2 > m_row.size())
+        m_row.resize(m_row.size() * 2, 0);
+    m_row[word] |= mask << offset;
+    if (offset)
+        m_row[word + 1] |= mask >> (64 - offset);
+    m_x += 64;
+}
+
+void TextMapReader::endRow()
+{
+    TextMap& map = *m_map;
+    TextMap::Floor& floor = map.floors.back();
+    if (map.width == 0)
+    {
+        map.width = m_x;
+        map.words = (m_x + 63) / 64;
+    }
+    if (m_x != map.width)
+    {
+        fail("Row " + std::to_string(floor.height) + " is " + std::to_string(m_x) + " tiles, expected " + std::to_string(map.width));
+        return;
+    }
+
+    floor.bits.insert(floor.bits.end(), m_row.begin(), m_row.begin() + map.words);
+    std::fill(m_row.begin(), m_row.begin() + map.words, 0);
+    if (m_rowHasCosts || !floor.costs.empty())
+    {
+        //earlier rows of the floor had no digits, they cost 1
+        if (floor.costs.empty())
+            floor.costs.assign((size_t)floor.height * map.width, 1);
+        m_rowCosts.resize(map.width, 1);
+        floor.costs.insert(floor.costs.end(), m_rowCosts.begin(), m_rowCosts.end());
+    }
+    m_rowCosts.clear();
+    m_rowHasCosts = false;
+    floor.height++;
+    m_x = 0;
+}
+
+void TextMapReader::textLine()
+{
+    std::istringstream in(m_line);
+    std::string word;
+    in >> word;
+    if (m_movingAi)
+    {
+        if (word == "height")
+            in >> m_declaredHeight;
+        else if (word == "width")
+            in >> m_declaredWidth;
+        else if (word == "map")
+            m_inMap = true;
+        return;
+    }
+
+    if (m_line.rfind("portal", 0) != 0)
+    {
+        //just a row that starts with p
+        for (char c : m_line)
+        {
+            rowByte(c);
+        }
+        rowByte('\n');
+        return;
+    }
+
+    Grid::Portal portal;
+    in.str(m_line.substr(6));
+    in.clear();
+    in >> portal.fromLayer >> portal.from.x >> portal.from.y >> portal.toLayer >> portal.to.x >> portal.to.y;
+    if (!in)
+    {
+        std::cout << "Bad portal line: " << m_line << "\n";
+        return;
+    }
+    //cost and oneway are both optional
+    int cost;
+    if (in >> cost)
+        portal.cost = cost;
+    else
+        in.clear();
+    std::string flag;
+    if (in >> flag)
+        portal.twoWay = flag != "oneway";
+    m_map->portals.push_back(portal);
+}
+
+bool TextMapReader::finish()
+{
+    if (m_state == ROW && m_x > 0)
+        endRow();
+    else if (m_state == TEXT_LINE)
+        textLine();
+    m_state = LINE_START;
+
+    if (!m_failed && m_movingAi && m_map->floors.back().height > 0
+        && (m_declaredWidth != m_map->width || m_declaredHeight != m_map->floors.back().height))
+    {
+        fail("Header says " + std::to_string(m_declaredWidth) + "x" + std::to_string(m_declaredHeight) + " but the map is "
+            + std::to_string(m_map->width) + "x" + std::to_string(m_map->floors.back().height));
+    }
+    if (m_map->floors.back().height == 0)
+        m_map->floors.pop_back();
+    return !m_failed;
+}
+
+void TextMapReader::fail(const std::string& message)
+{
+    if (!m_failed)
+        std::cout << message << " in " << m_path << "\n";
+    m_failed = true;
+}
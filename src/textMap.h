@@ -0,0 +1,76 @@
+#pragma once
+#include "grid.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+//floors as they are in the text, before Grid pads them to a square
+struct TextMap
+{
+    struct Floor
+    {
+        int height = 0;
+        //height rows of words words, bit x of a row is a wall
+        std::vector<uint64_t> bits;
+        //empty or width * height, only when the floor has digit tiles
+        std::vector<uint8_t> costs;
+    };
+
+    int width = 0;
+    int words = 0;
+    std::vector<Floor> floors;
+    std::vector<Grid::Portal> portals;
+};
+
+/*
+    Streaming reader for our grid files and MovingAI .map files
+    ("type octile", "height h", "width w", "map", then rows where @ O T W are blocked).
+    The file goes through in 4 MB blocks. Rows are classified 64 bytes at a time with SSE2
+    compares and movemask and the wall bits are or-ed straight into 64 cell words, no row
+    is ever held as a string. '#' lines, portal lines, header lines, line ends and cost digits
+    take the byte at a time path. Rows may be any length as long as every row of the file has it.
+*/
+class TextMapReader
+{
+public:
+    //appends the floors and portals of the file to map
+    bool read(const std::string& path, TextMap& map);
+    //same for rows already in memory, used by Grid::loadFromLines
+    bool readLines(const std::vector<std::string>& lines, TextMap& map);
+
+private:
+    enum State
+    {
+        LINE_START,
+        ROW,
+        TEXT_LINE,
+        SKIP_LINE
+    };
+
+    void begin(TextMap& map, bool movingAi);
+    void feed(const char* data, size_t size);
+    bool finish();
+    void rowByte(char c);
+    void appendBits(uint32_t mask, int count);
+    void appendWord(uint64_t mask);
+    void endRow();
+    void textLine();
+    void fail(const std::string& message);
+
+    TextMap* m_map = nullptr;
+    bool m_movingAi = false;
+    //movingAi only, rows start after the "map" line
+    bool m_inMap = false;
+    int m_declaredWidth = -1;
+    int m_declaredHeight = -1;
+    State m_state = LINE_START;
+    bool m_failed = false;
+    std::string m_path;
+    std::string m_line;
+    //the row being read, sized in whole words with room to spare
+    std::vector<uint64_t> m_row;
+    std::vector<uint8_t> m_rowCosts;
+    bool m_rowHasCosts = false;
+    int m_x = 0;
+};
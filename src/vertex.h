@@ -0,0 +1,10 @@
+#pragma once
+#include <glm/glm.hpp>
+
+struct vertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec3 color;
+    glm::vec2 texCoord;
+};
@@ -0,0 +1,677 @@
+#include "engines.h"
+#include "grid.h"
+#include "freeCells.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <type_traits>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/*
+    Runs every search engine over the same queries and reports speed and path quality.
+        bench_pathfinding <map> [--scen <file.scen>] [<map> [--scen <file.scen>]]...
+                          [--queries n] [--seed s] [--engines a,b,...] [--sessions n] [--json <out|->]
+    Maps are anything Grid::loadFromFile reads, MovingAI .map included. --scen belongs to the map
+    before it and takes the start and goal of every MovingAI scenario line. Maps without one get
+    --queries (default 1000) random pairs of floor tiles.
+    The optimal column of a .scen is octile cost and our engines walk 4-connected, so the reference
+    cost of every query is a BFS. Pairs the BFS can't connect are left out.
+
+    Engines: astar adaptive sparse sized pruned learnpruned nearest snapshot navmesh planner quadtree layered realtime legacy.
+    The default is all but legacy, the Node* A* is quadratic on anything bigger than the demo map.
+    Per engine: build time, ns per query (mean, p50, p90, p99, max), nodes expanded and heap
+    pushes + pops for the engines that count them, peak memory the engine added and
+    cost / BFS cost, a path counts as optimal when it is no longer than the BFS. Cost is the
+    manhattan length of the waypoints. Corner cutting engines (navmesh, quadtree, planner) have no
+    any-angle reference to compare to and their waypoints can beat the tile optimum, so they get
+    no optimal or cost columns. Neither does sized, it moves a 2x2 unit that takes longer ways than
+    the BFS and misses the queries with no room for it at the start or goal.
+    Every engine runs in a forked child, its peak is the child's peak rss over what it had when it
+    started, so memory an earlier engine freed can't hide it. Windows runs them in process, there the
+    peak only counts what went past the highest engine before, run one engine per process there.
+    --sessions n (default 0) then replays n sessions per map through a_Star::replaySession, each
+    SESSION_LENGTH queries from random starts to one goal with a wall flipped before every query,
+    and prints the nodes plain and adaptive A* expanded over them. The flips stay on the map.
+*/
+
+namespace
+{
+    using bench::Query;
+    using bench::Result;
+    using bench::Runner;
+    using bench::Engine;
+
+    const int SESSION_LENGTH = 32;
+
+    struct Percentiles
+    {
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p90 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    struct Report
+    {
+        //an Engine name, a literal so the report can come back from a child as plain bytes
+        const char* engine = "";
+        double buildMs = 0.0;
+        double memoryMb = 0.0;
+        int found = 0;
+        int missed = 0;
+        //false for corner cutting engines, optimal and the ratios mean nothing for them
+        bool scored = false;
+        int optimal = 0;
+        double meanRatio = 0.0;
+        double worstRatio = 0.0;
+        Percentiles ns;
+        bool hasExpanded = false;
+        Percentiles expanded;
+        bool hasHeapOps = false;
+        Percentiles heapOps;
+    };
+
+    struct MapRun
+    {
+        std::string map;
+        std::string scen;
+        int size = 0;
+        int queries = 0;
+        int skipped = 0;
+        std::vector<Report> reports;
+        int sessions = 0;
+        a_Star::SessionReport sessionReport;
+    };
+
+    double residentMb()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0.0;
+        return counters.WorkingSetSize / (1024.0 * 1024.0);
+#elif defined(__linux__)
+        std::ifstream statm("/proc/self/statm");
+        long long pages = 0, resident = 0;
+        if (!(statm >> pages >> resident))
+            return 0.0;
+        return resident * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+#else
+        return 0.0;
+#endif
+    }
+
+    double peakRssMb()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0.0;
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+        return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+    }
+
+    //4-connected step count from start to goal, -1 if there is no way
+    class Bfs
+    {
+    public:
+        Bfs(const Grid& grid)
+            : m_grid(grid)
+            , m_size(grid.getSize())
+            , m_stamps((size_t)m_size * m_size, 0)
+            , m_dist((size_t)m_size * m_size, 0)
+        {
+        }
+
+        int distance(glm::ivec2 start, glm::ivec2 goal)
+        {
+            m_stamp++;
+            size_t startCell = (size_t)start.y * m_size + start.x;
+            size_t goalCell = (size_t)goal.y * m_size + goal.x;
+            m_queue.clear();
+            m_queue.push_back(startCell);
+            m_stamps[startCell] = m_stamp;
+            m_dist[startCell] = 0;
+            const int dx[4] = { 1, -1, 0, 0 };
+            const int dz[4] = { 0, 0, 1, -1 };
+            for (size_t head = 0; head < m_queue.size(); head++)
+            {
+                size_t cell = m_queue[head];
+                if (cell == goalCell)
+                    return m_dist[cell];
+                int x = (int)(cell % m_size);
+                int z = (int)(cell / m_size);
+                for (int i = 0; i < 4; i++)
+                {
+                    int nx = x + dx[i];
+                    int nz = z + dz[i];
+                    if (nx < 0 || nz < 0 || nx >= m_size || nz >= m_size || m_grid.wall(nx, nz))
+                        continue;
+                    size_t next = (size_t)nz * m_size + nx;
+                    if (m_stamps[next] == m_stamp)
+                        continue;
+                    m_stamps[next] = m_stamp;
+                    m_dist[next] = m_dist[cell] + 1;
+                    m_queue.push_back(next);
+                }
+            }
+            return -1;
+        }
+
+    private:
+        const Grid& m_grid;
+        int m_size;
+        uint32_t m_stamp = 0;
+        std::vector<uint32_t> m_stamps;
+        std::vector<int> m_dist;
+        std::vector<size_t> m_queue;
+    };
+
+    bool open(const Grid& grid, glm::ivec2 tile)
+    {
+        return tile.x >= 0 && tile.y >= 0 && tile.x < grid.getSize() && tile.y < grid.getSize() && !grid.wall(tile.x, tile.y);
+    }
+
+    //MovingAI scenario: "version 1" then bucket map width height startX startY goalX goalY optimal
+    bool readScen(const std::string& path, const Grid& grid, Bfs& bfs, std::vector<Query>& queries, int& skipped)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cout << "Failed to open " << path << "\n";
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream in(line);
+            int bucket, width, height;
+            std::string map;
+            glm::ivec2 start, goal;
+            if (!(in >> bucket >> map >> width >> height >> start.x >> start.y >> goal.x >> goal.y))
+                continue;
+            int cost = -1;
+            if (open(grid, start) && open(grid, goal) && start != goal)
+                cost = bfs.distance(start, goal);
+            if (cost < 0)
+            {
+                skipped++;
+                continue;
+            }
+            queries.push_back({ start, goal, cost });
+        }
+        return true;
+    }
+
+    void randomQueries(Grid& grid, Bfs& bfs, int count, uint64_t seed, std::vector<Query>& queries, int& skipped)
+    {
+        std::mt19937 rng((uint32_t)seed);
+        FreeCells& cells = grid.freeCells();
+        if (cells.count() < 2)
+            return;
+        //a pair in different rooms is drawn again, a map split in many pieces just costs more draws
+        for (int i = 0; i < count && skipped < count * 16; i++)
+        {
+            glm::ivec2 start, goal;
+            cells.sample(rng, start);
+            cells.sample(rng, goal);
+            int cost = start == goal ? -1 : bfs.distance(start, goal);
+            if (cost < 0)
+            {
+                skipped++;
+                i--;
+                continue;
+            }
+            queries.push_back({ start, goal, cost });
+        }
+    }
+
+    //one goal, starts anywhere, every edit flips a cell no query of the session starts or ends on
+    std::vector<a_Star::SessionQuery> randomSession(Grid& grid, std::mt19937& rng)
+    {
+        std::vector<a_Star::SessionQuery> session(SESSION_LENGTH);
+        FreeCells& cells = grid.freeCells();
+        glm::ivec2 goal;
+        cells.sample(rng, goal);
+        for (a_Star::SessionQuery& query : session)
+        {
+            query.goal = goal;
+            cells.sample(rng, query.start);
+        }
+        const int size = grid.getSize();
+        for (a_Star::SessionQuery& query : session)
+        {
+            glm::ivec2 cell((int)(rng() % size), (int)(rng() % size));
+            bool used = std::any_of(session.begin(), session.end(),
+                [cell](const a_Star::SessionQuery& q) { return q.start == cell || q.goal == cell; });
+            if (!used)
+                query.wallEdits.push_back(glm::ivec3(cell.x, cell.y, grid.wall(cell.x, cell.y) ? 0 : 1));
+        }
+        return session;
+    }
+
+    Percentiles percentiles(std::vector<double>& values)
+    {
+        Percentiles p;
+        if (values.empty())
+            return p;
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (double v : values)
+        {
+            sum += v;
+        }
+        //nearest rank
+        auto rank = [&values](double q) {
+            size_t i = (size_t)std::ceil(q * values.size());
+            return values[std::min(values.size(), std::max<size_t>(i, 1)) - 1];
+            };
+        p.mean = sum / values.size();
+        p.p50 = rank(0.5);
+        p.p90 = rank(0.9);
+        p.p99 = rank(0.99);
+        p.max = values.back();
+        return p;
+    }
+
+    int pathCost(const Query& query, const std::vector<glm::vec2>& path)
+    {
+        //the ends are bridged so paths with or without the start and goal tiles compare the same
+        auto manhattan = [](glm::vec2 a, glm::vec2 b) { return std::abs(a.x - b.x) + std::abs(a.y - b.y); };
+        double cost = manhattan(glm::vec2(query.start), path.front()) + manhattan(path.back(), glm::vec2(query.goal));
+        for (size_t i = 1; i < path.size(); i++)
+        {
+            cost += manhattan(path[i - 1], path[i]);
+        }
+        return (int)std::lround(cost);
+    }
+
+    Report run(const Engine& engine, Grid& grid, const std::vector<Query>& queries)
+    {
+        using Clock = std::chrono::steady_clock;
+        Report report;
+        report.engine = engine.name;
+        report.scored = engine.kind != Engine::ANY_ANGLE && engine.unitSize == 1;
+        double baseMb = residentMb();
+        auto begin = Clock::now();
+        Runner runner = engine.make(grid);
+        report.buildMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+        std::vector<double> ns, expanded, heapOps;
+        ns.reserve(queries.size());
+        double ratioSum = 0.0;
+        Result result;
+        for (const Query& query : queries)
+        {
+            result.expanded = -1;
+            result.heapOps = -1;
+            begin = Clock::now();
+            runner(query, result);
+            ns.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+            if (result.expanded >= 0)
+                expanded.push_back((double)result.expanded);
+            if (result.heapOps >= 0)
+                heapOps.push_back((double)result.heapOps);
+
+            if (result.path.empty())
+            {
+                report.missed++;
+                continue;
+            }
+            report.found++;
+            if (!report.scored)
+                continue;
+            double ratio = (double)pathCost(query, result.path) / query.cost;
+            ratioSum += ratio;
+            report.worstRatio = std::max(report.worstRatio, ratio);
+            if (ratio <= 1.0)
+                report.optimal++;
+        }
+        report.memoryMb = std::max(0.0, peakRssMb() - baseMb);
+        report.meanRatio = report.found > 0 ? ratioSum / report.found : 0.0;
+        report.ns = percentiles(ns);
+        report.hasExpanded = !expanded.empty();
+        report.expanded = percentiles(expanded);
+        report.hasHeapOps = !heapOps.empty();
+        report.heapOps = percentiles(heapOps);
+        return report;
+    }
+
+    //one engine in a child process, so its peak memory is its own
+    Report runIsolated(const Engine& engine, Grid& grid, const std::vector<Query>& queries)
+    {
+#ifdef _WIN32
+        return run(engine, grid, queries);
+#else
+        static_assert(std::is_trivially_copyable_v<Report>, "reports come back through a pipe");
+        int fds[2];
+        std::cout.flush();
+        if (pipe(fds) != 0)
+            return run(engine, grid, queries);
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            close(fds[0]);
+            close(fds[1]);
+            return run(engine, grid, queries);
+        }
+        if (pid == 0)
+        {
+            close(fds[0]);
+            Report report = run(engine, grid, queries);
+            std::cout.flush();
+            bool sent = write(fds[1], &report, sizeof(report)) == (ssize_t)sizeof(report);
+            _exit(sent ? 0 : 1);
+        }
+
+        close(fds[1]);
+        Report report;
+        size_t got = 0;
+        while (got < sizeof(report))
+        {
+            ssize_t n = read(fds[0], (char*)&report + got, sizeof(report) - got);
+            if (n <= 0)
+                break;
+            got += (size_t)n;
+        }
+        close(fds[0]);
+        waitpid(pid, nullptr, 0);
+        if (got != sizeof(report))
+        {
+            std::cout << "Engine " << engine.name << " died, counted as missing every query\n";
+            report = Report();
+            report.engine = engine.name;
+            report.missed = (int)queries.size();
+        }
+        return report;
+#endif
+    }
+
+    void printReports(const MapRun& run)
+    {
+        std::cout << run.map << (run.scen.empty() ? "" : " + " + run.scen) << ": " << run.size << "x" << run.size << ", "
+            << run.queries << " queries, " << run.skipped << " unreachable or invalid pairs skipped\n";
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-12s %9s %8s %10s %10s %10s %10s %10s %9s %6s %6s %7s %7s\n",
+            "engine", "build ms", "peak MB", "mean ns", "p50 ns", "p90 ns", "p99 ns", "expanded", "heap ops", "found", "optim", "cost", "worst");
+        std::cout << line;
+        for (const Report& r : run.reports)
+        {
+            std::string expanded = r.hasExpanded ? std::to_string((long long)r.expanded.mean) : "-";
+            std::string heapOps = r.hasHeapOps ? std::to_string((long long)r.heapOps.mean) : "-";
+            char optimal[16] = "-", cost[16] = "-", worst[16] = "-";
+            if (r.scored)
+            {
+                std::snprintf(optimal, sizeof(optimal), "%d", r.optimal);
+                std::snprintf(cost, sizeof(cost), "%.3f", r.meanRatio);
+                std::snprintf(worst, sizeof(worst), "%.3f", r.worstRatio);
+            }
+            std::snprintf(line, sizeof(line), "%-12s %9.1f %8.1f %10.0f %10.0f %10.0f %10.0f %10s %9s %6d %6s %7s %7s\n",
+                r.engine, r.buildMs, r.memoryMb, r.ns.mean, r.ns.p50, r.ns.p90, r.ns.p99,
+                expanded.c_str(), heapOps.c_str(), r.found, optimal, cost, worst);
+            std::cout << line;
+        }
+        if (run.sessions > 0)
+        {
+            const a_Star::SessionReport& s = run.sessionReport;
+            std::cout << run.sessions << " sessions, " << s.queries << " queries: plain expanded " << s.plainExpanded
+                << ", adaptive " << s.adaptiveExpanded << " ("
+                << (s.plainExpanded > 0 ? (double)s.adaptiveExpanded / s.plainExpanded : 0.0) << " of plain)\n";
+        }
+        std::cout << "\n";
+    }
+
+    std::string jsonString(const std::string& s)
+    {
+        std::string out = "\"";
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    void writePercentiles(std::ostream& out, const char* name, const Percentiles& p, bool valid)
+    {
+        out << "\"" << name << "\": ";
+        if (!valid)
+        {
+            out << "null";
+            return;
+        }
+        out << "{ \"mean\": " << p.mean << ", \"p50\": " << p.p50 << ", \"p90\": " << p.p90
+            << ", \"p99\": " << p.p99 << ", \"max\": " << p.max << " }";
+    }
+
+    void writeJson(std::ostream& out, const std::vector<MapRun>& runs, double peakMb)
+    {
+        out << "{\n  \"peakRssMb\": " << peakMb << ",\n  \"maps\": [";
+        for (size_t m = 0; m < runs.size(); m++)
+        {
+            const MapRun& run = runs[m];
+            out << (m ? "," : "") << "\n    {\n      \"map\": " << jsonString(run.map) << ",\n      \"scen\": "
+                << (run.scen.empty() ? "null" : jsonString(run.scen)) << ",\n      \"size\": " << run.size
+                << ",\n      \"queries\": " << run.queries << ",\n      \"skipped\": " << run.skipped << ",\n      \"engines\": [";
+            for (size_t e = 0; e < run.reports.size(); e++)
+            {
+                const Report& r = run.reports[e];
+                out << (e ? "," : "") << "\n        { \"engine\": " << jsonString(r.engine) << ", \"buildMs\": " << r.buildMs
+                    << ", \"peakMemoryMb\": " << r.memoryMb << ", \"found\": " << r.found << ", \"missed\": " << r.missed;
+                if (r.scored)
+                {
+                    out << ", \"optimal\": " << r.optimal << ", \"meanCostRatio\": " << r.meanRatio
+                        << ", \"worstCostRatio\": " << r.worstRatio;
+                }
+                else
+                {
+                    out << ", \"optimal\": null, \"meanCostRatio\": null, \"worstCostRatio\": null";
+                }
+                out << ",\n          ";
+                writePercentiles(out, "ns", r.ns, run.queries > 0);
+                out << ",\n          ";
+                writePercentiles(out, "expanded", r.expanded, r.hasExpanded);
+                out << ",\n          ";
+                writePercentiles(out, "heapOps", r.heapOps, r.hasHeapOps);
+                out << " }";
+            }
+            out << "\n      ],\n      \"sessions\": ";
+            if (run.sessions > 0)
+            {
+                out << "{ \"count\": " << run.sessions << ", \"queries\": " << run.sessionReport.queries
+                    << ", \"plainExpanded\": " << run.sessionReport.plainExpanded
+                    << ", \"adaptiveExpanded\": " << run.sessionReport.adaptiveExpanded << " }";
+            }
+            else
+            {
+                out << "null";
+            }
+            out << "\n    }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    void usage()
+    {
+        std::cout << "usage: bench_pathfinding <map> [--scen <file.scen>] [<map> [--scen <file.scen>]]...\n"
+            << "                         [--queries n] [--seed s] [--engines a,b,...] [--sessions n] [--json <out|->]\n"
+            << "engines:";
+        for (const Engine& engine : bench::engines())
+        {
+            std::cout << " " << engine.name;
+        }
+        std::cout << "\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    struct Input
+    {
+        std::string map;
+        std::string scen;
+    };
+    std::vector<Input> inputs;
+    std::vector<std::string> selected;
+    std::string jsonPath;
+    int queryCount = 1000;
+    int sessionCount = 0;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--scen" && hasValue && !inputs.empty())
+            inputs.back().scen = argv[++i];
+        else if (arg == "--queries" && hasValue)
+            queryCount = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--engines" && hasValue)
+        {
+            std::stringstream list(argv[++i]);
+            std::string name;
+            while (std::getline(list, name, ','))
+            {
+                selected.push_back(name);
+            }
+        }
+        else if (arg == "--sessions" && hasValue)
+            sessionCount = std::atoi(argv[++i]);
+        else if (arg == "--json" && hasValue)
+            jsonPath = argv[++i];
+        else if (arg.rfind("--", 0) != 0)
+            inputs.push_back({ arg, "" });
+        else
+        {
+            std::cout << "Unknown argument " << arg << "\n";
+            usage();
+            return 1;
+        }
+    }
+    if (inputs.empty() || queryCount <= 0 || sessionCount < 0)
+    {
+        usage();
+        return 1;
+    }
+
+    std::vector<Engine> chosen;
+    for (const Engine& engine : bench::engines())
+    {
+        bool wanted = selected.empty() ? std::string(engine.name) != "legacy"
+            : std::find(selected.begin(), selected.end(), engine.name) != selected.end();
+        if (wanted)
+            chosen.push_back(engine);
+    }
+    if (chosen.size() != selected.size() && !selected.empty())
+    {
+        std::cout << "Unknown engine in --engines\n";
+        usage();
+        return 1;
+    }
+
+    //json on stdout goes alone, the tables and anything an engine logs go to stderr then
+    std::streambuf* stdoutBuffer = std::cout.rdbuf();
+    if (jsonPath == "-")
+        std::cout.rdbuf(std::cerr.rdbuf());
+    std::vector<MapRun> runs;
+    for (const Input& input : inputs)
+    {
+        Grid grid(1.0f, "");
+        if (!grid.loadFromFile(input.map))
+            return 1;
+
+        MapRun run;
+        run.map = input.map;
+        run.scen = input.scen;
+        run.size = grid.getSize();
+        std::vector<Query> queries;
+        {
+            Bfs bfs(grid);
+            if (!input.scen.empty())
+            {
+                if (!readScen(input.scen, grid, bfs, queries, run.skipped))
+                    return 1;
+            }
+            else
+            {
+                randomQueries(grid, bfs, queryCount, seed, queries, run.skipped);
+            }
+        }
+        run.queries = (int)queries.size();
+        if (queries.empty())
+        {
+            std::cout << input.map << ": no reachable queries\n";
+            continue;
+        }
+
+        for (const Engine& engine : chosen)
+        {
+            run.reports.push_back(runIsolated(engine, grid, queries));
+        }
+
+        //last, the edits stay on the grid
+        if (sessionCount > 0 && grid.freeCells().count() >= 2)
+        {
+            std::mt19937 rng((uint32_t)seed);
+            for (int i = 0; i < sessionCount; i++)
+            {
+                a_Star::SessionReport report = a_Star::replaySession(grid, randomSession(grid, rng));
+                run.sessionReport.queries += report.queries;
+                run.sessionReport.plainExpanded += report.plainExpanded;
+                run.sessionReport.adaptiveExpanded += report.adaptiveExpanded;
+            }
+            run.sessions = sessionCount;
+        }
+        printReports(run);
+        runs.push_back(std::move(run));
+    }
+    std::cout << "peak rss " << peakRssMb() << " MB\n";
+
+    if (jsonPath.empty())
+        return 0;
+    if (jsonPath == "-")
+    {
+        std::cout.rdbuf(stdoutBuffer);
+        writeJson(std::cout, runs, peakRssMb());
+        return 0;
+    }
+    std::ofstream json(jsonPath);
+    if (!json)
+    {
+        std::cout << "Failed to write " << jsonPath << "\n";
+        return 1;
+    }
+    writeJson(json, runs, peakRssMb());
+    return 0;
+}
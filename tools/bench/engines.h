@@ -0,0 +1,261 @@
+#pragma once
+#include "grid.h"
+#include "aStar.h"
+#include "navMesh.h"
+#include "deadEnds.h"
+#include "quadTree.h"
+#include "pathPlanner.h"
+#include "layeredSearch.h"
+#include "realTimeSearch.h"
+#include "gridVersions.h"
+#include "clearance.h"
+
+#include <vector>
+#include <memory>
+#include <functional>
+
+//every search engine behind one call, shared by bench_pathfinding and path_fuzz.
+//engines with state follow wall edits through the grid's journal
+namespace bench
+{
+    struct Query
+    {
+        glm::ivec2 start;
+        glm::ivec2 goal;
+        //reference step count, -1 when there is no way
+        int cost;
+        //every goal of a multi goal query, goal is the nearest of them. Empty for a single goal,
+        //engines that take one goal just go to goal
+        std::vector<glm::ivec2> goals;
+    };
+
+    struct Result
+    {
+        std::vector<glm::vec2> path;
+        long long expanded = -1;
+        long long heapOps = -1;
+    };
+
+    using Runner = std::function<void(const Query& query, Result& result)>;
+
+    struct Engine
+    {
+        enum Kind
+        {
+            GRID,       //4-connected tile steps, shortest
+            ANY_ANGLE,  //tile space waypoints with a clear line between them, not always shortest
+            WALK        //real time agent, valid steps but no promise on length or arrival
+        };
+
+        const char* name;
+        Kind kind;
+        //builds the engine, everything it needs lives in the returned runner
+        std::function<Runner(Grid& grid)> make;
+        //side of the square the unit covers, its top left tile is the one at start and goal
+        int unitSize = 1;
+    };
+
+    //tells an engine about the wall edits on the active floor for as long as the handle lives,
+    //they arrive on GridJournal::flush. Keep the handle in the runner
+    inline std::shared_ptr<void> followWalls(Grid& grid, std::function<void(int x, int z)> onWallChanged)
+    {
+        int id = grid.journal().subscribe([&grid, onWallChanged](const std::vector<GridJournal::DirtyRect>& rects, uint64_t) {
+            for (const GridJournal::DirtyRect& rect : rects)
+            {
+                if (rect.layer != grid.activeLayer())
+                    continue;
+                for (int z = rect.z0; z <= rect.z1; z++)
+                {
+                    for (int x = rect.x0; x <= rect.x1; x++)
+                    {
+                        onWallChanged(x, z);
+                    }
+                }
+            }
+            });
+        return std::shared_ptr<void>(nullptr, [&grid, id](void*) { grid.journal().unsubscribe(id); });
+    }
+
+    inline std::vector<Engine> engines()
+    {
+        using a_Star::AdaptiveSearch;
+        return {
+            { "astar", Engine::GRID, [](Grid& grid) -> Runner {
+                auto search = std::make_shared<AdaptiveSearch>(grid);
+                search->setLearning(false);
+                auto walls = followWalls(grid, [search](int x, int z) { search->onWallChanged(x, z); });
+                return [search, walls](const Query& q, Result& r) {
+                    r.path = search->findPath(q.start, q.goal);
+                    r.expanded = search->lastExpanded();
+                    r.heapOps = search->lastHeapOps();
+                    };
+                } },
+            { "adaptive", Engine::GRID, [](Grid& grid) -> Runner {
+                auto search = std::make_shared<AdaptiveSearch>(grid);
+                auto walls = followWalls(grid, [search](int x, int z) { search->onWallChanged(x, z); });
+                return [search, walls](const Query& q, Result& r) {
+                    r.path = search->findPath(q.start, q.goal);
+                    r.expanded = search->lastExpanded();
+                    r.heapOps = search->lastHeapOps();
+                    };
+                } },
+            { "sparse", Engine::GRID, [](Grid& grid) -> Runner {
+                auto search = std::make_shared<AdaptiveSearch>(grid);
+                search->setLearning(false);
+                search->setBackend(AdaptiveSearch::Backend::SPARSE);
+                auto walls = followWalls(grid, [search](int x, int z) { search->onWallChanged(x, z); });
+                return [search, walls](const Query& q, Result& r) {
+                    r.path = search->findPath(q.start, q.goal);
+                    r.expanded = search->lastExpanded();
+                    r.heapOps = search->lastHeapOps();
+                    };
+                } },
+            { "pruned", Engine::GRID, [](Grid& grid) -> Runner {
+                auto navMesh = std::make_shared<NavMesh>(grid);
+                auto deadEnds = std::make_shared<DeadEnds>(*navMesh);
+                auto search = std::make_shared<AdaptiveSearch>(grid);
+                search->setLearning(false);
+                search->setPruning(deadEnds.get());
+                auto walls = followWalls(grid, [navMesh, deadEnds, search](int x, int z) {
+                    navMesh->onWallChanged(x, z);
+                    deadEnds->onWallChanged(x, z);
+                    search->onWallChanged(x, z);
+                    });
+                return [navMesh, deadEnds, search, walls](const Query& q, Result& r) {
+                    r.path = search->findPath(q.start, q.goal);
+                    r.expanded = search->lastExpanded();
+                    r.heapOps = search->lastHeapOps();
+                    };
+                } },
+            //learns on every other query and prunes the rest, pruned searches lean on h learned unpruned
+            { "learnpruned", Engine::GRID, [](Grid& grid) -> Runner {
+                auto navMesh = std::make_shared<NavMesh>(grid);
+                auto deadEnds = std::make_shared<DeadEnds>(*navMesh);
+                auto search = std::make_shared<AdaptiveSearch>(grid);
+                auto queries = std::make_shared<long long>(0);
+                auto walls = followWalls(grid, [navMesh, deadEnds, search](int x, int z) {
+                    navMesh->onWallChanged(x, z);
+                    deadEnds->onWallChanged(x, z);
+                    search->onWallChanged(x, z);
+                    });
+                return [navMesh, deadEnds, search, queries, walls](const Query& q, Result& r) {
+                    search->setPruning((*queries)++ % 2 ? deadEnds.get() : nullptr);
+                    r.path = search->findPath(q.start, q.goal);
+                    r.expanded = search->lastExpanded();
+                    r.heapOps = search->lastHeapOps();
+                    };
+                } },
+            { "sized", Engine::GRID, [](Grid& grid) -> Runner {
+                auto clearance = std::make_shared<ClearanceMap>(grid);
+                auto search = std::make_shared<AdaptiveSearch>(grid);
+                search->setClearance(clearance.get());
+                auto walls = followWalls(grid, [clearance, search](int x, int z) {
+                    clearance->onWallChanged(x, z);
+                    search->onWallChanged(x, z);
+                    });
+                return [clearance, search, walls](const Query& q, Result& r) {
+                    r.path = search->findPath(q.start, q.goal, 2);
+                    r.expanded = search->lastExpanded();
+                    r.heapOps = search->lastHeapOps();
+                    };
+                }, 2 },
+            //takes every goal of a multi goal query
+            { "nearest", Engine::GRID, [](Grid& grid) -> Runner {
+                auto search = std::make_shared<a_Star::NearestSearch>(grid);
+                auto goals = std::make_shared<std::vector<glm::vec2>>();
+                return [search, goals](const Query& q, Result& r) {
+                    goals->assign(q.goals.begin(), q.goals.end());
+                    if (goals->empty())
+                        goals->push_back(q.goal);
+                    search->findNearest(q.start, *goals, r.path);
+                    r.expanded = search->lastExpanded();
+                    r.heapOps = search->lastHeapOps();
+                    };
+                } },
+            { "snapshot", Engine::GRID, [](Grid& grid) -> Runner {
+                auto versions = std::make_shared<GridVersions>(grid);
+                auto search = std::make_shared<a_Star::SnapshotSearch>(*versions);
+                //the edits go out as one version before the next query
+                auto walls = followWalls(grid, [&grid, versions](int x, int z) { versions->setWall(x, z, grid.wall(x, z)); });
+                return [versions, search, walls](const Query& q, Result& r) {
+                    versions->publish();
+                    r.path = search->findPath(q.start, q.goal);
+                    r.expanded = search->lastExpanded();
+                    r.heapOps = search->lastHeapOps();
+                    };
+                } },
+            { "navmesh", Engine::ANY_ANGLE, [](Grid& grid) -> Runner {
+                auto navMesh = std::make_shared<NavMesh>(grid);
+                auto walls = followWalls(grid, [navMesh](int x, int z) { navMesh->onWallChanged(x, z); });
+                return [navMesh, walls](const Query& q, Result& r) {
+                    r.path = navMesh->findPath(q.start, q.goal);
+                    };
+                } },
+            { "planner", Engine::ANY_ANGLE, [](Grid& grid) -> Runner {
+                auto navMesh = std::make_shared<NavMesh>(grid);
+                auto planner = std::make_shared<PathPlanner>(grid, *navMesh);
+                auto walls = followWalls(grid, [navMesh, planner](int x, int z) {
+                    navMesh->onWallChanged(x, z);
+                    planner->onWallChanged(x, z);
+                    });
+                return [navMesh, planner, walls](const Query& q, Result& r) {
+                    r.path = planner->findPath(q.start, q.goal);
+                    };
+                } },
+            { "quadtree", Engine::ANY_ANGLE, [](Grid& grid) -> Runner {
+                auto tree = std::make_shared<QuadTree>(grid);
+                auto walls = followWalls(grid, [tree](int x, int z) { tree->onWallChanged(x, z); });
+                return [tree, walls](const Query& q, Result& r) {
+                    r.path = tree->findPath(q.start, q.goal);
+                    };
+                } },
+            { "layered", Engine::GRID, [](Grid& grid) -> Runner {
+                auto search = std::make_shared<LayeredSearch>(grid);
+                int layer = grid.activeLayer();
+                //portal distances are redone once before the next query, not per cell
+                auto dirty = std::make_shared<bool>(false);
+                auto walls = followWalls(grid, [dirty](int, int) { *dirty = true; });
+                return [search, layer, dirty, walls](const Query& q, Result& r) {
+                    if (*dirty)
+                        search->build();
+                    *dirty = false;
+                    r.path.clear();
+                    for (const LayeredSearch::Step& step : search->findPath(layer, q.start, layer, q.goal))
+                    {
+                        r.path.push_back(step.tile);
+                    }
+                    };
+                } },
+            { "realtime", Engine::WALK, [](Grid& grid) -> Runner {
+                auto search = std::make_shared<RealTimeSearch>(grid);
+                auto walls = followWalls(grid, [search](int x, int z) { search->onWallChanged(x, z); });
+                return [search, walls](const Query& q, Result& r) {
+                    //walks the agent, a walk much longer than optimal counts as a miss
+                    RealTimeSearch::Agent agent;
+                    agent.tile = q.start;
+                    agent.goal = q.goal;
+                    r.path.assign(1, agent.tile);
+                    r.expanded = 0;
+                    const int maxSteps = q.cost * 16 + 256;
+                    while ((int)r.path.size() <= maxSteps)
+                    {
+                        bool planning = agent.plan.empty() || agent.planGoal != agent.goal;
+                        if (!search->advance(agent))
+                            break;
+                        if (planning)
+                            r.expanded += search->lastExpanded();
+                        r.path.push_back(agent.tile);
+                    }
+                    //standing on the goal from the start is no walk
+                    if (agent.tile != agent.goal || r.path.size() < 2)
+                        r.path.clear();
+                    };
+                } },
+            { "legacy", Engine::GRID, [](Grid& grid) -> Runner {
+                return [&grid](const Query& q, Result& r) {
+                    r.path = a_Star::findPath(grid, q.start, q.goal);
+                    };
+                } },
+        };
+    }
+}
@@ -0,0 +1,122 @@
+#include "chunkedWorld.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+/*
+    Walks agents over a chunk file with a bounded number of resident chunks and reports paging.
+    Every agent plans a route to a random entrance tile, takes one step per tick and refines more of the
+    route when fewer than a chunk's worth of tiles are left, then picks the next goal.
+    usage: chunk_walk <chunks> [--resident n] [--agents n] [--ticks n] [--radius n] [--no-read-ahead]
+*/
+
+namespace
+{
+    struct Walker
+    {
+        glm::ivec2 tile;
+        ChunkedWorld::Route route;
+        size_t step = 0;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    std::string path;
+    int resident = 64;
+    int agents = 4;
+    int ticks = 20000;
+    int radius = 32;
+    bool readAhead = true;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--resident" && hasValue)
+            resident = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--agents" && hasValue)
+            agents = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--ticks" && hasValue)
+            ticks = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--radius" && hasValue)
+            radius = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--no-read-ahead")
+            readAhead = false;
+        else
+            path = arg;
+    }
+    if (path.empty())
+    {
+        std::cout << "usage: chunk_walk <chunks> [--resident n] [--agents n] [--ticks n] [--radius n] [--no-read-ahead]\n";
+        return 1;
+    }
+
+    ChunkedWorld world;
+    if (!world.open(path, resident))
+        return 1;
+    if (!readAhead)
+        world.setReadAhead(0);
+    std::cout << world.size() << "x" << world.size() << " in " << world.chunkCount() << " chunks of " << world.chunkSize()
+        << ", " << world.nodeCount() << " entrances, " << resident << " resident\n";
+
+    if (world.nodeCount() == 0)
+    {
+        std::cout << "The map is a single chunk\n";
+        return 1;
+    }
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<int> pick(0, world.nodeCount() - 1);
+    auto randomOpen = [&]() {
+        return world.entrance(pick(rng));
+        };
+
+    std::vector<Walker> walkers(agents);
+    for (Walker& w : walkers)
+    {
+        w.tile = randomOpen();
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto begin = Clock::now();
+    long long routes = 0, steps = 0, failed = 0;
+    const int refine = 2;
+    std::vector<glm::ivec2> focus;
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        focus.clear();
+        for (Walker& w : walkers)
+        {
+            if (w.step + 1 >= w.route.path.size() && w.route.pending.empty())
+            {
+                if (!world.findRoute(w.tile, randomOpen(), w.route, refine))
+                {
+                    failed++;
+                    w.route = ChunkedWorld::Route();
+                    continue;
+                }
+                w.step = 0;
+                routes++;
+            }
+            if (w.route.path.size() - w.step < (size_t)world.chunkSize() && !w.route.pending.empty())
+            {
+                world.refineMore(w.route, refine);
+            }
+            if (w.step + 1 < w.route.path.size())
+            {
+                w.tile = glm::ivec2(w.route.path[++w.step]);
+                steps++;
+            }
+            focus.push_back(w.tile);
+        }
+        world.update(focus, radius);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::cout << ticks << " ticks, " << routes << " routes (" << failed << " unreachable), " << steps << " steps in " << seconds << " s\n";
+    world.printStats();
+    return 0;
+}
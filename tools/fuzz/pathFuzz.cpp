@@ -0,0 +1,732 @@
+#include "engines.h"
+#include "grid.h"
+#include "distanceTable.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+
+/*
+    Differential fuzzer for the search engines.
+        path_fuzz [--seed s] [--maps n] [--queries n] [--max-size n] [--edits n] [--engines a,b,...] [--out dir]
+        path_fuzz --replay <map> sx sz gx gz [gx gz]... [--engines a,b,...]
+    Every round draws a map (1 to --max-size tiles a side, not always square so Grid pads it,
+    random walls plus wall lines with a few gaps so parts get cut off) and --queries start/goal
+    pairs: mostly floor tiles, some on walls, on the map border, out of the map or equal.
+    Every fourth query has 2 to 4 goals, nearest takes them all and the rest go to the nearest one.
+    On every other map --edits (default 2) random tiles flip before each query, Grid::setWall and a
+    journal flush tell the engines, and every query is checked against the map as it is then.
+    Half the queries there go to the goal of the one before, so learned h carries over the edits.
+    The engines are built once per map and answer the queries in order, like they would in game.
+
+    Every answer is checked against a dijkstra over the text rows, not over Grid:
+        no path when there is no way, the start or goal is blocked or outside
+        grid engines: 4-connected steps over floor from start to goal, exactly as many as dijkstra
+        sized: the same for its 2x2 unit, the whole square on floor at every step and a dijkstra for that square
+        any angle engines: starts at start, ends at goal, nothing but floor under every segment
+        realtime: when it arrives, only valid steps on the way
+    A failure is replayed with a freshly built engine on the same map and query, if that fails too
+    the map is shrunk: borders are cropped and walls cleared as long as the failure stays.
+    DistanceTable ("table" in --engines) is checked on every map too, all query starts against all
+    goals next to a BFS from every start.
+    The result goes to <out>/fail_<n>.txt (default the working directory), a text map with the
+    query in a # line, run it again with --replay. Exits with 1 when anything failed.
+*/
+
+namespace
+{
+    using bench::Query;
+    using bench::Result;
+    using bench::Runner;
+    using bench::Engine;
+
+    struct Options
+    {
+        uint64_t seed = 1;
+        int maps = 500;
+        int queries = 40;
+        int maxSize = 40;
+        int edits = 2;
+        std::string out = ".";
+        std::vector<std::string> engines;
+    };
+
+    //rows of 'x' and '-', what Grid::loadFromLines reads
+    using Map = std::vector<std::string>;
+
+    int mapWidth(const Map& map) { return map.empty() ? 0 : (int)map[0].size(); }
+    int mapHeight(const Map& map) { return (int)map.size(); }
+
+    bool blocked(const Map& map, glm::ivec2 tile)
+    {
+        return tile.x < 0 || tile.y < 0 || tile.x >= mapWidth(map) || tile.y >= mapHeight(map) || map[tile.y][tile.x] == 'x';
+    }
+
+    //a unit of unitSize x unitSize tiles with its top left on tile doesn't fit
+    bool blocked(const Map& map, glm::ivec2 tile, int unitSize)
+    {
+        for (int dz = 0; dz < unitSize; dz++)
+        {
+            for (int dx = 0; dx < unitSize; dx++)
+            {
+                if (blocked(map, tile + glm::ivec2(dx, dz)))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    //unit cost dijkstra, the reference every engine is held to
+    int reference(const Map& map, glm::ivec2 start, glm::ivec2 goal, int unitSize)
+    {
+        if (blocked(map, start, unitSize) || blocked(map, goal, unitSize))
+            return -1;
+        int width = mapWidth(map);
+        std::vector<int> dist((size_t)width * mapHeight(map), -1);
+        using QueueItem = std::pair<int, int>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> open;
+        dist[start.y * width + start.x] = 0;
+        open.push({ 0, start.y * width + start.x });
+        const int dx[4] = { 1, -1, 0, 0 };
+        const int dz[4] = { 0, 0, 1, -1 };
+        while (!open.empty())
+        {
+            auto [d, cell] = open.top();
+            open.pop();
+            if (d > dist[cell])
+                continue;
+            glm::ivec2 tile(cell % width, cell / width);
+            if (tile == goal)
+                return d;
+            for (int i = 0; i < 4; i++)
+            {
+                glm::ivec2 next(tile.x + dx[i], tile.y + dz[i]);
+                if (blocked(map, next, unitSize))
+                    continue;
+                int nextCell = next.y * width + next.x;
+                if (dist[nextCell] >= 0 && dist[nextCell] <= d + 1)
+                    continue;
+                dist[nextCell] = d + 1;
+                open.push({ d + 1, nextCell });
+            }
+        }
+        return -1;
+    }
+
+    Map randomMap(std::mt19937& rng, int maxSize)
+    {
+        std::uniform_int_distribution<int> sizeDist(1, maxSize);
+        int width = sizeDist(rng);
+        //every other map is square
+        int height = rng() % 2 ? width : sizeDist(rng);
+        float density = std::uniform_real_distribution<float>(0.0f, 0.6f)(rng);
+        Map map(height, std::string(width, '-'));
+        for (std::string& row : map)
+        {
+            for (char& c : row)
+            {
+                if (std::uniform_real_distribution<float>(0.0f, 1.0f)(rng) < density)
+                    c = 'x';
+            }
+        }
+        //whole wall lines with 0 to 2 gaps split the map into rooms and pockets
+        int lines = rng() % 4;
+        for (int i = 0; i < lines; i++)
+        {
+            bool horizontal = rng() % 2;
+            int length = horizontal ? width : height;
+            int at = rng() % (horizontal ? height : width);
+            for (int j = 0; j < length; j++)
+            {
+                (horizontal ? map[at][j] : map[j][at]) = 'x';
+            }
+            int gaps = rng() % 3;
+            for (int g = 0; g < gaps; g++)
+            {
+                int j = rng() % length;
+                (horizontal ? map[at][j] : map[j][at]) = '-';
+            }
+        }
+        return map;
+    }
+
+    glm::ivec2 randomTile(const Map& map, std::mt19937& rng)
+    {
+        int width = mapWidth(map), height = mapHeight(map);
+        int size = std::max(width, height);
+        int roll = rng() % 20;
+        //outside the map, or inside the square Grid pads a narrow map to
+        if (roll == 0)
+        {
+            int side = rng() % 4;
+            int along = rng() % size;
+            glm::ivec2 edges[4] = { { -1, along }, { size, along }, { along, -1 }, { along, size } };
+            return edges[side];
+        }
+        if (roll == 1)
+            return glm::ivec2(rng() % size, rng() % size);
+        if (roll <= 4)
+        {
+            int along = rng() % std::max(width, height);
+            glm::ivec2 edges[4] = { { 0, along % height }, { width - 1, along % height }, { along % width, 0 }, { along % width, height - 1 } };
+            return edges[rng() % 4];
+        }
+        //mostly floor, any tile when the map has none
+        glm::ivec2 tile(rng() % width, rng() % height);
+        for (int tries = 0; tries < 16 && blocked(map, tile); tries++)
+        {
+            tile = glm::ivec2(rng() % width, rng() % height);
+        }
+        return tile;
+    }
+
+    bool loadMap(Grid& grid, const Map& map)
+    {
+        return grid.loadFromLines(map);
+    }
+
+    //a point on a cell border is fine if any cell it touches is floor
+    bool floorAt(const Map& map, glm::vec2 p)
+    {
+        const float eps = 1e-3f;
+        for (int i = 0; i < 4; i++)
+        {
+            float x = p.x + (i & 1 ? eps : -eps);
+            float z = p.y + (i & 2 ? eps : -eps);
+            if (!blocked(map, glm::ivec2((int)std::floor(x + 0.5f), (int)std::floor(z + 0.5f))))
+                return true;
+        }
+        return false;
+    }
+
+    bool clearSegment(const Map& map, glm::vec2 a, glm::vec2 b)
+    {
+        int steps = std::max(1, (int)std::ceil(glm::length(b - a) * 16.0f));
+        for (int i = 0; i <= steps; i++)
+        {
+            if (!floorAt(map, a + (b - a) * ((float)i / steps)))
+                return false;
+        }
+        return true;
+    }
+
+    std::string describe(glm::vec2 p)
+    {
+        std::ostringstream out;
+        out << "(" << p.x << ", " << p.y << ")";
+        return out.str();
+    }
+
+    //empty when the answer is right, what is wrong otherwise
+    std::string check(const Map& map, const Engine& engine, const Query& query, const std::vector<glm::vec2>& path)
+    {
+        if (query.cost < 0)
+            return path.empty() ? "" : "path of " + std::to_string(path.size()) + " points where there is no way";
+        if (query.start == query.goal)
+        {
+            for (glm::vec2 p : path)
+            {
+                if (glm::ivec2(p) != query.start)
+                    return "start is the goal but the path leaves it";
+            }
+            return "";
+        }
+        if (path.empty())
+            return engine.kind == Engine::WALK ? "" : "no path, dijkstra cost " + std::to_string(query.cost);
+
+        for (glm::vec2 p : path)
+        {
+            if (!std::isfinite(p.x) || !std::isfinite(p.y))
+                return "non finite waypoint";
+        }
+
+        if (engine.kind == Engine::ANY_ANGLE)
+        {
+            if (glm::length(path.front() - glm::vec2(query.start)) > 1e-3f)
+                return "starts at " + describe(path.front());
+            if (glm::length(path.back() - glm::vec2(query.goal)) > 1e-3f)
+                return "ends at " + describe(path.back());
+            for (size_t i = 1; i < path.size(); i++)
+            {
+                if (!clearSegment(map, path[i - 1], path[i]))
+                    return "segment " + describe(path[i - 1]) + " - " + describe(path[i]) + " crosses a wall";
+            }
+            return "";
+        }
+
+        //grid paths may leave out the start or goal tile
+        std::vector<glm::ivec2> steps;
+        for (glm::vec2 p : path)
+        {
+            if (p != glm::floor(p))
+                return "waypoint " + describe(p) + " is not a tile";
+            steps.push_back(glm::ivec2(p));
+        }
+        //a multi goal query may end on any of its goals, the cost still has to be the nearest one's
+        glm::ivec2 goal = query.goal;
+        if (std::find(query.goals.begin(), query.goals.end(), steps.back()) != query.goals.end())
+            goal = steps.back();
+        if (steps.front() != query.start)
+            steps.insert(steps.begin(), query.start);
+        if (steps.back() != goal)
+            steps.push_back(goal);
+        for (size_t i = 0; i < steps.size(); i++)
+        {
+            if (blocked(map, steps[i], engine.unitSize))
+                return "steps on blocked tile " + describe(steps[i]);
+            if (i > 0 && std::abs(steps[i].x - steps[i - 1].x) + std::abs(steps[i].y - steps[i - 1].y) != 1)
+                return "jump from " + describe(steps[i - 1]) + " to " + describe(steps[i]);
+        }
+        int cost = (int)steps.size() - 1;
+        if (engine.kind == Engine::GRID && cost != query.cost)
+            return "cost " + std::to_string(cost) + ", dijkstra " + std::to_string(query.cost);
+        return "";
+    }
+
+    //fresh grid and engine, one query
+    std::string runFresh(const Map& map, const Engine& engine, const Query& query)
+    {
+        Grid grid(1.0f, "");
+        if (!loadMap(grid, map))
+            return "";
+        Runner runner = engine.make(grid);
+        Result result;
+        runner(query, result);
+        return check(map, engine, query, result.path);
+    }
+
+    //goal is the nearest of goals when there are several, a bigger unit only takes the first
+    Query makeQuery(const Map& map, glm::ivec2 start, const std::vector<glm::ivec2>& goals, int unitSize = 1)
+    {
+        Query query = { start, goals[0], reference(map, start, goals[0], unitSize) };
+        if (goals.size() < 2 || unitSize > 1)
+            return query;
+        for (size_t i = 1; i < goals.size(); i++)
+        {
+            int cost = reference(map, start, goals[i], 1);
+            if (cost >= 0 && (query.cost < 0 || cost < query.cost))
+            {
+                query.goal = goals[i];
+                query.cost = cost;
+            }
+        }
+        query.goals = goals;
+        return query;
+    }
+
+    //the same start and goals moved by shift, on another map
+    Query remake(const Map& map, const Query& query, glm::ivec2 shift, int unitSize)
+    {
+        std::vector<glm::ivec2> goals = query.goals.empty() ? std::vector<glm::ivec2>{ query.goal } : query.goals;
+        for (glm::ivec2& goal : goals)
+        {
+            goal += shift;
+        }
+        return makeQuery(map, query.start + shift, goals, unitSize);
+    }
+
+    //crops borders and clears walls for as long as the engine keeps failing
+    void shrink(Map& map, Query& query, const Engine& engine)
+    {
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            //left, right, top, bottom
+            for (int side = 0; side < 4; side++)
+            {
+                while (mapWidth(map) > 1 && mapHeight(map) > 1)
+                {
+                    Map cropped = map;
+                    glm::ivec2 shift(side == 0 ? -1 : 0, side == 2 ? -1 : 0);
+                    if (side < 2)
+                    {
+                        for (std::string& row : cropped)
+                        {
+                            row.erase(side == 0 ? 0 : row.size() - 1, 1);
+                        }
+                    }
+                    else
+                    {
+                        cropped.erase(side == 2 ? cropped.begin() : cropped.end() - 1);
+                    }
+                    //queries outside the map stay outside
+                    glm::ivec2 start = query.start + shift, goal = query.goal + shift;
+                    bool startInside = !(query.start.x < 0 || query.start.y < 0 || query.start.x >= mapWidth(map) || query.start.y >= mapHeight(map));
+                    bool goalInside = !(query.goal.x < 0 || query.goal.y < 0 || query.goal.x >= mapWidth(map) || query.goal.y >= mapHeight(map));
+                    if ((startInside && blocked(cropped, start) && !blocked(map, query.start)) || (goalInside && blocked(cropped, goal) && !blocked(map, query.goal)))
+                        break;
+                    Query next = remake(cropped, query, shift, engine.unitSize);
+                    if (runFresh(cropped, engine, next).empty())
+                        break;
+                    map = cropped;
+                    query = next;
+                    changed = true;
+                }
+            }
+            for (int z = 0; z < mapHeight(map); z++)
+            {
+                for (int x = 0; x < mapWidth(map); x++)
+                {
+                    if (map[z][x] != 'x')
+                        continue;
+                    map[z][x] = '-';
+                    Query next = remake(map, query, glm::ivec2(0), engine.unitSize);
+                    if (runFresh(map, engine, next).empty())
+                    {
+                        map[z][x] = 'x';
+                        continue;
+                    }
+                    query = next;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    void printMap(const Map& map, const Query& query)
+    {
+        for (int z = 0; z < mapHeight(map); z++)
+        {
+            std::string row = map[z];
+            for (int x = 0; x < mapWidth(map); x++)
+            {
+                if (glm::ivec2(x, z) == query.start)
+                    row[x] = 'S';
+                else if (glm::ivec2(x, z) == query.goal)
+                    row[x] = 'G';
+            }
+            std::cout << "    " << row << "\n";
+        }
+    }
+
+    bool writeFailure(const std::string& path, const Map& map, const Query& query, const std::string& engine, const std::string& error)
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            std::cout << "Failed to write " << path << "\n";
+            return false;
+        }
+        file << "# path_fuzz " << engine << ": " << error << "\n";
+        file << "# --replay " << path << " " << query.start.x << " " << query.start.y;
+        for (glm::ivec2 goal : query.goals.empty() ? std::vector<glm::ivec2>{ query.goal } : query.goals)
+        {
+            file << " " << goal.x << " " << goal.y;
+        }
+        file << "\n";
+        for (const std::string& row : map)
+        {
+            file << row << "\n";
+        }
+        return true;
+    }
+
+    bool readMap(const std::string& path, Map& map)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cout << "Failed to open " << path << "\n";
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty() || line[0] == '#')
+                continue;
+            map.push_back(line);
+        }
+        return !map.empty();
+    }
+
+    int replay(const std::string& path, glm::ivec2 start, const std::vector<glm::ivec2>& goals, const std::vector<Engine>& engines)
+    {
+        Map map;
+        if (!readMap(path, map))
+            return 1;
+        Query query = makeQuery(map, start, goals);
+        std::cout << "dijkstra cost " << query.cost << "\n";
+        printMap(map, query);
+        int failed = 0;
+        for (const Engine& engine : engines)
+        {
+            std::string error = runFresh(map, engine, engine.unitSize == 1 ? query : makeQuery(map, start, { query.goal }, engine.unitSize));
+            std::cout << engine.name << ": " << (error.empty() ? "ok" : error) << "\n";
+            failed += !error.empty();
+        }
+        return failed ? 1 : 0;
+    }
+
+    //BFS steps from start to every tile of the map, -1 where there is no way
+    std::vector<int> distances(const Map& map, glm::ivec2 start)
+    {
+        int width = mapWidth(map);
+        std::vector<int> dist((size_t)width * mapHeight(map), -1);
+        if (blocked(map, start))
+            return dist;
+        std::vector<glm::ivec2> queue = { start };
+        dist[start.y * width + start.x] = 0;
+        const glm::ivec2 steps[4] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            glm::ivec2 tile = queue[head];
+            for (glm::ivec2 step : steps)
+            {
+                glm::ivec2 next = tile + step;
+                if (blocked(map, next) || dist[next.y * width + next.x] >= 0)
+                    continue;
+                dist[next.y * width + next.x] = dist[tile.y * width + tile.x] + 1;
+                queue.push_back(next);
+            }
+        }
+        return dist;
+    }
+
+    //DistanceTable from every query start to every goal, the number of wrong entries
+    int checkTable(const Map& map, const std::vector<Query>& queries, int threads, int round, long long& checked, bool report)
+    {
+        std::vector<glm::vec2> sources, targets;
+        for (const Query& query : queries)
+        {
+            sources.push_back(glm::vec2(query.start));
+            targets.push_back(glm::vec2(query.goal));
+        }
+        Grid grid(1.0f, "");
+        if (!loadMap(grid, map))
+            return 0;
+        DistanceTable table;
+        table.compute(grid, sources, targets, threads);
+
+        int failed = 0;
+        for (size_t i = 0; i < queries.size(); i++)
+        {
+            std::vector<int> dist = distances(map, queries[i].start);
+            for (size_t j = 0; j < queries.size(); j++)
+            {
+                glm::ivec2 goal = queries[j].goal;
+                int want = blocked(map, goal) ? -1 : dist[goal.y * mapWidth(map) + goal.x];
+                int got = table.at((int)i, (int)j);
+                checked++;
+                if (got == (want < 0 ? DistanceTable::UNREACHABLE : want))
+                    continue;
+                if (report && failed == 0)
+                {
+                    std::cout << "table, map " << round << " (" << mapWidth(map) << "x" << mapHeight(map) << "), "
+                        << describe(queries[i].start) << " -> " << describe(goal) << ": " << got << ", bfs " << want << "\n";
+                    printMap(map, queries[i]);
+                }
+                failed++;
+            }
+        }
+        return failed;
+    }
+
+    void usage()
+    {
+        std::cout << "usage: path_fuzz [--seed s] [--maps n] [--queries n] [--max-size n] [--edits n] [--engines a,b,...] [--out dir]\n"
+            << "       path_fuzz --replay <map> sx sz gx gz [gx gz]... [--engines a,b,...]\n"
+            << "engines:";
+        for (const Engine& engine : bench::engines())
+        {
+            std::cout << " " << engine.name;
+        }
+        std::cout << " table\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    std::string replayPath;
+    glm::ivec2 replayStart(0);
+    std::vector<glm::ivec2> replayGoals;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seed" && hasValue)
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--maps" && hasValue)
+            options.maps = std::atoi(argv[++i]);
+        else if (arg == "--queries" && hasValue)
+            options.queries = std::atoi(argv[++i]);
+        else if (arg == "--max-size" && hasValue)
+            options.maxSize = std::atoi(argv[++i]);
+        else if (arg == "--edits" && hasValue)
+            options.edits = std::atoi(argv[++i]);
+        else if (arg == "--out" && hasValue)
+            options.out = argv[++i];
+        else if (arg == "--engines" && hasValue)
+        {
+            std::stringstream list(argv[++i]);
+            std::string name;
+            while (std::getline(list, name, ','))
+            {
+                options.engines.push_back(name);
+            }
+        }
+        else if (arg == "--replay" && i + 5 < argc)
+        {
+            replayPath = argv[++i];
+            replayStart.x = std::atoi(argv[++i]);
+            replayStart.y = std::atoi(argv[++i]);
+            //one goal, then more pairs for a multi goal query
+            do
+            {
+                glm::ivec2 goal;
+                goal.x = std::atoi(argv[++i]);
+                goal.y = std::atoi(argv[++i]);
+                replayGoals.push_back(goal);
+            } while (i + 2 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0);
+        }
+        else
+        {
+            std::cout << "Unknown argument " << arg << "\n";
+            usage();
+            return 1;
+        }
+    }
+    if (options.maps <= 0 || options.queries <= 0 || options.maxSize < 1 || options.edits < 0)
+    {
+        usage();
+        return 1;
+    }
+
+    std::vector<Engine> engines;
+    for (const Engine& engine : bench::engines())
+    {
+        if (options.engines.empty() || std::find(options.engines.begin(), options.engines.end(), engine.name) != options.engines.end())
+            engines.push_back(engine);
+    }
+    bool table = options.engines.empty() || std::find(options.engines.begin(), options.engines.end(), "table") != options.engines.end();
+    if (!options.engines.empty() && engines.size() + table != options.engines.size())
+    {
+        std::cout << "Unknown engine in --engines\n";
+        usage();
+        return 1;
+    }
+
+    if (!replayPath.empty())
+        return replay(replayPath, replayStart, replayGoals, engines);
+
+    //only the first few failures of an engine are shrunk, the rest are counted
+    const int maxReports = 3;
+    std::vector<long long> checked(engines.size(), 0);
+    std::vector<int> failures(engines.size(), 0);
+    long long tableChecked = 0;
+    int tableFailures = 0;
+    int written = 0;
+    std::mt19937 rng((uint32_t)options.seed);
+    for (int round = 0; round < options.maps; round++)
+    {
+        Map map = randomMap(rng, options.maxSize);
+        //the map as every query sees it and the tiles flipped right before it
+        int edits = round % 2 ? options.edits : 0;
+        std::vector<Map> states;
+        std::vector<std::vector<glm::ivec2>> flips(options.queries);
+        std::vector<Query> queries;
+        Map state = map;
+        for (int i = 0; i < options.queries; i++)
+        {
+            for (int k = 0; k < edits; k++)
+            {
+                glm::ivec2 tile(rng() % mapWidth(state), rng() % mapHeight(state));
+                char& c = state[tile.y][tile.x];
+                c = c == 'x' ? '-' : 'x';
+                flips[i].push_back(tile);
+            }
+            glm::ivec2 start = randomTile(state, rng);
+            std::vector<glm::ivec2> goals = { rng() % 10 == 0 ? start : randomTile(state, rng) };
+            //with edits half the queries chase the last goal again, what learned h is kept for
+            if (edits > 0 && i > 0 && rng() % 2)
+                goals[0] = queries.back().goal;
+            if (rng() % 4 == 0)
+            {
+                int more = 1 + rng() % 3;
+                for (int g = 0; g < more; g++)
+                {
+                    goals.push_back(randomTile(state, rng));
+                }
+            }
+            queries.push_back(makeQuery(state, start, goals));
+            states.push_back(state);
+        }
+
+        Grid grid(1.0f, "");
+        for (size_t e = 0; e < engines.size(); e++)
+        {
+            const Engine& engine = engines[e];
+            //every engine starts on the map before the edits
+            if (!loadMap(grid, map))
+                return 1;
+            Runner runner = engine.make(grid);
+            Result result;
+            for (size_t i = 0; i < queries.size(); i++)
+            {
+                const Map& current = states[i];
+                for (glm::ivec2 tile : flips[i])
+                {
+                    grid.setWall(tile.x, tile.y, current[tile.y][tile.x] == 'x');
+                }
+                grid.journal().flush();
+
+                //a bigger unit has its own reference
+                const Query& mapQuery = queries[i];
+                Query query = engine.unitSize == 1 ? mapQuery : makeQuery(current, mapQuery.start, { mapQuery.goal }, engine.unitSize);
+                runner(query, result);
+                checked[e]++;
+                std::string error = check(current, engine, query, result.path);
+                if (error.empty())
+                    continue;
+                if (++failures[e] > maxReports)
+                    continue;
+
+                std::cout << engine.name << ", map " << round << " (" << mapWidth(current) << "x" << mapHeight(current) << "), "
+                    << describe(query.start) << " -> " << describe(query.goal) << ": " << error << "\n";
+                Map small = current;
+                Query smallQuery = query;
+                if (runFresh(current, engine, query).empty())
+                {
+                    std::cout << "  only after the earlier queries and edits on this map, not shrunk\n";
+                }
+                else
+                {
+                    shrink(small, smallQuery, engine);
+                    std::cout << "  shrunk to " << mapWidth(small) << "x" << mapHeight(small) << ": "
+                        << runFresh(small, engine, smallQuery) << "\n";
+                }
+                printMap(small, smallQuery);
+                std::string path = options.out + "/fail_" + std::to_string(written++) + ".txt";
+                if (writeFailure(path, small, smallQuery, engine.name, error))
+                    std::cout << "  written to " << path << "\n";
+            }
+        }
+
+        if (table)
+            tableFailures += checkTable(map, queries, 1 + round % 3, round, tableChecked, tableFailures < maxReports);
+    }
+
+    int failed = 0;
+    for (size_t e = 0; e < engines.size(); e++)
+    {
+        std::cout << engines[e].name << ": " << checked[e] << " queries, " << failures[e] << " failed\n";
+        failed += failures[e];
+    }
+    if (table)
+    {
+        std::cout << "table: " << tableChecked << " distances, " << tableFailures << " wrong\n";
+        failed += tableFailures;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,115 @@
+#include "grid.h"
+#include "chunkedWorld.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/*
+    Converts text grids to the binary map format and measures loading.
+        map_convert <map.txt>... -o <out.gmap>   every text file is one or more floors, like loadFromFiles
+        map_convert <map> --chunks n -o <out>    chunk file for ChunkedWorld, n a multiple of 64, first floor only
+        map_convert --stat <map>                 load time, time to read every wall and peak rss
+    --stat takes text or binary maps, run it once per format since peak rss is per process.
+*/
+
+namespace
+{
+    double peakRssMb()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0.0;
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+        return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+    }
+
+    int stat(const std::string& path)
+    {
+        using Clock = std::chrono::steady_clock;
+        auto begin = Clock::now();
+        Grid grid(1.0f, "");
+        if (!grid.loadFromFile(path))
+            return 1;
+        double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+        begin = Clock::now();
+        long long walls = 0;
+        for (int layer = 0; layer < grid.layerCount(); layer++)
+        {
+            for (int z = 0; z < grid.getSize(); z++)
+            {
+                for (int x = 0; x < grid.getSize(); x++)
+                {
+                    walls += grid.wall(layer, x, z);
+                }
+            }
+        }
+        double scanMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+        std::cout << path << ": " << grid.getSize() << "x" << grid.getSize() << ", " << grid.layerCount() << " floors, "
+            << walls << " walls\n";
+        std::cout << "load " << loadMs << " ms, wall scan " << scanMs << " ms, peak rss " << peakRssMb() << " MB\n";
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> inputs;
+    std::string output;
+    int chunkSize = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--stat" && i + 1 < argc)
+            return stat(argv[++i]);
+        else if (arg == "--chunks" && i + 1 < argc)
+            chunkSize = std::atoi(argv[++i]);
+        else if (arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else
+            inputs.push_back(arg);
+    }
+    if (inputs.empty() || output.empty())
+    {
+        std::cout << "usage: map_convert <map.txt>... -o <out.gmap>\n"
+            << "       map_convert <map> --chunks n -o <out>\n"
+            << "       map_convert --stat <map>\n";
+        return 1;
+    }
+
+    Grid grid(1.0f, "");
+    if (chunkSize > 0)
+    {
+        if (inputs.size() != 1 || !grid.loadFromFile(inputs[0]) || !ChunkedWorld::write(grid, chunkSize, output))
+            return 1;
+        std::cout << "Wrote " << output << ": " << grid.getSize() << "x" << grid.getSize() << " in chunks of " << chunkSize << "\n";
+        return 0;
+    }
+    if (!grid.loadFromFiles(inputs) || !grid.saveBinary(output))
+        return 1;
+    std::cout << "Wrote " << output << ": " << grid.getSize() << "x" << grid.getSize() << ", " << grid.layerCount() << " floors, "
+        << grid.portals().size() << " portals\n";
+    return 0;
+}
@@ -0,0 +1,405 @@
+#include "grid.h"
+#include "textMap.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+/*
+    Generates maps for benchmarks.
+        map_gen <maze|rooms|random|caves> --size n [--height h] [--seed s] [--density d]
+                [--room n] [--steps n] [--threads n] -o <out>
+    The output format follows the extension: .map is MovingAI, .gmap is binary, anything else our text grid.
+
+    Every kind is split into rows or bands whose randomness only depends on the seed and the
+    row or band index, so the same seed gives the same map whatever --threads is.
+        maze    sidewinder perfect maze with corridors one tile wide, every maze row carves on its own
+        rooms   one room per --room sized sector (default 32), linked to the sectors right and below
+        random  every cell is a wall with probability --density (default 0.3)
+        caves   random fill at --density (default 0.45) then --steps (default 5) rounds of the
+                4-5 cellular automaton, wall when at least 5 of the 3x3 block are walls, 64 cells a word
+*/
+
+namespace
+{
+    struct Options
+    {
+        std::string kind;
+        int width = 1024;
+        int height = 0;
+        uint64_t seed = 1;
+        float density = -1.0f;
+        int room = 32;
+        int steps = 5;
+        int threads = 0;
+        std::string output;
+    };
+
+    //walls as height rows of words 64 cell words, like TextMap
+    struct Bits
+    {
+        int width = 0;
+        int height = 0;
+        int words = 0;
+        std::vector<uint64_t> bits;
+
+        uint64_t* row(int z) { return &bits[(size_t)z * words]; }
+        bool wall(int x, int z) const { return (bits[(size_t)z * words + (x >> 6)] >> (x & 63)) & 1; }
+        void open(int x, int z) { bits[(size_t)z * words + (x >> 6)] &= ~(1ull << (x & 63)); }
+        //inclusive, corners in any order
+        void openRect(int x0, int z0, int x1, int z1)
+        {
+            for (int z = std::min(z0, z1); z <= std::max(z0, z1); z++)
+            {
+                for (int x = std::min(x0, x1); x <= std::max(x0, x1); x++)
+                {
+                    open(x, z);
+                }
+            }
+        }
+        //bits past the width stay clear, like the text reader leaves them
+        uint64_t usedMask(int w) const
+        {
+            int left = width - w * 64;
+            return left >= 64 ? ~0ull : (1ull << left) - 1;
+        }
+    };
+
+    uint64_t mix(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    //small per row or band generator, seeded from the map seed and the index only
+    struct Random
+    {
+        uint64_t state;
+        Random(uint64_t seed, uint64_t index) : state(mix(seed ^ mix(index))) {}
+        uint64_t next() { return state = mix(state); }
+        //0..n-1
+        int below(int n) { return (int)(next() % (uint64_t)n); }
+    };
+
+    void parallelFor(int count, int threads, const std::function<void(int)>& body)
+    {
+        std::atomic<int> next{ 0 };
+        auto work = [&]() {
+            for (int i = next++; i < count; i = next++)
+            {
+                body(i);
+            }
+            };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++)
+        {
+            pool.emplace_back(work);
+        }
+        work();
+        for (auto& t : pool)
+        {
+            t.join();
+        }
+    }
+
+    void fill(Bits& map, float density, uint64_t seed, int threads)
+    {
+        //16 bit draws, four cells per random number
+        uint32_t threshold = (uint32_t)(std::clamp(density, 0.0f, 1.0f) * 65536.0f);
+        parallelFor(map.height, threads, [&](int z) {
+            Random random(seed, z);
+            uint64_t* row = map.row(z);
+            for (int w = 0; w < map.words; w++)
+            {
+                uint64_t word = 0;
+                for (int b = 0; b < 64; b += 4)
+                {
+                    uint64_t draws = random.next();
+                    for (int k = 0; k < 4; k++)
+                    {
+                        word |= (uint64_t)(((draws >> (16 * k)) & 0xFFFF) < threshold) << (b + k);
+                    }
+                }
+                row[w] = word & map.usedMask(w);
+            }
+            });
+    }
+
+    void maze(Bits& map, uint64_t seed, int threads)
+    {
+        std::fill(map.bits.begin(), map.bits.end(), ~0ull);
+        int cellsX = (map.width - 1) / 2;
+        int cellsZ = (map.height - 1) / 2;
+        //maze row j only writes map rows 2j and 2j + 1, north passages and its own corridor
+        parallelFor(cellsZ, threads, [&](int j) {
+            Random random(seed, j);
+            int z = 2 * j + 1;
+            int runStart = 0;
+            for (int i = 0; i < cellsX; i++)
+            {
+                map.open(2 * i + 1, z);
+                bool east = i + 1 < cellsX && (j == 0 || (random.next() & 1));
+                if (east)
+                {
+                    map.open(2 * i + 2, z);
+                    continue;
+                }
+                if (j > 0)
+                {
+                    int k = runStart + random.below(i - runStart + 1);
+                    map.open(2 * k + 1, z - 1);
+                }
+                runStart = i + 1;
+            }
+            });
+    }
+
+    void rooms(Bits& map, int sector, uint64_t seed, int threads)
+    {
+        std::fill(map.bits.begin(), map.bits.end(), ~0ull);
+        sector = std::max(sector, 8);
+        int sectorsX = std::max(1, map.width / sector);
+        int sectorsZ = std::max(1, map.height / sector);
+
+        struct Room
+        {
+            int x0, z0, x1, z1;
+            int cx, cz;
+        };
+        auto roomOf = [&](int sx, int sz) {
+            Random random(seed, (uint64_t)sz * sectorsX + sx);
+            int side = std::min(sector, std::min(map.width, map.height));
+            int w = side / 4 + random.below(std::max(1, side - 2 - side / 4));
+            int h = side / 4 + random.below(std::max(1, side - 2 - side / 4));
+            Room room;
+            room.x0 = sx * sector + 1 + random.below(std::max(1, side - 1 - w));
+            room.z0 = sz * sector + 1 + random.below(std::max(1, side - 1 - h));
+            room.x1 = std::min(room.x0 + w - 1, map.width - 1);
+            room.z1 = std::min(room.z0 + h - 1, map.height - 1);
+            room.cx = room.x0 + random.below(room.x1 - room.x0 + 1);
+            room.cz = room.z0 + random.below(room.z1 - room.z0 + 1);
+            return room;
+            };
+
+        //rooms and links to the right stay inside their band of sectors
+        parallelFor(sectorsZ, threads, [&](int sz) {
+            for (int sx = 0; sx < sectorsX; sx++)
+            {
+                Room a = roomOf(sx, sz);
+                map.openRect(a.x0, a.z0, a.x1, a.z1);
+                if (sx + 1 < sectorsX)
+                {
+                    Room b = roomOf(sx + 1, sz);
+                    map.openRect(a.cx, a.cz, b.cx, a.cz);
+                    map.openRect(b.cx, a.cz, b.cx, b.cz);
+                }
+            }
+            });
+        //links down touch two bands, even bands first so no two threads share a row
+        for (int parity = 0; parity < 2; parity++)
+        {
+            parallelFor((sectorsZ - parity) / 2, threads, [&](int i) {
+                int sz = 2 * i + parity;
+                if (sz + 1 >= sectorsZ)
+                    return;
+                for (int sx = 0; sx < sectorsX; sx++)
+                {
+                    Room a = roomOf(sx, sz);
+                    Room c = roomOf(sx, sz + 1);
+                    map.openRect(a.cx, a.cz, a.cx, c.cz);
+                    map.openRect(a.cx, c.cz, c.cx, c.cz);
+                }
+                });
+        }
+    }
+
+    void caves(Bits& map, float density, int steps, uint64_t seed, int threads)
+    {
+        fill(map, density, seed, threads);
+        Bits next = map;
+        //outside the map counts as wall, so padding bits are set while the automaton runs
+        auto word = [&](Bits& m, int z, int w) -> uint64_t {
+            if (z < 0 || z >= m.height || w < 0 || w >= m.words)
+                return ~0ull;
+            return m.bits[(size_t)z * m.words + w] | ~m.usedMask(w);
+            };
+        for (int step = 0; step < steps; step++)
+        {
+            parallelFor(map.height, threads, [&](int z) {
+                for (int w = 0; w < map.words; w++)
+                {
+                    //bit sliced count of the 3x3 block, s0..s3 are the bits of the count per cell
+                    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+                    auto add = [&](uint64_t m) {
+                        uint64_t c0 = s0 & m;
+                        s0 ^= m;
+                        uint64_t c1 = s1 & c0;
+                        s1 ^= c0;
+                        uint64_t c2 = s2 & c1;
+                        s2 ^= c1;
+                        s3 |= c2;
+                        };
+                    for (int dz = -1; dz <= 1; dz++)
+                    {
+                        uint64_t center = word(map, z + dz, w);
+                        uint64_t west = (center << 1) | (word(map, z + dz, w - 1) >> 63);
+                        uint64_t east = (center >> 1) | (word(map, z + dz, w + 1) << 63);
+                        add(west);
+                        add(center);
+                        add(east);
+                    }
+                    //count >= 5
+                    next.bits[(size_t)z * map.words + w] = (s3 | (s2 & (s1 | s0))) & map.usedMask(w);
+                }
+                });
+            std::swap(map.bits, next.bits);
+        }
+    }
+
+    //rows are formatted in parallel a block at a time and written in order
+    bool writeText(const Bits& map, bool movingAi, const std::string& path, int threads)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            std::cout << "Failed to open " << path << " for writing\n";
+            return false;
+        }
+        if (movingAi)
+            std::fprintf(file, "type octile\nheight %d\nwidth %d\nmap\n", map.height, map.width);
+
+        const char wallChar = movingAi ? '@' : 'x';
+        const char openChar = movingAi ? '.' : '-';
+        const int blockRows = std::min(map.height, std::max(1, (32 << 20) / (map.width + 1)));
+        std::vector<char> block((size_t)blockRows * (map.width + 1));
+        bool ok = true;
+        for (int z0 = 0; z0 < map.height && ok; z0 += blockRows)
+        {
+            int rows = std::min(blockRows, map.height - z0);
+            parallelFor(rows, threads, [&](int r) {
+                char* out = &block[(size_t)r * (map.width + 1)];
+                for (int x = 0; x < map.width; x++)
+                {
+                    out[x] = map.wall(x, z0 + r) ? wallChar : openChar;
+                }
+                out[map.width] = '\n';
+                });
+            size_t bytes = (size_t)rows * (map.width + 1);
+            ok = std::fwrite(block.data(), 1, bytes, file) == bytes;
+        }
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok)
+            std::cout << "Failed to write " << path << "\n";
+        return ok;
+    }
+
+    bool writeBinary(Bits& map, const std::string& path)
+    {
+        TextMap text;
+        text.width = map.width;
+        text.words = map.words;
+        text.floors.resize(1);
+        text.floors[0].height = map.height;
+        text.floors[0].bits = std::move(map.bits);
+        Grid grid(1.0f, "");
+        return grid.loadTextMap(text) && grid.saveBinary(path);
+    }
+
+    bool endsWith(const std::string& s, const std::string& suffix)
+    {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--size" && hasValue)
+            options.width = std::atoi(argv[++i]);
+        else if (arg == "--height" && hasValue)
+            options.height = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--density" && hasValue)
+            options.density = (float)std::atof(argv[++i]);
+        else if (arg == "--room" && hasValue)
+            options.room = std::atoi(argv[++i]);
+        else if (arg == "--steps" && hasValue)
+            options.steps = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)
+            options.threads = std::atoi(argv[++i]);
+        else if (arg == "-o" && hasValue)
+            options.output = argv[++i];
+        else if (options.kind.empty())
+            options.kind = arg;
+        else
+        {
+            std::cout << "Unknown argument " << arg << "\n";
+            return 1;
+        }
+    }
+    if (options.height <= 0)
+        options.height = options.width;
+    bool known = options.kind == "maze" || options.kind == "rooms" || options.kind == "random" || options.kind == "caves";
+    if (!known || options.output.empty() || options.width < 3 || options.height < 3 || options.width > 32768 || options.height > 32768)
+    {
+        std::cout << "usage: map_gen <maze|rooms|random|caves> --size n [--height h] [--seed s] [--density d]\n"
+            << "               [--room n] [--steps n] [--threads n] -o <out.txt|out.map|out.gmap>\n"
+            << "sizes go from 3 to 32768\n";
+        return 1;
+    }
+    int threads = options.threads > 0 ? options.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+
+    using Clock = std::chrono::steady_clock;
+    auto begin = Clock::now();
+    Bits map;
+    map.width = options.width;
+    map.height = options.height;
+    map.words = (map.width + 63) / 64;
+    map.bits.assign((size_t)map.height * map.words, 0);
+    if (options.kind == "maze")
+        maze(map, options.seed, threads);
+    else if (options.kind == "rooms")
+        rooms(map, options.room, options.seed, threads);
+    else if (options.kind == "random")
+        fill(map, options.density >= 0.0f ? options.density : 0.3f, options.seed, threads);
+    else
+        caves(map, options.density >= 0.0f ? options.density : 0.45f, options.steps, options.seed, threads);
+    double generateMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+    long long walls = 0;
+    for (uint64_t word : map.bits)
+    {
+        walls += std::popcount(word);
+    }
+
+    begin = Clock::now();
+    bool ok;
+    if (endsWith(options.output, ".gmap"))
+        ok = writeBinary(map, options.output);
+    else
+        ok = writeText(map, endsWith(options.output, ".map"), options.output, threads);
+    if (!ok)
+        return 1;
+    double writeMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+    std::cout << "Wrote " << options.output << ": " << options.kind << " " << options.width << "x" << options.height
+        << " seed " << options.seed << ", " << 100.0 * walls / ((double)options.width * options.height) << "% walls\n";
+    std::cout << "generate " << generateMs << " ms, write " << writeMs << " ms on " << threads << " threads\n";
+    return 0;
+}
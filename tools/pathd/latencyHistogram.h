@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <bit>
+#include <algorithm>
+
+/*
+    Latency histogram of pathd and pathd_load, HDR style: every power of two range is split into
+    SUB_BUCKETS equal steps, so a percentile is within 1 / SUB_BUCKETS of the real sample
+    (PathPlanner::Histogram only keeps the power of two, up to 2x off). Fixed size, a pathd that runs
+    for days doesn't grow it.
+*/
+namespace pathd
+{
+    struct LatencyHistogram
+    {
+        static constexpr int SUB_BITS = 6;
+        static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+        //up to 2^MAX_BITS ns (about 18 minutes), anything longer lands in the last bucket
+        static constexpr int MAX_BITS = 40;
+        static constexpr int BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+        uint64_t buckets[BUCKETS] = {};
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+
+        //below SUB_BUCKETS every ns has its own bucket, above that a bucket is 2^shift ns wide
+        static int bucketOf(uint64_t ns)
+        {
+            if (ns < SUB_BUCKETS)
+                return (int)ns;
+            int shift = (int)std::bit_width(ns) - 1 - SUB_BITS;
+            return std::min(BUCKETS - 1, (shift + 1) * SUB_BUCKETS + (int)((ns >> shift) - SUB_BUCKETS));
+        }
+
+        void add(uint64_t ns)
+        {
+            buckets[bucketOf(ns)]++;
+            count++;
+            totalNs += ns;
+            maxNs = std::max(maxNs, ns);
+        }
+
+        void merge(const LatencyHistogram& other)
+        {
+            for (int i = 0; i < BUCKETS; i++)
+            {
+                buckets[i] += other.buckets[i];
+            }
+            count += other.count;
+            totalNs += other.totalNs;
+            maxNs = std::max(maxNs, other.maxNs);
+        }
+
+        //middle of the bucket holding the p-th fraction of the samples, 0..1
+        uint64_t percentileNs(double p) const
+        {
+            if (count == 0)
+                return 0;
+            uint64_t rank = std::clamp<uint64_t>((uint64_t)(p * count + 0.999999), 1, count);
+            uint64_t seen = 0;
+            for (int i = 0; i < BUCKETS; i++)
+            {
+                seen += buckets[i];
+                if (seen < rank)
+                    continue;
+                if (i < SUB_BUCKETS)
+                    return i;
+                int shift = i / SUB_BUCKETS - 1;
+                uint64_t low = (uint64_t)(SUB_BUCKETS + i % SUB_BUCKETS) << shift;
+                return std::min<uint64_t>(maxNs, low + ((1ull << shift) >> 1));
+            }
+            return maxNs;
+        }
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <unistd.h>
+
+/*
+    pathd wire format, native (little) endian, every message is one batch.
+    request: BatchHeader with REQUEST_MAGIC, then count Query
+    reply:   BatchHeader with REPLY_MAGIC and the same id and count, then for every query a
+             Result followed by its PathStore run words (only with FLAG_PATH)
+    A client may send any number of batches before reading, replies come back in order.
+*/
+namespace pathd
+{
+    constexpr uint32_t REQUEST_MAGIC = 0x51485450; //"PTHQ"
+    constexpr uint32_t REPLY_MAGIC = 0x52485450; //"PTHR"
+    constexpr uint32_t MAX_BATCH = 65536;
+    //send the path itself, otherwise only its length
+    constexpr uint32_t FLAG_PATH = 1;
+
+    struct BatchHeader
+    {
+        uint32_t magic;
+        uint32_t id;
+        uint32_t count;
+        uint32_t flags;
+    };
+
+    struct Query
+    {
+        int32_t sx;
+        int32_t sz;
+        int32_t gx;
+        int32_t gz;
+    };
+
+    struct Result
+    {
+        //tiles walked, negative when there is no path
+        float length;
+        uint32_t words;
+    };
+
+    inline bool readAll(int fd, void* data, size_t size)
+    {
+        char* p = static_cast<char*>(data);
+        while (size > 0)
+        {
+            ssize_t n = read(fd, p, size);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    inline bool writeAll(int fd, const void* data, size_t size)
+    {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            ssize_t n = write(fd, p, size);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,342 @@
+#include "pathProtocol.h"
+#include "latencyHistogram.h"
+#include "grid.h"
+#include "navMesh.h"
+#include "pathPlanner.h"
+#include "pathStore.h"
+#include "navCache.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <set>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+    pathd, headless path server.
+    Loads a grid, builds a navmesh and planner per worker and answers batches of path queries
+    on a unix socket. Every connection is read by its own thread which borrows a free engine
+    for the length of one batch, so pipelined batches queue up in the socket and run in order.
+    usage: pathd <map>... [--socket path] [--threads n]
+*/
+
+namespace
+{
+    volatile std::sig_atomic_t g_stop = 0;
+
+    void onSignal(int)
+    {
+        g_stop = 1;
+    }
+
+    struct Engine
+    {
+        NavMesh navMesh;
+        PathPlanner planner;
+        PathStore store;
+
+        Engine(Grid& grid, const NavCache* cache)
+            : navMesh(grid, cache)
+            , planner(grid, navMesh, cache)
+        {}
+    };
+
+    class EnginePool
+    {
+    public:
+        void add(std::unique_ptr<Engine> engine)
+        {
+            m_free.push_back(engine.get());
+            m_all.push_back(std::move(engine));
+        }
+
+        Engine* borrow()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_ready.wait(lock, [this]() { return !m_free.empty(); });
+            Engine* engine = m_free.back();
+            m_free.pop_back();
+            return engine;
+        }
+
+        void giveBack(Engine* engine)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_free.push_back(engine);
+            }
+            m_ready.notify_one();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_ready;
+        std::vector<Engine*> m_free;
+        std::vector<std::unique_ptr<Engine>> m_all;
+    };
+
+    struct Stats
+    {
+        std::mutex mutex;
+        long long batches = 0;
+        long long queries = 0;
+        long long unreachable = 0;
+        pathd::LatencyHistogram batchLatency;
+        pathd::LatencyHistogram queryLatency;
+
+        void print()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (batches == 0)
+                return;
+            std::cout << batches << " batches, " << queries << " queries (" << unreachable << " unreachable)"
+                << ", batch p50 " << batchLatency.percentileNs(0.5) / 1000.0 << " us p99 " << batchLatency.percentileNs(0.99) / 1000.0 << " us"
+                << ", query p50 " << queryLatency.percentileNs(0.5) / 1000.0 << " us p99 " << queryLatency.percentileNs(0.99) / 1000.0 << " us\n";
+        }
+    };
+
+    //open client sockets and the detached threads reading them. A socket is closed and forgotten under
+    //the lock, so closeAll never shuts down a number the kernel already handed to someone else
+    class Connections
+    {
+    public:
+        void add(int fd)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_fds.insert(fd);
+        }
+
+        //notified under the lock, closeAll may return and take the object with it right after
+        void close(int fd)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_fds.erase(fd);
+            ::close(fd);
+            m_done.notify_all();
+        }
+
+        //wake every thread out of its read and wait until they all closed their socket
+        void closeAll()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (int fd : m_fds)
+            {
+                shutdown(fd, SHUT_RDWR);
+            }
+            m_done.wait(lock, [this]() { return m_fds.empty(); });
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_done;
+        std::set<int> m_fds;
+    };
+
+    void serve(int fd, Grid& grid, EnginePool& pool, Stats& stats, Connections& connections)
+    {
+        using Clock = std::chrono::steady_clock;
+        std::vector<pathd::Query> queries;
+        std::vector<char> reply;
+        std::vector<uint64_t> queryNs;
+        const int size = grid.getSize();
+
+        pathd::BatchHeader header;
+        while (pathd::readAll(fd, &header, sizeof(header)))
+        {
+            if (header.magic != pathd::REQUEST_MAGIC || header.count > pathd::MAX_BATCH)
+            {
+                std::cout << "Bad batch header, closing connection\n";
+                break;
+            }
+            queries.resize(header.count);
+            if (!pathd::readAll(fd, queries.data(), queries.size() * sizeof(pathd::Query)))
+                break;
+
+            auto begin = Clock::now();
+            pathd::BatchHeader out = { pathd::REPLY_MAGIC, header.id, header.count, header.flags };
+            reply.assign((const char*)&out, (const char*)&out + sizeof(out));
+            queryNs.clear();
+            int unreachable = 0;
+
+            Engine* engine = pool.borrow();
+            for (const pathd::Query& q : queries)
+            {
+                auto queryBegin = Clock::now();
+                std::vector<glm::vec2> path;
+                auto inside = [size](int x, int z) { return x >= 0 && z >= 0 && x < size && z < size; };
+                if (inside(q.sx, q.sz) && inside(q.gx, q.gz))
+                    path = engine->planner.findPath(glm::vec2(q.sx, q.sz), glm::vec2(q.gx, q.gz));
+
+                pathd::Result result = { -1.0f, 0 };
+                PathStore::PathId id = PathStore::INVALID;
+                if (!path.empty())
+                {
+                    result.length = 0.0f;
+                    for (size_t i = 1; i < path.size(); i++)
+                    {
+                        result.length += glm::length(path[i] - path[i - 1]);
+                    }
+                    if (header.flags & pathd::FLAG_PATH)
+                    {
+                        id = engine->store.store(path);
+                        size_t count;
+                        engine->store.words(id, count);
+                        result.words = (uint32_t)count;
+                    }
+                }
+                else
+                {
+                    unreachable++;
+                }
+
+                reply.insert(reply.end(), (const char*)&result, (const char*)&result + sizeof(result));
+                if (id != PathStore::INVALID)
+                {
+                    size_t count;
+                    const uint16_t* words = engine->store.words(id, count);
+                    reply.insert(reply.end(), (const char*)words, (const char*)(words + count));
+                    engine->store.release(id);
+                }
+                queryNs.push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - queryBegin).count());
+            }
+            pool.giveBack(engine);
+
+            if (!pathd::writeAll(fd, reply.data(), reply.size()))
+                break;
+
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+            std::lock_guard<std::mutex> lock(stats.mutex);
+            stats.batches++;
+            stats.queries += header.count;
+            stats.unreachable += unreachable;
+            stats.batchLatency.add((uint64_t)ns);
+            for (uint64_t q : queryNs)
+            {
+                stats.queryLatency.add(q);
+            }
+        }
+        connections.close(fd);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> maps;
+    std::string socketPath = "/tmp/pathd.sock";
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc)
+            socketPath = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = std::max(1, std::atoi(argv[++i]));
+        else
+            maps.push_back(arg);
+    }
+    if (maps.empty())
+    {
+        std::cout << "usage: pathd <map>... [--socket path] [--threads n]\n";
+        return 1;
+    }
+
+    auto loadBegin = std::chrono::steady_clock::now();
+    Grid grid(1.0f, maps[0]);
+    if (maps.size() > 1)
+        grid.loadFromFiles(maps);
+    if (grid.getSize() == 0)
+        return 1;
+
+    //a matching navcache next to the first map skips the navmesh build, otherwise the first engine writes it
+    NavCache cache;
+    const std::string cachePath = NavCache::pathFor(maps[0]);
+    const bool fromCache = cache.open(cachePath, grid);
+    bool warmCache = fromCache;
+    EnginePool pool;
+    for (int i = 0; i < threads; i++)
+    {
+        auto engine = std::make_unique<Engine>(grid, warmCache ? &cache : nullptr);
+        if (i == 0 && !warmCache)
+        {
+            engine->navMesh.save(cache);
+            engine->planner.save(cache);
+            cache.write(cachePath, grid);
+            warmCache = cache.open(cachePath, grid);
+        }
+        pool.add(std::move(engine));
+    }
+    cache.close();
+    auto loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadBegin).count();
+    std::cout << "Loaded " << grid.getSize() << "x" << grid.getSize() << " grid and " << threads << " engines in " << loadMs << " ms"
+        << (fromCache ? " from navcache" : "") << "\n";
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (listenFd < 0 || socketPath.size() >= sizeof(addr.sun_path))
+    {
+        std::cout << "Failed to create socket!\n";
+        return 1;
+    }
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(socketPath.c_str());
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 64) < 0)
+    {
+        std::cout << "Failed to listen on " << socketPath << "\n";
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+    std::cout << "Listening on " << socketPath << "\n";
+
+    Stats stats;
+    Connections connections;
+    auto lastReport = std::chrono::steady_clock::now();
+    long long reported = 0;
+    while (!g_stop)
+    {
+        pollfd p = { listenFd, POLLIN, 0 };
+        if (poll(&p, 1, 1000) > 0 && (p.revents & POLLIN))
+        {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd >= 0)
+            {
+                connections.add(fd);
+                std::thread(serve, fd, std::ref(grid), std::ref(pool), std::ref(stats), std::ref(connections)).detach();
+            }
+        }
+
+        //latency every few seconds while there is traffic
+        if (std::chrono::steady_clock::now() - lastReport > std::chrono::seconds(5))
+        {
+            lastReport = std::chrono::steady_clock::now();
+            long long batches;
+            {
+                std::lock_guard<std::mutex> lock(stats.mutex);
+                batches = stats.batches;
+            }
+            if (batches != reported)
+                stats.print();
+            reported = batches;
+        }
+    }
+
+    connections.closeAll();
+    close(listenFd);
+    unlink(socketPath.c_str());
+    stats.print();
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include "pathProtocol.h"
+#include "latencyHistogram.h"
+#include "grid.h"
+#include "pathStore.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+    Load generator for pathd.
+    Every connection keeps up to depth batches in flight and measures the round trip of each
+    batch from send to reply. Query endpoints are random walkable tiles of the same map.
+    usage: pathd_load <map> [--socket path] [--batches n] [--batch n] [--depth n] [--connections n] [--paths]
+*/
+
+namespace
+{
+    struct Options
+    {
+        std::string socketPath = "/tmp/pathd.sock";
+        int batches = 1000;
+        int batchSize = 64;
+        int depth = 8;
+        int connections = 1;
+        bool paths = false;
+    };
+
+    struct Totals
+    {
+        std::mutex mutex;
+        long long queries = 0;
+        long long unreachable = 0;
+        long long pathBytes = 0;
+        long long paths = 0;
+        bool failed = false;
+        pathd::LatencyHistogram roundTrip;
+    };
+
+    void drive(const Options& options, const std::vector<glm::ivec2>& walkable, unsigned seed, Totals& totals)
+    {
+        using Clock = std::chrono::steady_clock;
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, options.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+        {
+            std::cout << "Failed to connect to " << options.socketPath << "\n";
+            std::lock_guard<std::mutex> lock(totals.mutex);
+            totals.failed = true;
+            return;
+        }
+
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<size_t> pick(0, walkable.size() - 1);
+        std::vector<char> request(sizeof(pathd::BatchHeader) + options.batchSize * sizeof(pathd::Query));
+        std::deque<std::pair<uint32_t, Clock::time_point>> inFlight;
+        std::vector<uint16_t> words;
+        PathStore store;
+        pathd::LatencyHistogram roundTrip;
+        long long unreachable = 0, pathBytes = 0, paths = 0;
+
+        uint32_t sent = 0;
+        uint32_t received = 0;
+        bool ok = true;
+        while (ok && received < (uint32_t)options.batches)
+        {
+            //keep the pipe full
+            while (sent < (uint32_t)options.batches && inFlight.size() < (size_t)options.depth)
+            {
+                pathd::BatchHeader header = { pathd::REQUEST_MAGIC, sent, (uint32_t)options.batchSize, options.paths ? pathd::FLAG_PATH : 0u };
+                std::memcpy(request.data(), &header, sizeof(header));
+                pathd::Query* queries = (pathd::Query*)(request.data() + sizeof(header));
+                for (int i = 0; i < options.batchSize; i++)
+                {
+                    glm::ivec2 a = walkable[pick(rng)];
+                    glm::ivec2 b = walkable[pick(rng)];
+                    queries[i] = { a.x, a.y, b.x, b.y };
+                }
+                inFlight.push_back({ sent, Clock::now() });
+                if (!pathd::writeAll(fd, request.data(), request.size()))
+                {
+                    ok = false;
+                    break;
+                }
+                sent++;
+            }
+            if (!ok)
+                break;
+
+            pathd::BatchHeader reply;
+            if (!pathd::readAll(fd, &reply, sizeof(reply)) || reply.magic != pathd::REPLY_MAGIC || reply.id != inFlight.front().first)
+            {
+                ok = false;
+                break;
+            }
+            for (uint32_t i = 0; i < reply.count && ok; i++)
+            {
+                pathd::Result result;
+                ok = pathd::readAll(fd, &result, sizeof(result));
+                if (!ok)
+                    break;
+                if (result.length < 0.0f)
+                    unreachable++;
+                if (result.words > 0)
+                {
+                    words.resize(result.words);
+                    ok = pathd::readAll(fd, words.data(), words.size() * sizeof(uint16_t));
+                    //decoded lazily by whoever walks it, here it is only checked and dropped
+                    PathStore::PathId id = store.adopt(words.data(), words.size());
+                    store.release(id);
+                    pathBytes += result.words * sizeof(uint16_t);
+                    paths++;
+                }
+            }
+
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - inFlight.front().second).count();
+            roundTrip.add((uint64_t)ns);
+            inFlight.pop_front();
+            received++;
+        }
+        close(fd);
+
+        std::lock_guard<std::mutex> lock(totals.mutex);
+        if (!ok)
+        {
+            std::cout << "Connection dropped after " << received << " batches\n";
+            totals.failed = true;
+        }
+        totals.queries += (long long)received * options.batchSize;
+        totals.unreachable += unreachable;
+        totals.pathBytes += pathBytes;
+        totals.paths += paths;
+        totals.roundTrip.merge(roundTrip);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    std::string map;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--socket" && hasValue)
+            options.socketPath = argv[++i];
+        else if (arg == "--batches" && hasValue)
+            options.batches = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--batch" && hasValue)
+            options.batchSize = std::clamp(std::atoi(argv[++i]), 1, (int)pathd::MAX_BATCH);
+        else if (arg == "--depth" && hasValue)
+            options.depth = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--connections" && hasValue)
+            options.connections = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--paths")
+            options.paths = true;
+        else
+            map = arg;
+    }
+    if (map.empty())
+    {
+        std::cout << "usage: pathd_load <map> [--socket path] [--batches n] [--batch n] [--depth n] [--connections n] [--paths]\n";
+        return 1;
+    }
+
+    Grid grid(1.0f, map);
+    std::vector<glm::ivec2> walkable;
+    for (int z = 0; z < grid.getSize(); z++)
+    {
+        for (int x = 0; x < grid.getSize(); x++)
+        {
+            if (!grid.wall(x, z))
+                walkable.push_back(glm::ivec2(x, z));
+        }
+    }
+    if (walkable.empty())
+    {
+        std::cout << "No walkable tiles in " << map << "\n";
+        return 1;
+    }
+
+    Totals totals;
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.connections; i++)
+    {
+        threads.emplace_back(drive, std::cref(options), std::cref(walkable), 1234u + i, std::ref(totals));
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    const pathd::LatencyHistogram& rt = totals.roundTrip;
+    std::cout << totals.queries << " queries in " << seconds << " s, " << totals.queries / seconds << " queries/s, "
+        << totals.unreachable << " unreachable\n";
+    if (rt.count > 0)
+    {
+        std::cout << "batch round trip mean " << rt.totalNs / rt.count / 1000.0 << " us, p50 " << rt.percentileNs(0.5) / 1000.0
+            << " us, p99 " << rt.percentileNs(0.99) / 1000.0 << " us, max " << rt.maxNs / 1000.0 << " us\n";
+    }
+    if (totals.paths > 0)
+        std::cout << "path payload " << (double)totals.pathBytes / totals.paths << " bytes per path\n";
+    return totals.failed ? 1 : 0;
+}
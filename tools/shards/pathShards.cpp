@@ -0,0 +1,141 @@
+#include "shardCoordinator.h"
+#include "grid.h"
+#include "distanceTable.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <csignal>
+
+/*
+    Runs random queries against a sharded map and reports throughput.
+    --check loads the whole map once in this process and compares every route with the exact
+    distance, routes must be walkable and connected, the extra length is reported.
+    usage: path_shards <map> [--shard n] [--queries n] [--batch n] [--check]
+*/
+
+namespace
+{
+    //every step moves to a 4-neighbour and no corner sits on a wall
+    bool walkable(const Grid& grid, const std::vector<glm::vec2>& path, int& length)
+    {
+        length = 0;
+        for (size_t i = 1; i < path.size(); i++)
+        {
+            glm::ivec2 a = glm::ivec2(path[i - 1]);
+            glm::ivec2 b = glm::ivec2(path[i]);
+            if (a.x != b.x && a.y != b.y)
+                return false;
+            glm::ivec2 step = glm::clamp(b - a, glm::ivec2(-1), glm::ivec2(1));
+            for (glm::ivec2 p = a; p != b; length++)
+            {
+                p += step;
+                if (grid.wall(p.x, p.y))
+                    return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string map;
+    int shardSize = 256;
+    int queryCount = 10000;
+    int batchSize = 256;
+    bool check = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--shard" && hasValue)
+            shardSize = std::max(8, std::atoi(argv[++i]));
+        else if (arg == "--queries" && hasValue)
+            queryCount = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--batch" && hasValue)
+            batchSize = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--check")
+            check = true;
+        else
+            map = arg;
+    }
+    if (map.empty())
+    {
+        std::cout << "usage: path_shards <map> [--shard n] [--queries n] [--batch n] [--check]\n";
+        return 1;
+    }
+    //a dead worker shows up as a failed write instead of killing us
+    std::signal(SIGPIPE, SIG_IGN);
+
+    using Clock = std::chrono::steady_clock;
+    auto begin = Clock::now();
+    ShardCoordinator coordinator(map, shardSize);
+    if (!coordinator.start())
+        return 1;
+    double loadSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    std::cout << coordinator.shardCount() << " shards of " << shardSize << " on a " << coordinator.mapSize() << " map, "
+        << coordinator.nodeCount() << " entrances, ready in " << loadSeconds * 1000.0 << " ms\n";
+
+    std::vector<glm::ivec2> tiles = coordinator.sample(queryCount * 2);
+    if (tiles.size() < 2)
+    {
+        std::cout << "No walkable tiles in " << map << "\n";
+        return 1;
+    }
+    std::vector<shards::RefineQuery> queries;
+    for (int i = 0; i < queryCount; i++)
+    {
+        //pair tiles from different shards most of the time
+        glm::ivec2 a = tiles[(size_t)i * 2 % tiles.size()];
+        glm::ivec2 b = tiles[((size_t)i * 7 + 1) % tiles.size()];
+        queries.push_back({ a.x, a.y, b.x, b.y });
+    }
+
+    std::vector<ShardCoordinator::Route> routes;
+    std::vector<ShardCoordinator::Route> all;
+    begin = Clock::now();
+    for (size_t first = 0; first < queries.size(); first += batchSize)
+    {
+        size_t last = std::min(queries.size(), first + batchSize);
+        std::vector<shards::RefineQuery> batch(queries.begin() + first, queries.begin() + last);
+        coordinator.query(batch, routes);
+        all.insert(all.end(), routes.begin(), routes.end());
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    int unreachable = (int)std::count_if(all.begin(), all.end(), [](const ShardCoordinator::Route& r) { return r.cost < 0; });
+    std::cout << queries.size() << " queries in " << seconds << " s, " << queries.size() / seconds << " queries/s, "
+        << unreachable << " unreachable\n";
+
+    if (!check)
+        return 0;
+
+    Grid grid(1.0f, map);
+    int bad = 0;
+    long long routeLength = 0;
+    long long bestLength = 0;
+    DistanceTable table;
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        const shards::RefineQuery& q = queries[i];
+        table.compute(grid, { glm::vec2(q.sx, q.sz) }, { glm::vec2(q.gx, q.gz) }, 1);
+        int best = table.at(0, 0);
+        const ShardCoordinator::Route& route = all[i];
+        int length = 0;
+        bool ok = (best < 0) == (route.cost < 0);
+        if (ok && best >= 0)
+        {
+            ok = walkable(grid, route.path, length) && length == route.cost && !route.path.empty()
+                && route.path.front() == glm::vec2(q.sx, q.sz) && route.path.back() == glm::vec2(q.gx, q.gz);
+            routeLength += length;
+            bestLength += best;
+        }
+        if (!ok)
+            bad++;
+    }
+    std::cout << "check: " << bad << " bad, routes " << (bestLength > 0 ? 100.0 * (routeLength - bestLength) / bestLength : 0.0)
+        << "% longer than optimal\n";
+    return bad == 0 ? 0 : 1;
+}
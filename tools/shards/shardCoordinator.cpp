@@ -0,0 +1,462 @@
+#include "shardCoordinator.h"
+#include "shardWorker.h"
+#include "pathProtocol.h"
+#include "pathStore.h"
+
+#include <iostream>
+#include <fstream>
+#include <queue>
+#include <unordered_map>
+#include <functional>
+#include <climits>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    template <typename T>
+    void append(std::vector<char>& out, const T& value)
+    {
+        out.insert(out.end(), (const char*)&value, (const char*)&value + sizeof(T));
+    }
+}
+
+ShardCoordinator::ShardCoordinator(const std::string& mapPath, int shardSize)
+    : m_mapPath(mapPath)
+    , m_shardSize(shardSize)
+{
+}
+
+ShardCoordinator::~ShardCoordinator()
+{
+    shards::MessageHeader quit = { shards::QUIT, 0 };
+    for (Shard& shard : m_shards)
+    {
+        if (shard.fd >= 0)
+        {
+            pathd::writeAll(shard.fd, &quit, sizeof(quit));
+            close(shard.fd);
+        }
+        if (shard.pid > 0)
+            waitpid(shard.pid, nullptr, 0);
+        if (shard.mapping)
+            munmap(shard.mapping, shard.bytes);
+    }
+}
+
+bool ShardCoordinator::start()
+{
+    //only the first row is read here, maps are square like Grid expects
+    std::ifstream file(m_mapPath);
+    if (!file.is_open())
+    {
+        std::cout << "Failed to open grid file!\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line[0] != '#' && line.rfind("portal", 0) != 0)
+        {
+            m_size = (int)line.size();
+            break;
+        }
+    }
+    file.close();
+    if (m_size == 0 || m_shardSize <= 0)
+        return false;
+
+    m_columns = (m_size + m_shardSize - 1) / m_shardSize;
+    m_shards.resize(m_columns * m_columns);
+    for (int i = 0; i < (int)m_shards.size(); i++)
+    {
+        Shard& shard = m_shards[i];
+        ShardWorker::Rect rect;
+        rect.x0 = (i % m_columns) * m_shardSize;
+        rect.z0 = (i / m_columns) * m_shardSize;
+        rect.width = std::min(m_shardSize, m_size - rect.x0);
+        rect.height = std::min(m_shardSize, m_size - rect.z0);
+        shard.shmName = "/pathshard-" + std::to_string(getpid()) + "-" + std::to_string(i);
+
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+        {
+            std::cout << "socketpair failed\n";
+            return false;
+        }
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            std::cout << "fork failed\n";
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+        if (pid == 0)
+        {
+            //the worker only keeps its own end
+            close(fds[0]);
+            for (int j = 0; j < i; j++)
+            {
+                close(m_shards[j].fd);
+            }
+            ShardWorker worker(m_mapPath, rect, 1234 + i);
+            bool ok = worker.load() && worker.publish(shard.shmName);
+            shards::MessageHeader ready = { ok ? (uint32_t)shards::READY : (uint32_t)shards::FAILED, (uint32_t)worker.nodeCount() };
+            if (pathd::writeAll(fds[1], &ready, sizeof(ready)) && ok)
+                worker.serve(fds[1]);
+            close(fds[1]);
+            _exit(ok ? 0 : 1);
+        }
+        close(fds[1]);
+        shard.pid = pid;
+        shard.fd = fds[0];
+    }
+
+    //workers load in parallel, wait for all of them
+    bool ok = true;
+    for (Shard& shard : m_shards)
+    {
+        shards::MessageHeader ready;
+        if (!pathd::readAll(shard.fd, &ready, sizeof(ready)) || ready.type != shards::READY || !mapTable(shard))
+        {
+            std::cout << "Shard worker " << shard.pid << " failed to start\n";
+            ok = false;
+        }
+    }
+    if (!ok)
+        return false;
+
+    linkShards();
+    return true;
+}
+
+bool ShardCoordinator::mapTable(Shard& shard)
+{
+    int fd = shm_open(shard.shmName.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+    //nobody else needs the name once it is mapped, this also cleans up if we crash
+    shm_unlink(shard.shmName.c_str());
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(shards::TableHeader))
+    {
+        close(fd);
+        return false;
+    }
+    shard.bytes = info.st_size;
+    shard.mapping = mmap(nullptr, shard.bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shard.mapping == MAP_FAILED)
+    {
+        shard.mapping = nullptr;
+        return false;
+    }
+
+    const char* data = (const char*)shard.mapping;
+    shard.table = (const shards::TableHeader*)data;
+    int n = shard.table->nodeCount;
+    size_t expected = sizeof(shards::TableHeader) + n * sizeof(shards::BorderNode) + (size_t)n * n * sizeof(int32_t);
+    if (shard.table->magic != shards::TABLE_MAGIC || shard.bytes < expected)
+        return false;
+    shard.nodes = (const shards::BorderNode*)(data + sizeof(shards::TableHeader));
+    shard.dist = (const int32_t*)(data + sizeof(shards::TableHeader) + n * sizeof(shards::BorderNode));
+    return true;
+}
+
+void ShardCoordinator::linkShards()
+{
+    //an entrance is linked to the one that names the same two tiles the other way round
+    std::unordered_map<uint64_t, int> byTiles;
+    auto key = [&](int x, int z, int nx, int nz) {
+        return ((uint64_t)(z * m_size + x) << 32) | (uint32_t)(nz * m_size + nx);
+        };
+
+    m_nodeShard.clear();
+    for (int s = 0; s < (int)m_shards.size(); s++)
+    {
+        Shard& shard = m_shards[s];
+        shard.firstNode = (int)m_nodeShard.size();
+        for (int i = 0; i < shard.table->nodeCount; i++)
+        {
+            const shards::BorderNode& node = shard.nodes[i];
+            byTiles[key(node.x, node.z, node.nx, node.nz)] = (int)m_nodeShard.size();
+            m_nodeShard.push_back(s);
+        }
+    }
+
+    m_across.assign(m_nodeShard.size(), -1);
+    for (const Shard& shard : m_shards)
+    {
+        for (int i = 0; i < shard.table->nodeCount; i++)
+        {
+            const shards::BorderNode& node = shard.nodes[i];
+            auto it = byTiles.find(key(node.nx, node.nz, node.x, node.z));
+            if (it != byTiles.end())
+                m_across[shard.firstNode + i] = it->second;
+        }
+    }
+
+    m_g.assign(m_nodeShard.size(), 0);
+    m_parent.assign(m_nodeShard.size(), -1);
+    m_generated.assign(m_nodeShard.size(), 0);
+}
+
+int ShardCoordinator::shardAt(int x, int z) const
+{
+    if (x < 0 || z < 0 || x >= m_size || z >= m_size)
+        return -1;
+    return (z / m_shardSize) * m_columns + x / m_shardSize;
+}
+
+bool ShardCoordinator::sendAll(uint32_t type, const std::vector<std::vector<char>>& items, const std::vector<uint32_t>& counts)
+{
+    for (size_t s = 0; s < m_shards.size(); s++)
+    {
+        if (counts[s] == 0)
+            continue;
+        shards::MessageHeader header = { type, counts[s] };
+        if (!pathd::writeAll(m_shards[s].fd, &header, sizeof(header))
+            || (!items.empty() && !pathd::writeAll(m_shards[s].fd, items[s].data(), items[s].size())))
+            return false;
+    }
+    return true;
+}
+
+int ShardCoordinator::searchAbstract(int startShard, const int32_t* startDist, int direct, int goalShard, const int32_t* goalDist,
+    std::vector<int>& nodes)
+{
+    using Entry = std::pair<int, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    m_searchId++;
+    auto relax = [&](int node, int g, int parent) {
+        if (m_generated[node] == m_searchId && m_g[node] <= g)
+            return;
+        m_generated[node] = m_searchId;
+        m_g[node] = g;
+        m_parent[node] = parent;
+        open.push({ g, node });
+        };
+
+    const Shard& first = m_shards[startShard];
+    for (int i = 0; i < first.table->nodeCount; i++)
+    {
+        if (startDist[i] >= 0)
+            relax(first.firstNode + i, startDist[i], -1);
+    }
+
+    int best = direct >= 0 ? direct : INT_MAX;
+    int bestNode = -1;
+    while (!open.empty())
+    {
+        auto [g, node] = open.top();
+        open.pop();
+        if (g != m_g[node])
+            continue;
+        if (g >= best)
+            break;
+
+        int s = m_nodeShard[node];
+        const Shard& shard = m_shards[s];
+        int local = node - shard.firstNode;
+        if (s == goalShard && goalDist[local] >= 0 && g + goalDist[local] < best)
+        {
+            best = g + goalDist[local];
+            bestNode = node;
+        }
+
+        if (m_across[node] >= 0)
+            relax(m_across[node], g + 1, node);
+        int n = shard.table->nodeCount;
+        const int32_t* row = shard.dist + (size_t)local * n;
+        for (int i = 0; i < n; i++)
+        {
+            if (i != local && row[i] >= 0)
+                relax(shard.firstNode + i, g + row[i], node);
+        }
+    }
+
+    nodes.clear();
+    if (best == INT_MAX)
+        return -1;
+    for (int node = bestNode; node >= 0; node = m_parent[node])
+    {
+        nodes.push_back(node);
+    }
+    std::reverse(nodes.begin(), nodes.end());
+    return best;
+}
+
+void ShardCoordinator::query(const std::vector<shards::RefineQuery>& queries, std::vector<Route>& routes)
+{
+    const size_t shardCount = m_shards.size();
+    routes.assign(queries.size(), Route());
+
+    //round 1: distances from start and goal to the entrances of their shards
+    std::vector<std::vector<char>> items(shardCount);
+    std::vector<uint32_t> counts(shardCount, 0);
+    std::vector<int> startItem(queries.size(), -1);
+    std::vector<int> goalItem(queries.size(), -1);
+    for (size_t q = 0; q < queries.size(); q++)
+    {
+        const shards::RefineQuery& query = queries[q];
+        int s = shardAt(query.sx, query.sz);
+        int g = shardAt(query.gx, query.gz);
+        if (s < 0 || g < 0)
+            continue;
+        shards::ConnectQuery start = { query.sx, query.sz, -1, -1 };
+        if (s == g)
+        {
+            start.tx = query.gx;
+            start.tz = query.gz;
+        }
+        append(items[s], start);
+        startItem[q] = counts[s]++;
+        append(items[g], shards::ConnectQuery{ query.gx, query.gz, -1, -1 });
+        goalItem[q] = counts[g]++;
+    }
+    if (!sendAll(shards::CONNECT, items, counts))
+        return;
+
+    std::vector<std::vector<int32_t>> distances(shardCount);
+    for (size_t s = 0; s < shardCount; s++)
+    {
+        if (counts[s] == 0)
+            continue;
+        shards::MessageHeader header;
+        distances[s].resize((size_t)counts[s] * (1 + m_shards[s].table->nodeCount));
+        if (!pathd::readAll(m_shards[s].fd, &header, sizeof(header))
+            || !pathd::readAll(m_shards[s].fd, distances[s].data(), distances[s].size() * sizeof(int32_t)))
+            return;
+    }
+
+    //round 2: abstract search, the route becomes a list of segments that each stay in one shard
+    std::vector<Segment> segments;
+    std::vector<int> nodes;
+    for (size_t q = 0; q < queries.size(); q++)
+    {
+        if (startItem[q] < 0)
+            continue;
+        const shards::RefineQuery& query = queries[q];
+        int s = shardAt(query.sx, query.sz);
+        int g = shardAt(query.gx, query.gz);
+        const int32_t* startDist = distances[s].data() + (size_t)startItem[q] * (1 + m_shards[s].table->nodeCount);
+        const int32_t* goalDist = distances[g].data() + (size_t)goalItem[q] * (1 + m_shards[g].table->nodeCount);
+        int direct = s == g ? startDist[0] : -1;
+        routes[q].cost = searchAbstract(s, startDist + 1, direct, g, goalDist + 1, nodes);
+        if (routes[q].cost < 0)
+            continue;
+
+        int from = -1;
+        glm::ivec2 at(query.sx, query.sz);
+        int shard = s;
+        for (int node : nodes)
+        {
+            const Shard& owner = m_shards[m_nodeShard[node]];
+            const shards::BorderNode& border = owner.nodes[node - owner.firstNode];
+            //stepping over a shard edge needs no search
+            if (from >= 0 && m_across[from] == node)
+                segments.push_back({ (int)q, -1, { at.x, at.y, border.x, border.z } });
+            else
+                segments.push_back({ (int)q, shard, { at.x, at.y, border.x, border.z } });
+            at = glm::ivec2(border.x, border.z);
+            shard = m_nodeShard[node];
+            from = node;
+        }
+        segments.push_back({ (int)q, shard, { at.x, at.y, query.gx, query.gz } });
+    }
+
+    //round 3: refine every segment in its shard
+    for (size_t s = 0; s < shardCount; s++)
+    {
+        items[s].clear();
+        counts[s] = 0;
+    }
+    for (const Segment& segment : segments)
+    {
+        const shards::RefineQuery& t = segment.tiles;
+        if (segment.shard < 0 || (t.sx == t.gx && t.sz == t.gz))
+            continue;
+        append(items[segment.shard], t);
+        counts[segment.shard]++;
+    }
+    if (!sendAll(shards::REFINE, items, counts))
+        return;
+
+    std::vector<std::vector<std::vector<glm::vec2>>> refined(shardCount);
+    PathStore store;
+    std::vector<uint16_t> words;
+    for (size_t s = 0; s < shardCount; s++)
+    {
+        if (counts[s] == 0)
+            continue;
+        shards::MessageHeader header;
+        if (!pathd::readAll(m_shards[s].fd, &header, sizeof(header)))
+            return;
+        for (uint32_t i = 0; i < counts[s]; i++)
+        {
+            uint32_t count;
+            if (!pathd::readAll(m_shards[s].fd, &count, sizeof(count)))
+                return;
+            words.resize(count);
+            if (!pathd::readAll(m_shards[s].fd, words.data(), count * sizeof(uint16_t)))
+                return;
+            PathStore::PathId id = store.adopt(words.data(), count);
+            refined[s].push_back(store.decode(id));
+            store.release(id);
+        }
+    }
+
+    //stitch in segment order, shared corners are only kept once
+    std::vector<size_t> used(shardCount, 0);
+    for (const Segment& segment : segments)
+    {
+        const shards::RefineQuery& t = segment.tiles;
+        std::vector<glm::vec2> piece = { glm::vec2(t.sx, t.sz), glm::vec2(t.gx, t.gz) };
+        if (segment.shard >= 0 && !(t.sx == t.gx && t.sz == t.gz))
+            piece = refined[segment.shard][used[segment.shard]++];
+
+        std::vector<glm::vec2>& path = routes[segment.query].path;
+        for (glm::vec2 p : piece)
+        {
+            if (path.empty() || path.back() != p)
+                path.push_back(p);
+        }
+    }
+}
+
+std::vector<glm::ivec2> ShardCoordinator::sample(int count)
+{
+    std::vector<glm::ivec2> tiles;
+    std::vector<uint32_t> counts(m_shards.size(), 0);
+    for (int i = 0; i < count; i++)
+    {
+        counts[i % m_shards.size()]++;
+    }
+    if (!sendAll(shards::SAMPLE, {}, counts))
+        return tiles;
+
+    for (size_t s = 0; s < m_shards.size(); s++)
+    {
+        if (counts[s] == 0)
+            continue;
+        shards::MessageHeader header;
+        std::vector<shards::TilePos> reply(counts[s]);
+        if (!pathd::readAll(m_shards[s].fd, &header, sizeof(header))
+            || !pathd::readAll(m_shards[s].fd, reply.data(), reply.size() * sizeof(shards::TilePos)))
+            break;
+        for (const shards::TilePos& tile : reply)
+        {
+            if (tile.x >= 0)
+                tiles.push_back(glm::ivec2(tile.x, tile.z));
+        }
+    }
+    return tiles;
+}
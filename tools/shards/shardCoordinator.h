@@ -0,0 +1,83 @@
+#pragma once
+#include "shardProtocol.h"
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/*
+    Splits a map into square shards and forks one ShardWorker process per shard.
+    The coordinator never loads the map, it maps every worker's border table read only and
+    links entrances that face each other across a shard edge into one abstract graph.
+    A batch of queries runs in three rounds so all workers are busy at the same time:
+    connect start and goal to their shard's entrances, search the abstract graph here,
+    then refine every segment inside its own shard and stitch the corners together.
+*/
+class ShardCoordinator
+{
+public:
+    struct Route
+    {
+        //-1 when unreachable
+        int cost = -1;
+        std::vector<glm::vec2> path;
+    };
+
+    ShardCoordinator(const std::string& mapPath, int shardSize);
+    ~ShardCoordinator();
+    bool start();
+
+    void query(const std::vector<shards::RefineQuery>& queries, std::vector<Route>& routes);
+    //random walkable tiles spread evenly over the shards
+    std::vector<glm::ivec2> sample(int count);
+
+    int mapSize() const { return m_size; }
+    int shardCount() const { return (int)m_shards.size(); }
+    int nodeCount() const { return (int)m_nodeShard.size(); }
+
+private:
+    struct Shard
+    {
+        pid_t pid = -1;
+        int fd = -1;
+        std::string shmName;
+        void* mapping = nullptr;
+        size_t bytes = 0;
+        const shards::TableHeader* table = nullptr;
+        const shards::BorderNode* nodes = nullptr;
+        const int32_t* dist = nullptr;
+        int firstNode = 0;
+    };
+
+    struct Segment
+    {
+        int query;
+        int shard;
+        shards::RefineQuery tiles;
+    };
+
+    bool mapTable(Shard& shard);
+    void linkShards();
+    int shardAt(int x, int z) const;
+    //one message to every shard with items, replies are read afterwards so the workers run in parallel
+    bool sendAll(uint32_t type, const std::vector<std::vector<char>>& items, const std::vector<uint32_t>& counts);
+    //abstract graph search, fills the border nodes of the best route, returns its cost or -1
+    int searchAbstract(int startShard, const int32_t* startDist, int direct, int goalShard, const int32_t* goalDist,
+        std::vector<int>& nodes);
+
+    std::string m_mapPath;
+    int m_shardSize;
+    int m_size = 0;
+    int m_columns = 0;
+    std::vector<Shard> m_shards;
+    //per abstract node, its shard and the node across the border (-1 if that tile has no partner)
+    std::vector<int> m_nodeShard;
+    std::vector<int> m_across;
+
+    //dijkstra scratch
+    std::vector<int> m_g;
+    std::vector<int> m_parent;
+    std::vector<uint32_t> m_generated;
+    uint32_t m_searchId = 0;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+
+/*
+    Messages between the shard coordinator and its worker processes (one socketpair each),
+    and the layout of the border table every worker publishes in shared memory.
+    A worker answers one request message with one reply message, items in request order.
+*/
+namespace shards
+{
+    enum MessageType : uint32_t
+    {
+        READY = 1,
+        FAILED,
+        //item: ConnectQuery, reply: int32 distance to the extra target, then one int32 per border node
+        CONNECT,
+        //item: RefineQuery, reply: uint32 word count then PathStore words in map coordinates
+        REFINE,
+        //no items, count is the number of tiles wanted, reply: count TilePos
+        SAMPLE,
+        QUIT
+    };
+
+    struct MessageHeader
+    {
+        uint32_t type;
+        uint32_t count;
+    };
+
+    struct ConnectQuery
+    {
+        int32_t x;
+        int32_t z;
+        //extra target in the same shard, -1 for none
+        int32_t tx;
+        int32_t tz;
+    };
+
+    struct RefineQuery
+    {
+        int32_t sx;
+        int32_t sz;
+        int32_t gx;
+        int32_t gz;
+    };
+
+    struct TilePos
+    {
+        int32_t x;
+        int32_t z;
+    };
+
+    constexpr uint32_t TABLE_MAGIC = 0x54445253; //"SRDT"
+
+    //followed by nodeCount BorderNode and nodeCount * nodeCount int32 distances, -1 unreachable
+    struct TableHeader
+    {
+        uint32_t magic;
+        int32_t x0;
+        int32_t z0;
+        int32_t width;
+        int32_t height;
+        int32_t nodeCount;
+    };
+
+    //a border cell of the shard and the cell across the border it connects to, map coordinates
+    struct BorderNode
+    {
+        int32_t x;
+        int32_t z;
+        int32_t nx;
+        int32_t nz;
+    };
+}
@@ -0,0 +1,286 @@
+#include "shardWorker.h"
+#include "distanceTable.h"
+#include "pathProtocol.h"
+
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+    template <typename T>
+    void append(std::vector<char>& out, const T& value)
+    {
+        out.insert(out.end(), (const char*)&value, (const char*)&value + sizeof(T));
+    }
+}
+
+ShardWorker::ShardWorker(const std::string& mapPath, Rect rect, int seed)
+    : m_mapPath(mapPath)
+    , m_rect(rect)
+    , m_seed(seed)
+{
+}
+
+bool ShardWorker::open(int x, int z) const
+{
+    int wx = x - (m_rect.x0 - 1);
+    int wz = z - (m_rect.z0 - 1);
+    int ww = m_rect.width + 2;
+    if (wx < 0 || wz < 0 || wx >= ww || wz >= m_rect.height + 2)
+        return false;
+    return m_window[wz * ww + wx] != 0;
+}
+
+bool ShardWorker::load()
+{
+    std::ifstream file(m_mapPath);
+    if (!file.is_open())
+    {
+        std::cout << "Failed to open grid file!\n";
+        return false;
+    }
+
+    //stream the file and keep only the rows and columns of this shard and its halo
+    const int ww = m_rect.width + 2;
+    const int wh = m_rect.height + 2;
+    m_window.assign(ww * wh, 0);
+    std::string line;
+    int z = 0;
+    while (z < m_rect.z0 + m_rect.height + 1 && std::getline(file, line))
+    {
+        if (line.empty() || line.rfind("portal", 0) == 0)
+            continue;
+        //only the first floor is sharded
+        if (line[0] == '#')
+        {
+            if (z > 0)
+                break;
+            continue;
+        }
+
+        int wz = z - (m_rect.z0 - 1);
+        if (wz >= 0)
+        {
+            for (int wx = 0; wx < ww; wx++)
+            {
+                int x = m_rect.x0 - 1 + wx;
+                if (x >= 0 && x < (int)line.size() && line[x] != 'x')
+                    m_window[wz * ww + wx] = 1;
+            }
+        }
+        z++;
+    }
+
+    //grids are square, the spare part of an edge shard is wall
+    int size = std::max(m_rect.width, m_rect.height);
+    std::vector<std::string> lines(size, std::string(size, 'x'));
+    for (int lz = 0; lz < m_rect.height; lz++)
+    {
+        for (int lx = 0; lx < m_rect.width; lx++)
+        {
+            if (open(m_rect.x0 + lx, m_rect.z0 + lz))
+            {
+                lines[lz][lx] = '-';
+                m_walkable.push_back(glm::ivec2(m_rect.x0 + lx, m_rect.z0 + lz));
+            }
+        }
+    }
+    m_grid = std::make_unique<Grid>(1.0f, "");
+    if (!m_grid->loadFromLines(lines))
+        return false;
+    m_search = std::make_unique<a_Star::AdaptiveSearch>(*m_grid);
+    m_search->setLearning(false);
+
+    findEntrances();
+    return true;
+}
+
+void ShardWorker::findEntrances()
+{
+    const Rect& r = m_rect;
+    struct Edge
+    {
+        //first inside tile, step along the edge, step across it
+        int x, z;
+        int dx, dz;
+        int ox, oz;
+        int length;
+    };
+    const Edge edges[4] = {
+        { r.x0, r.z0, 1, 0, 0, -1, r.width },
+        { r.x0, r.z0 + r.height - 1, 1, 0, 0, 1, r.width },
+        { r.x0, r.z0, 0, 1, -1, 0, r.height },
+        { r.x0 + r.width - 1, r.z0, 0, 1, 1, 0, r.height },
+    };
+
+    auto addNode = [&](const Edge& e, int t) {
+        int x = e.x + e.dx * t;
+        int z = e.z + e.dz * t;
+        m_nodes.push_back({ x, z, x + e.ox, z + e.oz });
+        };
+
+    for (const Edge& e : edges)
+    {
+        int runStart = -1;
+        for (int t = 0; t <= e.length; t++)
+        {
+            int x = e.x + e.dx * t;
+            int z = e.z + e.dz * t;
+            bool crossing = t < e.length && open(x, z) && open(x + e.ox, z + e.oz);
+            if (crossing && runStart < 0)
+                runStart = t;
+            if (crossing || runStart < 0)
+                continue;
+
+            //long openings get an entrance at both ends, short ones in the middle
+            int runEnd = t - 1;
+            if (runEnd - runStart + 1 >= 6)
+            {
+                addNode(e, runStart);
+                addNode(e, runEnd);
+            }
+            else
+            {
+                addNode(e, (runStart + runEnd) / 2);
+            }
+            runStart = -1;
+        }
+    }
+}
+
+bool ShardWorker::publish(const std::string& shmName)
+{
+    const int n = (int)m_nodes.size();
+    std::vector<glm::vec2> tiles;
+    for (const shards::BorderNode& node : m_nodes)
+    {
+        tiles.push_back(glm::vec2(node.x - m_rect.x0, node.z - m_rect.z0));
+    }
+    DistanceTable table;
+    table.compute(*m_grid, tiles, tiles, 1);
+
+    size_t bytes = sizeof(shards::TableHeader) + n * sizeof(shards::BorderNode) + (size_t)n * n * sizeof(int32_t);
+    int fd = shm_open(shmName.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0 || ftruncate(fd, bytes) < 0)
+    {
+        std::cout << "Failed to create shared memory " << shmName << "\n";
+        return false;
+    }
+    char* data = (char*)mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    shards::TableHeader header = { shards::TABLE_MAGIC, m_rect.x0, m_rect.z0, m_rect.width, m_rect.height, n };
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(data + sizeof(header), m_nodes.data(), n * sizeof(shards::BorderNode));
+    int32_t* dist = (int32_t*)(data + sizeof(header) + n * sizeof(shards::BorderNode));
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            dist[i * n + j] = table.at(i, j);
+        }
+    }
+    munmap(data, bytes);
+    return true;
+}
+
+void ShardWorker::connect(const std::vector<shards::ConnectQuery>& queries, std::vector<char>& reply)
+{
+    //one table for the whole message, the extra targets sit after the border nodes
+    const int n = (int)m_nodes.size();
+    std::vector<glm::vec2> sources;
+    std::vector<glm::vec2> targets;
+    for (const shards::BorderNode& node : m_nodes)
+    {
+        targets.push_back(glm::vec2(node.x - m_rect.x0, node.z - m_rect.z0));
+    }
+    for (const shards::ConnectQuery& q : queries)
+    {
+        sources.push_back(glm::vec2(q.x - m_rect.x0, q.z - m_rect.z0));
+        targets.push_back(q.tx < 0 ? glm::vec2(-1.0f) : glm::vec2(q.tx - m_rect.x0, q.tz - m_rect.z0));
+    }
+
+    DistanceTable table;
+    table.compute(*m_grid, sources, targets, 1);
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        append(reply, (int32_t)table.at((int)i, n + (int)i));
+        for (int j = 0; j < n; j++)
+        {
+            append(reply, (int32_t)table.at((int)i, j));
+        }
+    }
+}
+
+void ShardWorker::refine(const std::vector<shards::RefineQuery>& queries, std::vector<char>& reply)
+{
+    for (const shards::RefineQuery& q : queries)
+    {
+        glm::vec2 origin(m_rect.x0, m_rect.z0);
+        std::vector<glm::vec2> path = m_search->findPath(glm::vec2(q.sx, q.sz) - origin, glm::vec2(q.gx, q.gz) - origin);
+        for (glm::vec2& p : path)
+        {
+            p += origin;
+        }
+
+        PathStore::PathId id = m_store.store(path);
+        size_t count;
+        const uint16_t* words = m_store.words(id, count);
+        append(reply, (uint32_t)count);
+        reply.insert(reply.end(), (const char*)words, (const char*)(words + count));
+        m_store.release(id);
+    }
+}
+
+void ShardWorker::sample(int count, std::vector<char>& reply)
+{
+    std::mt19937 rng(m_seed++);
+    for (int i = 0; i < count; i++)
+    {
+        shards::TilePos tile = { -1, -1 };
+        if (!m_walkable.empty())
+        {
+            glm::ivec2 t = m_walkable[std::uniform_int_distribution<size_t>(0, m_walkable.size() - 1)(rng)];
+            tile = { t.x, t.y };
+        }
+        append(reply, tile);
+    }
+}
+
+void ShardWorker::serve(int fd)
+{
+    std::vector<char> reply;
+    shards::MessageHeader header;
+    while (pathd::readAll(fd, &header, sizeof(header)) && header.type != shards::QUIT)
+    {
+        reply.clear();
+        append(reply, header);
+        if (header.type == shards::CONNECT)
+        {
+            std::vector<shards::ConnectQuery> queries(header.count);
+            if (!pathd::readAll(fd, queries.data(), queries.size() * sizeof(shards::ConnectQuery)))
+                break;
+            connect(queries, reply);
+        }
+        else if (header.type == shards::REFINE)
+        {
+            std::vector<shards::RefineQuery> queries(header.count);
+            if (!pathd::readAll(fd, queries.data(), queries.size() * sizeof(shards::RefineQuery)))
+                break;
+            refine(queries, reply);
+        }
+        else if (header.type == shards::SAMPLE)
+        {
+            sample((int)header.count, reply);
+        }
+        if (!pathd::writeAll(fd, reply.data(), reply.size()))
+            break;
+    }
+}
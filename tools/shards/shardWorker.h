@@ -0,0 +1,53 @@
+#pragma once
+#include "shardProtocol.h"
+#include "grid.h"
+#include "aStar.h"
+#include "pathStore.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+/*
+    One shard of a big map, run in its own process.
+    Only the shard's rectangle plus a one tile halo is read from the map file. Entrances are
+    runs of open tiles on both sides of a shard edge (HPA* style, long runs get one at each end),
+    both neighbours find the same ones since they look at the same tile pairs.
+    The distances between all entrances are published in a shared memory table, after that
+    the worker answers connect, refine and sample requests on its socket.
+*/
+class ShardWorker
+{
+public:
+    struct Rect
+    {
+        int x0;
+        int z0;
+        int width;
+        int height;
+    };
+
+    ShardWorker(const std::string& mapPath, Rect rect, int seed);
+    bool load();
+    bool publish(const std::string& shmName);
+    void serve(int fd);
+    int nodeCount() const { return (int)m_nodes.size(); }
+
+private:
+    bool open(int x, int z) const;
+    void findEntrances();
+    void connect(const std::vector<shards::ConnectQuery>& queries, std::vector<char>& reply);
+    void refine(const std::vector<shards::RefineQuery>& queries, std::vector<char>& reply);
+    void sample(int count, std::vector<char>& reply);
+
+    std::string m_mapPath;
+    Rect m_rect;
+    int m_seed;
+    //shard plus halo, 1 for open tiles, tiles outside the map stay closed
+    std::vector<char> m_window;
+    std::unique_ptr<Grid> m_grid;
+    std::unique_ptr<a_Star::AdaptiveSearch> m_search;
+    PathStore m_store;
+    std::vector<shards::BorderNode> m_nodes;
+    std::vector<glm::ivec2> m_walkable;
+};